@@ -0,0 +1,259 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <limits>
+#include <thread>
+
+namespace
+{
+	struct ChunkEntry
+	{
+		std::uint64_t ObjectCount;
+		std::uint64_t Size;
+	};
+
+	constexpr std::uint32_t PreserveReferencesFlag = 1;
+
+	// 依据未经验证的长度读取块时每次分配的上限
+	constexpr size_t ReadBlockSize = 1024 * 1024;
+
+	/// @brief	对每个块调用func，并行时各线程从共享的计数器依次领取块
+	/// @note	块按序号递增的顺序被领取，因此出错时序号更小的块都已被领取并会执行完毕
+	template <typename Func>
+	void ForEachChunk(size_t chunkCount, bool parallel, Func&& func)
+	{
+		const auto hardwareThreads = static_cast<size_t>(std::thread::hardware_concurrency());
+		if (!parallel || chunkCount < 2 || hardwareThreads < 2)
+		{
+			for (size_t i = 0; i < chunkCount; ++i)
+			{
+				func(i);
+			}
+			return;
+		}
+
+		const auto threadCount = std::min(hardwareThreads, chunkCount);
+		std::atomic<size_t> next{ 0 };
+		std::atomic<bool> failed{ false };
+		std::vector<std::exception_ptr> exceptions(chunkCount);
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+
+		const auto run = [&]
+		{
+			while (!failed.load(std::memory_order_relaxed))
+			{
+				const auto n = next.fetch_add(1, std::memory_order_relaxed);
+				if (n >= chunkCount)
+				{
+					break;
+				}
+
+				try
+				{
+					func(n);
+				}
+				catch (...)
+				{
+					exceptions[n] = std::current_exception();
+					failed.store(true, std::memory_order_relaxed);
+				}
+			}
+		};
+
+		for (size_t i = 0; i + 1 < threadCount; ++i)
+		{
+			threads.emplace_back(run);
+		}
+		run();
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (auto const& exception : exceptions)
+		{
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+	}
+
+	void WriteExact(natStream& stream, const void* data, size_t size)
+	{
+		if (stream.WriteBytes(static_cast<ncData>(data), size) != size)
+		{
+			nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+		}
+	}
+
+	void ReadExact(natStream& stream, void* data, size_t size)
+	{
+		auto bytes = static_cast<nData>(data);
+		while (size)
+		{
+			const auto read = static_cast<size_t>(stream.ReadBytes(bytes, size));
+			if (!read)
+			{
+				nat_Throw(ReflectionException, "Unexpected end of stream."_nv);
+			}
+			bytes += read;
+			size -= read;
+		}
+	}
+}
+
+void ChunkedSerialization::Write(natRefPointer<natStream> const& stream, natRefPointer<Object> const* objects, size_t count,
+	size_t chunkSize, ReferenceHandling referenceHandling, bool parallel)
+{
+	if (!stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+
+	if (!objects && count)
+	{
+		nat_Throw(NullPointerException, "Objects is nullptr."_nv);
+	}
+
+	if (!chunkSize)
+	{
+		nat_Throw(ReflectionException, "Chunk size cannot be zero."_nv);
+	}
+
+	const auto chunkCount = (count + chunkSize - 1) / chunkSize;
+	if (chunkCount > std::numeric_limits<std::uint32_t>::max())
+	{
+		nat_Throw(ReflectionException, "Too many chunks."_nv);
+	}
+
+	std::vector<natRefPointer<natMemoryStream>> chunks(chunkCount);
+	ForEachChunk(chunkCount, parallel, [&](size_t n)
+	{
+		const auto begin = n * chunkSize, end = std::min(count, begin + chunkSize);
+		auto chunk = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+		BinaryWriter writer{ chunk, referenceHandling };
+		for (auto i = begin; i < end; ++i)
+		{
+			writer.Write(objects[i]);
+		}
+		writer.Flush();
+		chunks[n] = std::move(chunk);
+	});
+
+	const std::uint32_t header[]{ Magic, Version, referenceHandling == ReferenceHandling::Preserve ? PreserveReferencesFlag : 0, static_cast<std::uint32_t>(chunkCount) };
+	WriteExact(*stream, header, sizeof header);
+
+	std::vector<ChunkEntry> table(chunkCount);
+	for (size_t n = 0; n < chunkCount; ++n)
+	{
+		table[n] = { std::min(count, (n + 1) * chunkSize) - n * chunkSize, chunks[n]->GetSize() };
+	}
+	WriteExact(*stream, table.data(), table.size() * sizeof(ChunkEntry));
+
+	for (auto& chunk : chunks)
+	{
+		WriteExact(*stream, chunk->GetInternalBuffer(), static_cast<size_t>(chunk->GetSize()));
+		chunk = {};
+	}
+}
+
+void ChunkedSerialization::Write(natRefPointer<natStream> const& stream, std::vector<natRefPointer<Object>> const& objects,
+	size_t chunkSize, ReferenceHandling referenceHandling, bool parallel)
+{
+	Write(stream, objects.data(), objects.size(), chunkSize, referenceHandling, parallel);
+}
+
+std::vector<natRefPointer<Object>> ChunkedSerialization::Read(natRefPointer<natStream> const& stream, bool parallel)
+{
+	if (!stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+
+	std::uint32_t header[4];
+	ReadExact(*stream, header, sizeof header);
+	if (header[0] != Magic)
+	{
+		nat_Throw(ReflectionException, "Stream does not contain a chunked object collection."_nv);
+	}
+
+	if (header[1] != Version)
+	{
+		nat_Throw(ReflectionException, "Unsupported version {0}."_nv, header[1]);
+	}
+
+	if (header[2] & ~PreserveReferencesFlag)
+	{
+		nat_Throw(ReflectionException, "Unknown flags {0}."_nv, header[2]);
+	}
+
+	const auto referenceHandling = header[2] & PreserveReferencesFlag ? ReferenceHandling::Preserve : ReferenceHandling::Duplicate;
+	const size_t chunkCount = header[3];
+
+	// 块表及块的数据在当前线程依次读取，逐块追加以免依据未经验证的数目一次性分配内存
+	std::vector<ChunkEntry> table;
+	for (size_t n = 0; n < chunkCount; ++n)
+	{
+		ChunkEntry entry;
+		ReadExact(*stream, &entry, sizeof entry);
+		if (entry.Size > std::numeric_limits<size_t>::max())
+		{
+			nat_Throw(ReflectionException, "Chunk {0} is too large."_nv, n);
+		}
+		table.push_back(entry);
+	}
+
+	std::vector<std::vector<nByte>> data;
+	for (auto const& entry : table)
+	{
+		data.emplace_back();
+		auto& bytes = data.back();
+		for (auto remaining = static_cast<size_t>(entry.Size); remaining;)
+		{
+			const auto size = std::min(remaining, ReadBlockSize);
+			const auto offset = bytes.size();
+			bytes.resize(offset + size);
+			ReadExact(*stream, bytes.data() + offset, size);
+			remaining -= size;
+		}
+	}
+
+	std::vector<std::vector<natRefPointer<Object>>> results(chunkCount);
+	ForEachChunk(chunkCount, parallel, [&](size_t n)
+	{
+		const auto chunk = make_ref<natMemoryStream>(data[n].data(), data[n].size(), true, false, false);
+		std::vector<nByte>{}.swap(data[n]);
+
+		auto& objects = results[n];
+		BinaryReader reader{ chunk, referenceHandling };
+		for (std::uint64_t i = 0; i < table[n].ObjectCount; ++i)
+		{
+			objects.emplace_back(reader.Read());
+		}
+		reader.Close();
+
+		if (chunk->GetPosition() != chunk->GetSize())
+		{
+			nat_Throw(ReflectionException, "Chunk {0} contains trailing data."_nv, n);
+		}
+	});
+
+	size_t total = 0;
+	for (auto const& objects : results)
+	{
+		total += objects.size();
+	}
+
+	std::vector<natRefPointer<Object>> result;
+	result.reserve(total);
+	for (auto& objects : results)
+	{
+		std::move(objects.begin(), objects.end(), std::back_inserter(result));
+	}
+
+	return result;
+}
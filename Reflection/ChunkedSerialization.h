@@ -0,0 +1,29 @@
+#pragma once
+#include "Serialization.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	以分块的容器格式读写对象集合
+/// @note	对象按顺序每ChunkSize个分为一块，每块是独立的BinaryWriter流，因此各块可在不同线程上编解码
+///			容器依次为头部(Magic、Version、Flags、块数)、块表(每块的对象数及字节数)及各块的数据，数值按原生字节序存放
+///			分块仅取决于chunkSize，因此输出与线程数无关，读取结果的顺序与写入时一致
+///			ReferenceHandling::Preserve时共享及循环引用仅在同一块内保持
+///			并行时每次调用创建至多hardware_concurrency个线程，任一块失败时抛出序号最小的块的异常
+////////////////////////////////////////////////////////////////////////////////
+namespace ChunkedSerialization
+{
+	constexpr std::uint32_t Magic = 0x4B434652; // "RFCK"
+	constexpr std::uint32_t Version = 1;
+	constexpr size_t DefaultChunkSize = 4096;
+
+	/// @brief	将对象集合编码后写入流
+	/// @param	chunkSize	每块包含的对象个数
+	/// @param	parallel	是否在多个线程上编码各块，对象在编码期间不能被修改
+	void Write(natRefPointer<natStream> const& stream, natRefPointer<Object> const* objects, size_t count,
+		size_t chunkSize = DefaultChunkSize, ReferenceHandling referenceHandling = ReferenceHandling::Duplicate, bool parallel = true);
+	void Write(natRefPointer<natStream> const& stream, std::vector<natRefPointer<Object>> const& objects,
+		size_t chunkSize = DefaultChunkSize, ReferenceHandling referenceHandling = ReferenceHandling::Duplicate, bool parallel = true);
+
+	/// @brief	读取由Write写入的对象集合
+	/// @note	数据不完整或不合法时抛出ReflectionException
+	std::vector<natRefPointer<Object>> Read(natRefPointer<natStream> const& stream, bool parallel = true);
+}
@@ -0,0 +1,893 @@
+#include "Reflection.h"
+#include <atomic>
+#include <limits>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#	define REFLECTION_X86_SIMD
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	else
+#		include <cpuid.h>
+#	endif
+#endif
+
+namespace
+{
+	template <typename T>
+	constexpr T MinIdentity() noexcept
+	{
+		return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+	}
+
+	template <typename T>
+	constexpr T MaxIdentity() noexcept
+	{
+		return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+	}
+
+	template <typename T>
+	bool Compare(T value, CompareOp op, T operand) noexcept
+	{
+		switch (op)
+		{
+		case CompareOp::Equal:
+			return value == operand;
+		case CompareOp::NotEqual:
+			return value != operand;
+		case CompareOp::Less:
+			return value < operand;
+		case CompareOp::LessEqual:
+			return value <= operand;
+		case CompareOp::Greater:
+			return value > operand;
+		case CompareOp::GreaterEqual:
+			return value >= operand;
+		default:
+			return false;
+		}
+	}
+
+	// 标量实现，同时用于处理SIMD实现剩余的尾部元素
+
+	std::int64_t SumScalar(const std::int32_t* values, size_t count, std::uint64_t sum = 0) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum += static_cast<std::uint64_t>(static_cast<std::int64_t>(values[i]));
+		}
+		return static_cast<std::int64_t>(sum);
+	}
+
+	std::int64_t SumScalar(const std::int64_t* values, size_t count, std::uint64_t sum = 0) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum += static_cast<std::uint64_t>(values[i]);
+		}
+		return static_cast<std::int64_t>(sum);
+	}
+
+	double SumScalar(const float* values, size_t count, double sum = 0) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum += values[i];
+		}
+		return sum;
+	}
+
+	double SumScalar(const double* values, size_t count, double sum = 0) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			sum += values[i];
+		}
+		return sum;
+	}
+
+	template <typename T>
+	T MinScalar(const T* values, size_t count, T result = MinIdentity<T>()) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			result = values[i] < result ? values[i] : result;
+		}
+		return result;
+	}
+
+	template <typename T>
+	T MaxScalar(const T* values, size_t count, T result = MaxIdentity<T>()) noexcept
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			result = values[i] > result ? values[i] : result;
+		}
+		return result;
+	}
+
+	template <typename T>
+	size_t CountScalar(const T* values, size_t count, CompareOp op, T operand) noexcept
+	{
+		size_t result = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			result += Compare(values[i], op, operand);
+		}
+		return result;
+	}
+
+	template <typename T>
+	size_t FilterScalar(const T* values, size_t count, CompareOp op, T operand, std::uint32_t* selection, size_t base = 0) noexcept
+	{
+		size_t result = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (Compare(values[i], op, operand))
+			{
+				selection[result++] = static_cast<std::uint32_t>(base + i);
+			}
+		}
+		return result;
+	}
+
+	size_t PopCount(unsigned mask) noexcept
+	{
+		size_t result = 0;
+		for (; mask; mask &= mask - 1)
+		{
+			++result;
+		}
+		return result;
+	}
+
+	size_t AppendSelection(unsigned mask, size_t base, std::uint32_t* selection) noexcept
+	{
+		size_t result = 0;
+		for (; mask; mask &= mask - 1)
+		{
+			size_t bit = 0;
+			while (!(mask & (1u << bit)))
+			{
+				++bit;
+			}
+			selection[result++] = static_cast<std::uint32_t>(base + bit);
+		}
+		return result;
+	}
+
+	SimdLevel DetectSimdLevel() noexcept
+	{
+#ifdef REFLECTION_X86_SIMD
+		unsigned info[4]{};
+		const auto cpuid = [&info](unsigned leaf)
+		{
+#ifdef _MSC_VER
+			int result[4];
+			__cpuidex(result, static_cast<int>(leaf), 0);
+			for (size_t i = 0; i < 4; ++i)
+			{
+				info[i] = static_cast<unsigned>(result[i]);
+			}
+#else
+			__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+		};
+
+		cpuid(0);
+		const auto maxLeaf = info[0];
+		if (maxLeaf < 1)
+		{
+			return SimdLevel::Scalar;
+		}
+
+		cpuid(1);
+		const auto ecx = info[2];
+		if (!(ecx & (1u << 20)))
+		{
+			return SimdLevel::Scalar;
+		}
+
+		// AVX2需要操作系统保存YMM寄存器状态
+		const auto osxsave = (ecx & (1u << 27)) != 0, avx = (ecx & (1u << 28)) != 0;
+		if (maxLeaf < 7 || !osxsave || !avx)
+		{
+			return SimdLevel::Sse42;
+		}
+
+#ifdef _MSC_VER
+		const auto xcr0 = _xgetbv(0);
+#else
+		unsigned xcr0Low, xcr0High;
+		__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+		const auto xcr0 = xcr0Low;
+#endif
+		if ((xcr0 & 6) != 6)
+		{
+			return SimdLevel::Sse42;
+		}
+
+		cpuid(7);
+		return (info[1] & (1u << 5)) ? SimdLevel::Avx2 : SimdLevel::Sse42;
+#else
+		return SimdLevel::Scalar;
+#endif
+	}
+
+	std::atomic<SimdLevel>& CurrentSimdLevel() noexcept
+	{
+		static std::atomic<SimdLevel> s_Level{ DetectSimdLevel() };
+		return s_Level;
+	}
+}
+
+#ifdef REFLECTION_X86_SIMD
+
+// 各指令集共用的循环，需要在对应指令集的编译选项下分别展开
+// Traits提供Width、Load、Broadcast、Compare、Mask、Min、Max及以SumRegister进行的累加
+#define COLUMN_KERNEL_LOOPS \
+	template <typename Traits>\
+	auto SumLoop(const typename Traits::Value* values, size_t count) noexcept\
+	{\
+		auto acc = Traits::SumZero();\
+		size_t i = 0;\
+		for (; i + Traits::Width <= count; i += Traits::Width)\
+		{\
+			acc = Traits::SumAdd(acc, Traits::Load(values + i));\
+		}\
+		return SumScalar(values + i, count - i, Traits::SumReduce(acc));\
+	}\
+	\
+	template <typename Traits>\
+	typename Traits::Value MinLoop(const typename Traits::Value* values, size_t count) noexcept\
+	{\
+		typedef typename Traits::Value Value;\
+		auto acc = Traits::Broadcast(MinIdentity<Value>());\
+		size_t i = 0;\
+		for (; i + Traits::Width <= count; i += Traits::Width)\
+		{\
+			acc = Traits::Min(Traits::Load(values + i), acc);\
+		}\
+		Value lanes[Traits::Width];\
+		Traits::Store(lanes, acc);\
+		return MinScalar(values + i, count - i, MinScalar(lanes, Traits::Width));\
+	}\
+	\
+	template <typename Traits>\
+	typename Traits::Value MaxLoop(const typename Traits::Value* values, size_t count) noexcept\
+	{\
+		typedef typename Traits::Value Value;\
+		auto acc = Traits::Broadcast(MaxIdentity<Value>());\
+		size_t i = 0;\
+		for (; i + Traits::Width <= count; i += Traits::Width)\
+		{\
+			acc = Traits::Max(Traits::Load(values + i), acc);\
+		}\
+		Value lanes[Traits::Width];\
+		Traits::Store(lanes, acc);\
+		return MaxScalar(values + i, count - i, MaxScalar(lanes, Traits::Width));\
+	}\
+	\
+	template <typename Traits, CompareOp Op>\
+	size_t CountLoop(const typename Traits::Value* values, size_t count, typename Traits::Value operand) noexcept\
+	{\
+		const auto rhs = Traits::Broadcast(operand);\
+		size_t result = 0, i = 0;\
+		for (; i + Traits::Width <= count; i += Traits::Width)\
+		{\
+			result += PopCount(Traits::template Compare<Op>(Traits::Load(values + i), rhs));\
+		}\
+		return result + CountScalar(values + i, count - i, Op, operand);\
+	}\
+	\
+	template <typename Traits, CompareOp Op>\
+	size_t FilterLoop(const typename Traits::Value* values, size_t count, typename Traits::Value operand, std::uint32_t* selection) noexcept\
+	{\
+		const auto rhs = Traits::Broadcast(operand);\
+		size_t result = 0, i = 0;\
+		for (; i + Traits::Width <= count; i += Traits::Width)\
+		{\
+			result += AppendSelection(Traits::template Compare<Op>(Traits::Load(values + i), rhs), i, selection + result);\
+		}\
+		return result + FilterScalar(values + i, count - i, Op, operand, selection + result, i);\
+	}\
+	\
+	template <typename Traits>\
+	size_t Count(const typename Traits::Value* values, size_t count, CompareOp op, typename Traits::Value operand) noexcept\
+	{\
+		switch (op)\
+		{\
+		case CompareOp::Equal:\
+			return CountLoop<Traits, CompareOp::Equal>(values, count, operand);\
+		case CompareOp::NotEqual:\
+			return CountLoop<Traits, CompareOp::NotEqual>(values, count, operand);\
+		case CompareOp::Less:\
+			return CountLoop<Traits, CompareOp::Less>(values, count, operand);\
+		case CompareOp::LessEqual:\
+			return CountLoop<Traits, CompareOp::LessEqual>(values, count, operand);\
+		case CompareOp::Greater:\
+			return CountLoop<Traits, CompareOp::Greater>(values, count, operand);\
+		case CompareOp::GreaterEqual:\
+			return CountLoop<Traits, CompareOp::GreaterEqual>(values, count, operand);\
+		default:\
+			return 0;\
+		}\
+	}\
+	\
+	template <typename Traits>\
+	size_t Filter(const typename Traits::Value* values, size_t count, CompareOp op, typename Traits::Value operand, std::uint32_t* selection) noexcept\
+	{\
+		switch (op)\
+		{\
+		case CompareOp::Equal:\
+			return FilterLoop<Traits, CompareOp::Equal>(values, count, operand, selection);\
+		case CompareOp::NotEqual:\
+			return FilterLoop<Traits, CompareOp::NotEqual>(values, count, operand, selection);\
+		case CompareOp::Less:\
+			return FilterLoop<Traits, CompareOp::Less>(values, count, operand, selection);\
+		case CompareOp::LessEqual:\
+			return FilterLoop<Traits, CompareOp::LessEqual>(values, count, operand, selection);\
+		case CompareOp::Greater:\
+			return FilterLoop<Traits, CompareOp::Greater>(values, count, operand, selection);\
+		case CompareOp::GreaterEqual:\
+			return FilterLoop<Traits, CompareOp::GreaterEqual>(values, count, operand, selection);\
+		default:\
+			return size_t{};\
+		}\
+	}
+
+// 整数比较仅有相等及大于，其余由其组合得到
+#define INTEGER_COMPARE_MASK(fullMask) \
+	template <CompareOp Op>\
+	static unsigned Compare(Register a, Register b) noexcept\
+	{\
+		switch (Op)\
+		{\
+		case CompareOp::Equal:\
+			return Mask(Equal(a, b));\
+		case CompareOp::NotEqual:\
+			return ~Mask(Equal(a, b)) & fullMask;\
+		case CompareOp::Less:\
+			return Mask(Greater(b, a));\
+		case CompareOp::LessEqual:\
+			return ~Mask(Greater(a, b)) & fullMask;\
+		case CompareOp::Greater:\
+			return Mask(Greater(a, b));\
+		default:\
+			return ~Mask(Greater(b, a)) & fullMask;\
+		}\
+	}
+
+#if defined(__clang__)
+#	pragma clang attribute push (__attribute__((target("sse4.2"))), apply_to = function)
+#elif defined(__GNUC__)
+#	pragma GCC push_options
+#	pragma GCC target("sse4.2")
+#endif
+
+namespace Sse42
+{
+	struct Int32
+	{
+		typedef std::int32_t Value;
+		typedef __m128i Register;
+		typedef __m128i SumRegister;
+		static constexpr size_t Width = 4;
+
+		static Register Load(const Value* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+		static void Store(Value* p, Register v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+		static Register Broadcast(Value v) noexcept { return _mm_set1_epi32(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm_min_epi32(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm_max_epi32(a, b); }
+		static Register Equal(Register a, Register b) noexcept { return _mm_cmpeq_epi32(a, b); }
+		static Register Greater(Register a, Register b) noexcept { return _mm_cmpgt_epi32(a, b); }
+		static unsigned Mask(Register m) noexcept { return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(m))); }
+		INTEGER_COMPARE_MASK(0xFu)
+
+		static SumRegister SumZero() noexcept { return _mm_setzero_si128(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept
+		{
+			acc = _mm_add_epi64(acc, _mm_cvtepi32_epi64(v));
+			return _mm_add_epi64(acc, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+		}
+		static std::uint64_t SumReduce(SumRegister acc) noexcept
+		{
+			std::uint64_t lanes[2];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+			return lanes[0] + lanes[1];
+		}
+	};
+
+	struct Int64
+	{
+		typedef std::int64_t Value;
+		typedef __m128i Register;
+		typedef __m128i SumRegister;
+		static constexpr size_t Width = 2;
+
+		static Register Load(const Value* p) noexcept { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+		static void Store(Value* p, Register v) noexcept { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+		static Register Broadcast(Value v) noexcept { return _mm_set1_epi64x(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b)); }
+		static Register Max(Register a, Register b) noexcept { return _mm_blendv_epi8(b, a, _mm_cmpgt_epi64(a, b)); }
+		static Register Equal(Register a, Register b) noexcept { return _mm_cmpeq_epi64(a, b); }
+		static Register Greater(Register a, Register b) noexcept { return _mm_cmpgt_epi64(a, b); }
+		static unsigned Mask(Register m) noexcept { return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(m))); }
+		INTEGER_COMPARE_MASK(0x3u)
+
+		static SumRegister SumZero() noexcept { return _mm_setzero_si128(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept { return _mm_add_epi64(acc, v); }
+		static std::uint64_t SumReduce(SumRegister acc) noexcept
+		{
+			std::uint64_t lanes[2];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+			return lanes[0] + lanes[1];
+		}
+	};
+
+	struct Float
+	{
+		typedef float Value;
+		typedef __m128 Register;
+		typedef __m128d SumRegister;
+		static constexpr size_t Width = 4;
+
+		static Register Load(const Value* p) noexcept { return _mm_loadu_ps(p); }
+		static void Store(Value* p, Register v) noexcept { _mm_storeu_ps(p, v); }
+		static Register Broadcast(Value v) noexcept { return _mm_set1_ps(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm_min_ps(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm_max_ps(a, b); }
+
+		template <CompareOp Op>
+		static unsigned Compare(Register a, Register b) noexcept
+		{
+			switch (Op)
+			{
+			case CompareOp::Equal:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpeq_ps(a, b)));
+			case CompareOp::NotEqual:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpneq_ps(a, b)));
+			case CompareOp::Less:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(a, b)));
+			case CompareOp::LessEqual:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(a, b)));
+			case CompareOp::Greater:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpgt_ps(a, b)));
+			default:
+				return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(a, b)));
+			}
+		}
+
+		static SumRegister SumZero() noexcept { return _mm_setzero_pd(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept
+		{
+			acc = _mm_add_pd(acc, _mm_cvtps_pd(v));
+			return _mm_add_pd(acc, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+		}
+		static double SumReduce(SumRegister acc) noexcept
+		{
+			double lanes[2];
+			_mm_storeu_pd(lanes, acc);
+			return lanes[0] + lanes[1];
+		}
+	};
+
+	struct Double
+	{
+		typedef double Value;
+		typedef __m128d Register;
+		typedef __m128d SumRegister;
+		static constexpr size_t Width = 2;
+
+		static Register Load(const Value* p) noexcept { return _mm_loadu_pd(p); }
+		static void Store(Value* p, Register v) noexcept { _mm_storeu_pd(p, v); }
+		static Register Broadcast(Value v) noexcept { return _mm_set1_pd(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm_min_pd(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm_max_pd(a, b); }
+
+		template <CompareOp Op>
+		static unsigned Compare(Register a, Register b) noexcept
+		{
+			switch (Op)
+			{
+			case CompareOp::Equal:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(a, b)));
+			case CompareOp::NotEqual:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpneq_pd(a, b)));
+			case CompareOp::Less:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(a, b)));
+			case CompareOp::LessEqual:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmple_pd(a, b)));
+			case CompareOp::Greater:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpgt_pd(a, b)));
+			default:
+				return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpge_pd(a, b)));
+			}
+		}
+
+		static SumRegister SumZero() noexcept { return _mm_setzero_pd(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept { return _mm_add_pd(acc, v); }
+		static double SumReduce(SumRegister acc) noexcept
+		{
+			double lanes[2];
+			_mm_storeu_pd(lanes, acc);
+			return lanes[0] + lanes[1];
+		}
+	};
+
+	COLUMN_KERNEL_LOOPS
+}
+
+#if defined(__clang__)
+#	pragma clang attribute pop
+#	pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#	pragma GCC pop_options
+#	pragma GCC push_options
+#	pragma GCC target("avx2")
+#endif
+
+namespace Avx2
+{
+	struct Int32
+	{
+		typedef std::int32_t Value;
+		typedef __m256i Register;
+		typedef __m256i SumRegister;
+		static constexpr size_t Width = 8;
+
+		static Register Load(const Value* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		static void Store(Value* p, Register v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+		static Register Broadcast(Value v) noexcept { return _mm256_set1_epi32(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm256_min_epi32(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm256_max_epi32(a, b); }
+		static Register Equal(Register a, Register b) noexcept { return _mm256_cmpeq_epi32(a, b); }
+		static Register Greater(Register a, Register b) noexcept { return _mm256_cmpgt_epi32(a, b); }
+		static unsigned Mask(Register m) noexcept { return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(m))); }
+		INTEGER_COMPARE_MASK(0xFFu)
+
+		static SumRegister SumZero() noexcept { return _mm256_setzero_si256(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept
+		{
+			acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+			return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+		}
+		static std::uint64_t SumReduce(SumRegister acc) noexcept
+		{
+			std::uint64_t lanes[4];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+	};
+
+	struct Int64
+	{
+		typedef std::int64_t Value;
+		typedef __m256i Register;
+		typedef __m256i SumRegister;
+		static constexpr size_t Width = 4;
+
+		static Register Load(const Value* p) noexcept { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		static void Store(Value* p, Register v) noexcept { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+		static Register Broadcast(Value v) noexcept { return _mm256_set1_epi64x(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b)); }
+		static Register Max(Register a, Register b) noexcept { return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b)); }
+		static Register Equal(Register a, Register b) noexcept { return _mm256_cmpeq_epi64(a, b); }
+		static Register Greater(Register a, Register b) noexcept { return _mm256_cmpgt_epi64(a, b); }
+		static unsigned Mask(Register m) noexcept { return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(m))); }
+		INTEGER_COMPARE_MASK(0xFu)
+
+		static SumRegister SumZero() noexcept { return _mm256_setzero_si256(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept { return _mm256_add_epi64(acc, v); }
+		static std::uint64_t SumReduce(SumRegister acc) noexcept
+		{
+			std::uint64_t lanes[4];
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+	};
+
+	struct Float
+	{
+		typedef float Value;
+		typedef __m256 Register;
+		typedef __m256d SumRegister;
+		static constexpr size_t Width = 8;
+
+		static Register Load(const Value* p) noexcept { return _mm256_loadu_ps(p); }
+		static void Store(Value* p, Register v) noexcept { _mm256_storeu_ps(p, v); }
+		static Register Broadcast(Value v) noexcept { return _mm256_set1_ps(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm256_min_ps(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm256_max_ps(a, b); }
+
+		template <CompareOp Op>
+		static unsigned Compare(Register a, Register b) noexcept
+		{
+			switch (Op)
+			{
+			case CompareOp::Equal:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+			case CompareOp::NotEqual:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_NEQ_UQ)));
+			case CompareOp::Less:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)));
+			case CompareOp::LessEqual:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)));
+			case CompareOp::Greater:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)));
+			default:
+				return static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ)));
+			}
+		}
+
+		static SumRegister SumZero() noexcept { return _mm256_setzero_pd(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept
+		{
+			acc = _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+			return _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+		}
+		static double SumReduce(SumRegister acc) noexcept
+		{
+			double lanes[4];
+			_mm256_storeu_pd(lanes, acc);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+	};
+
+	struct Double
+	{
+		typedef double Value;
+		typedef __m256d Register;
+		typedef __m256d SumRegister;
+		static constexpr size_t Width = 4;
+
+		static Register Load(const Value* p) noexcept { return _mm256_loadu_pd(p); }
+		static void Store(Value* p, Register v) noexcept { _mm256_storeu_pd(p, v); }
+		static Register Broadcast(Value v) noexcept { return _mm256_set1_pd(v); }
+		static Register Min(Register a, Register b) noexcept { return _mm256_min_pd(a, b); }
+		static Register Max(Register a, Register b) noexcept { return _mm256_max_pd(a, b); }
+
+		template <CompareOp Op>
+		static unsigned Compare(Register a, Register b) noexcept
+		{
+			switch (Op)
+			{
+			case CompareOp::Equal:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+			case CompareOp::NotEqual:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_NEQ_UQ)));
+			case CompareOp::Less:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LT_OQ)));
+			case CompareOp::LessEqual:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_LE_OQ)));
+			case CompareOp::Greater:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GT_OQ)));
+			default:
+				return static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_GE_OQ)));
+			}
+		}
+
+		static SumRegister SumZero() noexcept { return _mm256_setzero_pd(); }
+		static SumRegister SumAdd(SumRegister acc, Register v) noexcept { return _mm256_add_pd(acc, v); }
+		static double SumReduce(SumRegister acc) noexcept
+		{
+			double lanes[4];
+			_mm256_storeu_pd(lanes, acc);
+			return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+		}
+	};
+
+	COLUMN_KERNEL_LOOPS
+}
+
+#if defined(__clang__)
+#	pragma clang attribute pop
+#elif defined(__GNUC__)
+#	pragma GCC pop_options
+#endif
+
+#undef INTEGER_COMPARE_MASK
+#undef COLUMN_KERNEL_LOOPS
+
+// 按当前级别选择实现，kernel为各指令集命名空间中的函数模板名，Traits为对应的类型
+#define DISPATCH_COLUMN_KERNEL(kernel, traits, scalar, ...) \
+	switch (CurrentSimdLevel().load(std::memory_order_relaxed))\
+	{\
+	case SimdLevel::Avx2:\
+		return Avx2::kernel<Avx2::traits>(__VA_ARGS__);\
+	case SimdLevel::Sse42:\
+		return Sse42::kernel<Sse42::traits>(__VA_ARGS__);\
+	default:\
+		return scalar;\
+	}
+
+#else
+
+#define DISPATCH_COLUMN_KERNEL(kernel, traits, scalar, ...) return scalar;
+
+#endif
+
+SimdLevel ColumnKernels::GetSupportedSimdLevel() noexcept
+{
+	static const auto s_Level = DetectSimdLevel();
+	return s_Level;
+}
+
+SimdLevel ColumnKernels::GetSimdLevel() noexcept
+{
+	return CurrentSimdLevel().load(std::memory_order_relaxed);
+}
+
+SimdLevel ColumnKernels::SetSimdLevel(SimdLevel level) noexcept
+{
+	const auto supported = GetSupportedSimdLevel();
+	const auto result = static_cast<int>(level) > static_cast<int>(supported) ? supported : level;
+	CurrentSimdLevel().store(result, std::memory_order_relaxed);
+	return result;
+}
+
+std::int64_t ColumnKernels::Sum(const std::int32_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(SumLoop, Int32, SumScalar(values, count), values, count)
+}
+
+std::int64_t ColumnKernels::Sum(const std::int64_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(SumLoop, Int64, SumScalar(values, count), values, count)
+}
+
+double ColumnKernels::Sum(const float* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(SumLoop, Float, SumScalar(values, count), values, count)
+}
+
+double ColumnKernels::Sum(const double* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(SumLoop, Double, SumScalar(values, count), values, count)
+}
+
+std::int32_t ColumnKernels::Min(const std::int32_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MinLoop, Int32, MinScalar(values, count), values, count)
+}
+
+std::int64_t ColumnKernels::Min(const std::int64_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MinLoop, Int64, MinScalar(values, count), values, count)
+}
+
+float ColumnKernels::Min(const float* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MinLoop, Float, MinScalar(values, count), values, count)
+}
+
+double ColumnKernels::Min(const double* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MinLoop, Double, MinScalar(values, count), values, count)
+}
+
+std::int32_t ColumnKernels::Max(const std::int32_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MaxLoop, Int32, MaxScalar(values, count), values, count)
+}
+
+std::int64_t ColumnKernels::Max(const std::int64_t* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MaxLoop, Int64, MaxScalar(values, count), values, count)
+}
+
+float ColumnKernels::Max(const float* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MaxLoop, Float, MaxScalar(values, count), values, count)
+}
+
+double ColumnKernels::Max(const double* values, size_t count) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(MaxLoop, Double, MaxScalar(values, count), values, count)
+}
+
+size_t ColumnKernels::Count(const std::int32_t* values, size_t count, CompareOp op, std::int32_t operand) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Count, Int32, CountScalar(values, count, op, operand), values, count, op, operand)
+}
+
+size_t ColumnKernels::Count(const std::int64_t* values, size_t count, CompareOp op, std::int64_t operand) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Count, Int64, CountScalar(values, count, op, operand), values, count, op, operand)
+}
+
+size_t ColumnKernels::Count(const float* values, size_t count, CompareOp op, float operand) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Count, Float, CountScalar(values, count, op, operand), values, count, op, operand)
+}
+
+size_t ColumnKernels::Count(const double* values, size_t count, CompareOp op, double operand) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Count, Double, CountScalar(values, count, op, operand), values, count, op, operand)
+}
+
+size_t ColumnKernels::Filter(const std::int32_t* values, size_t count, CompareOp op, std::int32_t operand, std::uint32_t* selection) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Filter, Int32, FilterScalar(values, count, op, operand, selection), values, count, op, operand, selection)
+}
+
+size_t ColumnKernels::Filter(const std::int64_t* values, size_t count, CompareOp op, std::int64_t operand, std::uint32_t* selection) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Filter, Int64, FilterScalar(values, count, op, operand, selection), values, count, op, operand, selection)
+}
+
+size_t ColumnKernels::Filter(const float* values, size_t count, CompareOp op, float operand, std::uint32_t* selection) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Filter, Float, FilterScalar(values, count, op, operand, selection), values, count, op, operand, selection)
+}
+
+size_t ColumnKernels::Filter(const double* values, size_t count, CompareOp op, double operand, std::uint32_t* selection) noexcept
+{
+	DISPATCH_COLUMN_KERNEL(Filter, Double, FilterScalar(values, count, op, operand, selection), values, count, op, operand, selection)
+}
+
+#undef DISPATCH_COLUMN_KERNEL
+
+FieldColumn::FieldColumn(natRefPointer<IMemberField> const& field, natRefPointer<Object> const* objects, size_t count)
+	: m_Size{ count }
+{
+	if (!field)
+	{
+		nat_Throw(NullPointerException, "Field is nullptr."_nv);
+	}
+
+	const auto type = field->GetFieldTypeIndex();
+	size_t elementSize;
+	if (type == typeid(std::int32_t))
+	{
+		m_Kind = ElementKind::Int32;
+		elementSize = sizeof(std::int32_t);
+	}
+	else if (type == typeid(std::int64_t))
+	{
+		m_Kind = ElementKind::Int64;
+		elementSize = sizeof(std::int64_t);
+	}
+	else if (type == typeid(float))
+	{
+		m_Kind = ElementKind::Float;
+		elementSize = sizeof(float);
+	}
+	else if (type == typeid(double))
+	{
+		m_Kind = ElementKind::Double;
+		elementSize = sizeof(double);
+	}
+	else
+	{
+		nat_Throw(ReflectionException, "Field type is not supported by column kernels."_nv);
+	}
+
+	m_Storage.resize((count * elementSize + sizeof(std::int64_t) - 1) / sizeof(std::int64_t));
+	field->Gather(objects, count, m_Storage.data());
+}
+
+FieldColumn::FieldColumn(natRefPointer<IType> const& type, nStrView fieldName, std::vector<natRefPointer<Object>> const& objects)
+	: FieldColumn(type->GetMemberField(fieldName), objects.data(), objects.size())
+{
+}
+
+std::type_index FieldColumn::GetElementType() const noexcept
+{
+	switch (m_Kind)
+	{
+	case ElementKind::Int32:
+		return typeid(std::int32_t);
+	case ElementKind::Int64:
+		return typeid(std::int64_t);
+	case ElementKind::Float:
+		return typeid(float);
+	default:
+		return typeid(double);
+	}
+}
+
+size_t FieldColumn::GetSize() const noexcept
+{
+	return m_Size;
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include "Interface.h"
+#include <cstdint>
+#include <vector>
+
+enum class CompareOp
+{
+	Equal,
+	NotEqual,
+	Less,
+	LessEqual,
+	Greater,
+	GreaterEqual,
+};
+
+enum class SimdLevel
+{
+	Scalar,
+	Sse42,
+	Avx2,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	列上的聚合及过滤算法
+/// @note	根据宿主CPU在运行时选择AVX2、SSE4.2或标量实现
+///			整数类型的结果与标量实现完全一致，浮点求和及NaN参与的最值由于计算顺序不同可能存在差异
+////////////////////////////////////////////////////////////////////////////////
+namespace ColumnKernels
+{
+	/// @brief	宿主CPU支持的最高级别
+	SimdLevel GetSupportedSimdLevel() noexcept;
+	SimdLevel GetSimdLevel() noexcept;
+	/// @brief	设置使用的级别，用于与标量实现比较
+	/// @return	实际使用的级别，不会超过宿主CPU支持的级别
+	SimdLevel SetSimdLevel(SimdLevel level) noexcept;
+
+	/// @brief	整数以64位补码回绕累加，浮点以double累加
+	std::int64_t Sum(const std::int32_t* values, size_t count) noexcept;
+	std::int64_t Sum(const std::int64_t* values, size_t count) noexcept;
+	double Sum(const float* values, size_t count) noexcept;
+	double Sum(const double* values, size_t count) noexcept;
+
+	/// @brief	count为0时返回该类型的最大值（浮点为正无穷）
+	std::int32_t Min(const std::int32_t* values, size_t count) noexcept;
+	std::int64_t Min(const std::int64_t* values, size_t count) noexcept;
+	float Min(const float* values, size_t count) noexcept;
+	double Min(const double* values, size_t count) noexcept;
+
+	/// @brief	count为0时返回该类型的最小值（浮点为负无穷）
+	std::int32_t Max(const std::int32_t* values, size_t count) noexcept;
+	std::int64_t Max(const std::int64_t* values, size_t count) noexcept;
+	float Max(const float* values, size_t count) noexcept;
+	double Max(const double* values, size_t count) noexcept;
+
+	/// @brief	统计满足values[i] op operand的元素个数
+	size_t Count(const std::int32_t* values, size_t count, CompareOp op, std::int32_t operand) noexcept;
+	size_t Count(const std::int64_t* values, size_t count, CompareOp op, std::int64_t operand) noexcept;
+	size_t Count(const float* values, size_t count, CompareOp op, float operand) noexcept;
+	size_t Count(const double* values, size_t count, CompareOp op, double operand) noexcept;
+
+	/// @brief	将满足values[i] op operand的元素的序号按升序写入selection
+	/// @param	selection	大小至少为count
+	/// @return	写入的序号个数
+	size_t Filter(const std::int32_t* values, size_t count, CompareOp op, std::int32_t operand, std::uint32_t* selection) noexcept;
+	size_t Filter(const std::int64_t* values, size_t count, CompareOp op, std::int64_t operand, std::uint32_t* selection) noexcept;
+	size_t Filter(const float* values, size_t count, CompareOp op, float operand, std::uint32_t* selection) noexcept;
+	size_t Filter(const double* values, size_t count, CompareOp op, double operand, std::uint32_t* selection) noexcept;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	由一组对象的某个成员字段投影而成的列
+/// @note	支持int32_t、int64_t、float及double类型的字段
+////////////////////////////////////////////////////////////////////////////////
+class FieldColumn
+{
+public:
+	FieldColumn(natRefPointer<IMemberField> const& field, natRefPointer<Object> const* objects, size_t count);
+	FieldColumn(natRefPointer<IType> const& type, nStrView fieldName, std::vector<natRefPointer<Object>> const& objects);
+
+	std::type_index GetElementType() const noexcept;
+	size_t GetSize() const noexcept;
+
+	template <typename T>
+	const T* GetData() const
+	{
+		if (GetElementType() != typeid(T))
+		{
+			nat_Throw(ReflectionException, "Column element type mismatch."_nv);
+		}
+
+		return reinterpret_cast<const T*>(m_Storage.data());
+	}
+
+	template <typename R>
+	R Sum() const
+	{
+		return Visit([this](auto data)
+		{
+			return static_cast<R>(ColumnKernels::Sum(data, m_Size));
+		});
+	}
+
+	template <typename R>
+	R Min() const
+	{
+		return Visit([this](auto data)
+		{
+			return static_cast<R>(ColumnKernels::Min(data, m_Size));
+		});
+	}
+
+	template <typename R>
+	R Max() const
+	{
+		return Visit([this](auto data)
+		{
+			return static_cast<R>(ColumnKernels::Max(data, m_Size));
+		});
+	}
+
+	template <typename U>
+	size_t Count(CompareOp op, U operand) const
+	{
+		return Visit([&](auto data)
+		{
+			return ColumnKernels::Count(data, m_Size, op, static_cast<std::remove_const_t<std::remove_pointer_t<decltype(data)>>>(operand));
+		});
+	}
+
+	/// @brief	获得满足条件的元素的序号
+	template <typename U>
+	std::vector<std::uint32_t> Filter(CompareOp op, U operand) const
+	{
+		std::vector<std::uint32_t> selection(m_Size);
+		selection.resize(Visit([&](auto data)
+		{
+			return ColumnKernels::Filter(data, m_Size, op, static_cast<std::remove_const_t<std::remove_pointer_t<decltype(data)>>>(operand), selection.data());
+		}));
+		return selection;
+	}
+
+private:
+	enum class ElementKind
+	{
+		Int32,
+		Int64,
+		Float,
+		Double,
+	};
+
+	template <typename Func>
+	decltype(auto) Visit(Func&& func) const
+	{
+		const auto data = m_Storage.data();
+		switch (m_Kind)
+		{
+		case ElementKind::Int32:
+			return func(reinterpret_cast<const std::int32_t*>(data));
+		case ElementKind::Int64:
+			return func(reinterpret_cast<const std::int64_t*>(data));
+		case ElementKind::Float:
+			return func(reinterpret_cast<const float*>(data));
+		default:
+			return func(reinterpret_cast<const double*>(data));
+		}
+	}
+
+	ElementKind m_Kind;
+	size_t m_Size;
+	// 以int64_t为单位保证对齐
+	std::vector<std::int64_t> m_Storage;
+};
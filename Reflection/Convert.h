@@ -3,7 +3,7 @@
 
 struct Convert
 {
-	// TODO: ʹIConvertibleʵ
+	// TODO: 使用IConvertible实现
 	static natRefPointer<Object> ConvertTo(natRefPointer<Object> obj, natRefPointer<IType> toType);
 
 	template <typename T>
@@ -0,0 +1,203 @@
+#include "Reflection.h"
+
+namespace
+{
+	size_t PopCount(std::uint64_t bits) noexcept
+	{
+		size_t result = 0;
+		for (; bits; bits &= bits - 1)
+		{
+			++result;
+		}
+		return result;
+	}
+
+	void AppendMarked(std::uint64_t bits, size_t base, std::vector<size_t>& result)
+	{
+		for (size_t i = 0; bits; ++i, bits >>= 1)
+		{
+			if (bits & 1)
+			{
+				result.emplace_back(base + i);
+			}
+		}
+	}
+}
+
+DirtyFieldSet::DirtyFieldSet() noexcept
+	: m_Bits{}
+{
+}
+
+void DirtyFieldSet::Mark(size_t n)
+{
+	if (n < 64)
+	{
+		m_Bits |= std::uint64_t{ 1 } << n;
+		return;
+	}
+
+	const auto word = n / 64 - 1;
+	if (word >= m_Overflow.size())
+	{
+		m_Overflow.resize(word + 1);
+	}
+	m_Overflow[word] |= std::uint64_t{ 1 } << n % 64;
+}
+
+bool DirtyFieldSet::IsMarked(size_t n) const noexcept
+{
+	if (n < 64)
+	{
+		return (m_Bits >> n) & 1;
+	}
+
+	const auto word = n / 64 - 1;
+	return word < m_Overflow.size() && ((m_Overflow[word] >> n % 64) & 1);
+}
+
+bool DirtyFieldSet::IsEmpty() const noexcept
+{
+	if (m_Bits)
+	{
+		return false;
+	}
+
+	for (const auto bits : m_Overflow)
+	{
+		if (bits)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+size_t DirtyFieldSet::GetCount() const noexcept
+{
+	auto result = PopCount(m_Bits);
+	for (const auto bits : m_Overflow)
+	{
+		result += PopCount(bits);
+	}
+
+	return result;
+}
+
+std::vector<size_t> DirtyFieldSet::GetMarked() const
+{
+	std::vector<size_t> result;
+	AppendMarked(m_Bits, 0, result);
+	for (size_t i = 0; i < m_Overflow.size(); ++i)
+	{
+		AppendMarked(m_Overflow[i], (i + 1) * 64, result);
+	}
+
+	return result;
+}
+
+std::vector<size_t> DirtyFieldSet::TakeMarked()
+{
+	auto result = GetMarked();
+	Clear();
+	return result;
+}
+
+void DirtyFieldSet::Clear() noexcept
+{
+	m_Bits = 0;
+	std::fill(m_Overflow.begin(), m_Overflow.end(), std::uint64_t{});
+}
+
+bool DirtyTracking::IsTracked(Object* object) noexcept
+{
+	return object && object->GetDirtyFieldSet();
+}
+
+void DirtyTracking::MarkField(Object* object, IMemberField const* field)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	if (const auto dirtyFields = object->GetDirtyFieldSet())
+	{
+		dirtyFields->Mark(object->GetType()->GetRecordLayout()->GetFieldIndex(field));
+	}
+}
+
+void DirtyTracking::MarkField(Object* object, nStrView fieldName)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	const auto dirtyFields = object->GetDirtyFieldSet();
+	if (!dirtyFields)
+	{
+		return;
+	}
+
+	// 派生类的同名字段位于基类字段之后，从后向前查找以优先匹配派生类的字段
+	const auto layout = object->GetType()->GetRecordLayout();
+	for (auto i = layout->GetFieldCount(); i--;)
+	{
+		if (layout->GetField(i).Name.GetView() == fieldName)
+		{
+			dirtyFields->Mark(i);
+			return;
+		}
+	}
+
+	nat_Throw(ReflectionException, "No such member field named {0}."_nv, fieldName);
+}
+
+void DirtyTracking::MarkAll(Object* object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	if (const auto dirtyFields = object->GetDirtyFieldSet())
+	{
+		const auto count = object->GetType()->GetRecordLayout()->GetFieldCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			dirtyFields->Mark(i);
+		}
+	}
+}
+
+std::vector<size_t> DirtyTracking::GetDirtyFields(Object* object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	const auto dirtyFields = object->GetDirtyFieldSet();
+	return dirtyFields ? dirtyFields->GetMarked() : std::vector<size_t>{};
+}
+
+std::vector<size_t> DirtyTracking::TakeDirtyFields(Object* object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	const auto dirtyFields = object->GetDirtyFieldSet();
+	return dirtyFields ? dirtyFields->TakeMarked() : std::vector<size_t>{};
+}
+
+void DirtyTracking::Clear(Object* object) noexcept
+{
+	if (const auto dirtyFields = object ? object->GetDirtyFieldSet() : nullptr)
+	{
+		dirtyFields->Clear();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "Interface.h"
+#include <cstdint>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对象的已修改字段集合
+/// @note	序号为字段在对象实际类型的RecordLayout中的序号，前64个字段不需要额外分配内存
+////////////////////////////////////////////////////////////////////////////////
+class DirtyFieldSet final
+{
+public:
+	DirtyFieldSet() noexcept;
+
+	void Mark(size_t n);
+	bool IsMarked(size_t n) const noexcept;
+	bool IsEmpty() const noexcept;
+	size_t GetCount() const noexcept;
+
+	/// @brief	按升序获得已标记的序号
+	std::vector<size_t> GetMarked() const;
+	/// @brief	获得已标记的序号并清空集合
+	std::vector<size_t> TakeMarked();
+
+	void Clear() noexcept;
+
+private:
+	std::uint64_t m_Bits;
+	std::vector<std::uint64_t> m_Overflow;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对已启用修改跟踪的对象的操作
+/// @note	通过USE_DIRTY_TRACKING启用跟踪，IMemberField::WriteFrom及IType::WriteMemberField会自动标记字段，
+///			自行编写的setter可通过MARK_FIELD_DIRTY标记，通过FieldRef、Scatter或直接访问成员进行的修改不会被记录
+///			对未启用跟踪的对象，标记操作不产生任何效果，查询操作返回空集合
+////////////////////////////////////////////////////////////////////////////////
+namespace DirtyTracking
+{
+	bool IsTracked(Object* object) noexcept;
+
+	void MarkField(Object* object, IMemberField const* field);
+	void MarkField(Object* object, nStrView fieldName);
+	/// @brief	标记对象的所有字段，用于需要完整同步的场合
+	void MarkAll(Object* object);
+
+	/// @brief	获得已修改的字段在object->GetType()->GetRecordLayout()中的序号
+	std::vector<size_t> GetDirtyFields(Object* object);
+	std::vector<size_t> TakeDirtyFields(Object* object);
+	void Clear(Object* object) noexcept;
+}
+
+#define USE_DIRTY_TRACKING private: DirtyFieldSet _m_DirtyFields_;\
+public: DirtyFieldSet* GetDirtyFieldSet() noexcept override { return &_m_DirtyFields_; }
+
+#define MARK_FIELD_DIRTY(classname, fieldname) do\
+{\
+	static const auto _s_DirtyField_ = typeof(classname)->GetMemberField(#fieldname##_nv);\
+	DirtyTracking::MarkField(this, _s_DirtyField_.Get());\
+} while (false)
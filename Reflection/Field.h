@@ -48,6 +48,19 @@ namespace rdetail_
 		: std::true_type
 	{
 	};
+
+	// 仅当Object为Class的唯一非虚基类时才能由Object*向下转换，此时Object子对象与字段的相对位置固定
+	template <typename Class, typename = void>
+	struct HasFixedObjectOffset
+		: std::false_type
+	{
+	};
+
+	template <typename Class>
+	struct HasFixedObjectOffset<Class, std::void_t<decltype(static_cast<Class*>(std::declval<Object*>()))>>
+		: std::true_type
+	{
+	};
 }
 
 template <typename T>
@@ -102,6 +115,16 @@ public:
 		rdetail_::FieldSetter<std::remove_volatile_t<std::remove_reference_t<T>>>::Set(*m_Field, value);
 	}
 
+	std::type_index GetFieldTypeIndex() const noexcept override
+	{
+		return typeid(std::remove_cv_t<T>);
+	}
+
+	void* GetAddress() const noexcept override
+	{
+		return const_cast<std::remove_cv_t<T>*>(m_Field);
+	}
+
 private:
 	AccessSpecifier m_AccessSpecifier;
 	FieldType m_Field;
@@ -117,8 +140,8 @@ class MemberField<T(Class::*)>
 public:
 	typedef T(Class::*FieldType);
 
-	explicit MemberField(AccessSpecifier accessSpecifier, FieldType field)
-		: m_AccessSpecifier{ accessSpecifier }, m_Field{ field }
+	explicit MemberField(AccessSpecifier accessSpecifier, FieldType field, std::uint32_t id = 0)
+		: m_AccessSpecifier{ accessSpecifier }, m_Field{ field }, m_Offset{ ComputeOffset(field, rdetail_::HasFixedObjectOffset<Class>{}) }, m_Id{ id }
 	{
 	}
 
@@ -148,9 +171,189 @@ public:
 	{
 		//object->Unbox<Class>().*m_Field = value->Unbox<T>();
 		rdetail_::FieldSetter<std::remove_volatile_t<std::remove_reference_t<T>>>::Set(object->Unbox<Class>().*m_Field, value);
+		DirtyTracking::MarkField(object.Get(), this);
+	}
+
+	std::type_index GetFieldTypeIndex() const noexcept override
+	{
+		return typeid(std::remove_cv_t<T>);
+	}
+
+	std::ptrdiff_t GetOffset() const noexcept override
+	{
+		return m_Offset;
+	}
+
+	void* GetAddress(Object* object) override
+	{
+		if (m_Offset < 0)
+		{
+			return const_cast<std::remove_cv_t<T>*>(std::addressof(object->Unbox<Class>().*m_Field));
+		}
+
+		return reinterpret_cast<nByte*>(object) + m_Offset;
+	}
+
+	ValueOperations const& GetValueOperations() const noexcept override
+	{
+		return ::GetValueOperations<std::remove_volatile_t<T>>();
+	}
+
+	std::uint32_t GetFieldId() const noexcept override
+	{
+		return m_Id;
+	}
+
+	void Gather(natRefPointer<Object> const* objects, size_t count, void* column) override
+	{
+		const auto values = static_cast<ValueType*>(column);
+		if (m_Offset < 0)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = *static_cast<const ValueType*>(GetAddress(objects[i].Get()));
+			}
+			return;
+		}
+
+		const auto offset = m_Offset;
+		for (size_t i = 0; i < count; ++i)
+		{
+			values[i] = *reinterpret_cast<const ValueType*>(reinterpret_cast<const nByte*>(objects[i].Get()) + offset);
+		}
+	}
+
+	void Scatter(natRefPointer<Object> const* objects, size_t count, const void* column) override
+	{
+		ScatterImpl(objects, count, static_cast<const ValueType*>(column), std::is_copy_assignable<std::remove_volatile_t<T>>{});
 	}
 
 private:
+	typedef std::remove_cv_t<T> ValueType;
+
+	void ScatterImpl(natRefPointer<Object> const* objects, size_t count, const ValueType* values, std::true_type)
+	{
+		if (m_Offset < 0)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				*static_cast<ValueType*>(GetAddress(objects[i].Get())) = values[i];
+			}
+			return;
+		}
+
+		const auto offset = m_Offset;
+		for (size_t i = 0; i < count; ++i)
+		{
+			*reinterpret_cast<ValueType*>(reinterpret_cast<nByte*>(objects[i].Get()) + offset) = values[i];
+		}
+	}
+
+	void ScatterImpl(natRefPointer<Object> const*, size_t, const ValueType*, std::false_type)
+	{
+		nat_Throw(ReflectionException, "Field is not assignable."_nv);
+	}
+
+	// 仅进行指针运算而不访问存储，虚继承或有多个Object基类时返回-1以使用GetAddress的慢速路径
+	static std::ptrdiff_t ComputeOffset(FieldType field, std::true_type) noexcept
+	{
+		std::aligned_storage_t<sizeof(Class), alignof(Class)> storage;
+		const auto instance = reinterpret_cast<Class*>(&storage);
+		return reinterpret_cast<const nByte*>(std::addressof(instance->*field)) - reinterpret_cast<const nByte*>(static_cast<Object*>(instance));
+	}
+
+	static std::ptrdiff_t ComputeOffset(FieldType, std::false_type) noexcept
+	{
+		return -1;
+	}
+
 	AccessSpecifier m_AccessSpecifier;
 	FieldType m_Field;
+	std::ptrdiff_t m_Offset;
+	std::uint32_t m_Id;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	经过类型验证的成员字段访问器
+/// @note	构造时验证字段类型，之后的读写直接通过偏移访问对象，不进行装箱及类型转换
+///			访问时不检查对象类型，对象必须为声明该字段的类型或其派生类型
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class FieldRef
+{
+public:
+	FieldRef() noexcept
+		: m_Offset{ -1 }
+	{
+	}
+
+	explicit FieldRef(natRefPointer<IMemberField> field)
+		: m_Field{ std::move(field) }
+	{
+		if (!m_Field)
+		{
+			nat_Throw(NullPointerException, "Field is nullptr."_nv);
+		}
+
+		if (m_Field->GetFieldTypeIndex() != typeid(std::remove_cv_t<T>))
+		{
+			nat_Throw(ReflectionException, "Field type mismatch."_nv);
+		}
+
+		m_Offset = m_Field->GetOffset();
+	}
+
+	explicit operator bool() const noexcept
+	{
+		return static_cast<bool>(m_Field);
+	}
+
+	natRefPointer<IMemberField> const& GetField() const noexcept
+	{
+		return m_Field;
+	}
+
+	T& Get(Object* object) const
+	{
+		if (m_Offset < 0)
+		{
+			return *static_cast<T*>(m_Field->GetAddress(object));
+		}
+
+		return *reinterpret_cast<T*>(reinterpret_cast<nByte*>(object) + m_Offset);
+	}
+
+	T& Get(natRefPointer<Object> const& object) const
+	{
+		return Get(object.Get());
+	}
+
+	T& operator()(natRefPointer<Object> const& object) const
+	{
+		return Get(object.Get());
+	}
+
+	/// @brief	将[begin, end)中各对象的该字段依次复制到column中
+	/// @note	元素可为Object*或natRefPointer<Object>，column必须足以容纳所有值
+	template <typename Iter>
+	void Gather(Iter begin, Iter end, std::remove_cv_t<T>* column) const
+	{
+		for (; begin != end; ++begin)
+		{
+			*column++ = Get(&**begin);
+		}
+	}
+
+	template <typename Iter>
+	void Scatter(Iter begin, Iter end, const std::remove_cv_t<T>* column) const
+	{
+		for (; begin != end; ++begin)
+		{
+			Get(&**begin) = *column++;
+		}
+	}
+
+private:
+	natRefPointer<IMemberField> m_Field;
+	std::ptrdiff_t m_Offset;
 };
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstdint>
+#include <functional>
 #include <typeindex>
+#include <vector>
 #include <natRefObj.h>
 #include <natException.h>
 #include <natDelegate.h>
@@ -18,6 +21,13 @@ enum class AccessSpecifier
 	AccessSpecifier_private,
 };
 
+enum class ConstructorCategory
+{
+	Normal,
+	Copy,
+	Move,
+};
+
 class ArgumentPack;
 
 struct Interface
@@ -26,8 +36,176 @@ struct Interface
 };
 
 struct Object;
+class ObjectBatch;
+class RecordLayout;
 struct IType;
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	编译期生成的类型擦除调用入口
+/// @note	args中的每一项指向一个已拆箱的参数，ret指向足以容纳返回值的未初始化存储
+///			返回值将被就地构造于ret中，若返回引用则写入被引用对象的地址，若返回void则忽略ret
+////////////////////////////////////////////////////////////////////////////////
+struct CallThunk
+{
+	typedef void(*FuncType)(const void* method, void* self, void* const* args, void* ret);
+
+	FuncType Func;
+	const void* Method;
+
+	void operator()(void* self, void* const* args, void* ret) const
+	{
+		Func(Method, self, args, ret);
+	}
+
+	/// @brief	调用并取出按值返回的结果
+	template <typename Ret>
+	Ret Invoke(void* self, void* const* args) const
+	{
+		std::aligned_storage_t<sizeof(Ret), alignof(Ret)> storage;
+		Func(Method, self, args, &storage);
+		auto& result = *reinterpret_cast<Ret*>(&storage);
+		Ret ret = std::move(result);
+		result.~Ret();
+		return ret;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型擦除的值操作
+/// @note	类型不支持的操作为nullptr
+////////////////////////////////////////////////////////////////////////////////
+struct ValueOperations
+{
+	size_t Size;
+	size_t Alignment;
+	bool TriviallyCopyable;
+	/// @brief	于dest处复制构造src
+	void(*CopyConstruct)(void* dest, const void* src);
+	void(*CopyAssign)(void* dest, const void* src);
+	void(*Destroy)(void* ptr);
+	bool(*Equal)(const void* a, const void* b);
+	/// @brief	使用std::hash
+	size_t(*Hash)(const void* value);
+	/// @brief	值为指向Object派生类型的natRefPointer时获得其指向的对象，不增加引用计数
+	Object*(*ReferencedObject)(const void* value);
+	/// @brief	值为指向Object派生类型的natRefPointer时获得其声明的指向类型
+	std::type_index(*ReferencedType)();
+};
+
+namespace rdetail_
+{
+	template <typename T, typename = void>
+	struct IsEqualityComparable
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsEqualityComparable<T, std::void_t<decltype(std::declval<T const&>() == std::declval<T const&>())>>
+		: std::true_type
+	{
+	};
+
+	template <typename T, typename = void>
+	struct IsHashable
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsHashable<T, std::void_t<decltype(std::hash<T>{}(std::declval<T const&>()))>>
+		: std::true_type
+	{
+	};
+
+	template <typename T>
+	struct IsObjectPointer
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsObjectPointer<natRefPointer<T>>
+		: std::is_base_of<Object, T>
+	{
+	};
+
+	template <typename T>
+	struct ValueOperationsImpl
+	{
+		static void CopyConstruct(void* dest, const void* src)
+		{
+			::new(dest) T(*static_cast<const T*>(src));
+		}
+
+		static void CopyAssign(void* dest, const void* src)
+		{
+			*static_cast<T*>(dest) = *static_cast<const T*>(src);
+		}
+
+		static void Destroy(void* ptr)
+		{
+			static_cast<T*>(ptr)->~T();
+		}
+
+		static bool Equal(const void* a, const void* b)
+		{
+			return static_cast<bool>(*static_cast<const T*>(a) == *static_cast<const T*>(b));
+		}
+
+		static size_t Hash(const void* value)
+		{
+			return std::hash<std::remove_cv_t<T>>{}(*static_cast<const T*>(value));
+		}
+
+		static Object* ReferencedObject(const void* value)
+		{
+			return static_cast<const T*>(value)->Get();
+		}
+
+		static std::type_index ReferencedType()
+		{
+			return typeid(std::remove_pointer_t<decltype(std::declval<T const&>().Get())>);
+		}
+
+		// 仅在支持时取得函数地址，避免实例化不支持的操作
+		static constexpr decltype(&CopyConstruct) SelectCopyConstruct(std::true_type) noexcept { return &CopyConstruct; }
+		static constexpr decltype(&CopyConstruct) SelectCopyConstruct(std::false_type) noexcept { return nullptr; }
+		static constexpr decltype(&CopyAssign) SelectCopyAssign(std::true_type) noexcept { return &CopyAssign; }
+		static constexpr decltype(&CopyAssign) SelectCopyAssign(std::false_type) noexcept { return nullptr; }
+		static constexpr decltype(&Equal) SelectEqual(std::true_type) noexcept { return &Equal; }
+		static constexpr decltype(&Equal) SelectEqual(std::false_type) noexcept { return nullptr; }
+		static constexpr decltype(&Hash) SelectHash(std::true_type) noexcept { return &Hash; }
+		static constexpr decltype(&Hash) SelectHash(std::false_type) noexcept { return nullptr; }
+		static constexpr decltype(&ReferencedObject) SelectReferencedObject(std::true_type) noexcept { return &ReferencedObject; }
+		static constexpr decltype(&ReferencedObject) SelectReferencedObject(std::false_type) noexcept { return nullptr; }
+		static constexpr decltype(&ReferencedType) SelectReferencedType(std::true_type) noexcept { return &ReferencedType; }
+		static constexpr decltype(&ReferencedType) SelectReferencedType(std::false_type) noexcept { return nullptr; }
+	};
+}
+
+/// @brief	获得类型T的值操作
+/// @note	const类型不支持赋值
+template <typename T>
+ValueOperations const& GetValueOperations() noexcept
+{
+	typedef rdetail_::ValueOperationsImpl<T> Impl;
+	static const ValueOperations s_Operations
+	{
+		sizeof(T),
+		alignof(T),
+		std::is_trivially_copyable<T>::value,
+		Impl::SelectCopyConstruct(std::is_copy_constructible<T>{}),
+		Impl::SelectCopyAssign(std::is_copy_assignable<T>{}),
+		&Impl::Destroy,
+		Impl::SelectEqual(rdetail_::IsEqualityComparable<T>{}),
+		Impl::SelectHash(rdetail_::IsHashable<std::remove_cv_t<T>>{}),
+		Impl::SelectReferencedObject(rdetail_::IsObjectPointer<std::remove_cv_t<T>>{}),
+		Impl::SelectReferencedType(rdetail_::IsObjectPointer<std::remove_cv_t<T>>{}),
+	};
+	return s_Operations;
+}
+
 struct IMethod
 	: Interface
 {
@@ -38,6 +216,7 @@ struct IMethod
 	virtual natRefPointer<IType> GetReturnType() const noexcept = 0;
 	virtual size_t GetArgumentCount() const noexcept = 0;
 	virtual natRefPointer<IType> GetArgumentType(size_t n) const noexcept = 0;
+	virtual CallThunk GetThunk() const noexcept = 0;
 };
 
 struct IMemberMethod
@@ -53,6 +232,7 @@ struct IMemberMethod
 	virtual natRefPointer<IType> GetArgumentType(size_t n) const noexcept = 0;
 	virtual bool IsConstMemberMethod() const noexcept = 0;
 	virtual bool IsVirtual() const noexcept = 0;
+	virtual CallThunk GetThunk() const noexcept = 0;
 };
 
 struct IField
@@ -64,6 +244,11 @@ struct IField
 	virtual bool IsPointer() const noexcept = 0;
 	virtual natRefPointer<Object> Read() = 0;
 	virtual void Write(natRefPointer<Object> value) = 0;
+
+	/// @brief	获得字段的未装箱类型
+	virtual std::type_index GetFieldTypeIndex() const noexcept = 0;
+	/// @brief	获得字段的地址，可配合GetFieldTypeIndex直接读写而无需装箱
+	virtual void* GetAddress() const noexcept = 0;
 };
 
 struct IMemberField
@@ -75,19 +260,53 @@ struct IMemberField
 	virtual bool IsPointer() const noexcept = 0;
 	virtual natRefPointer<Object> ReadFrom(natRefPointer<Object> object) = 0;
 	virtual void WriteFrom(natRefPointer<Object> object, natRefPointer<Object> value) = 0;
+
+	/// @brief	获得字段的未装箱类型
+	virtual std::type_index GetFieldTypeIndex() const noexcept = 0;
+	/// @brief	获得字段相对于对象的Object子对象的偏移
+	/// @return	若声明该字段的类型并非派生于Object则返回-1
+	virtual std::ptrdiff_t GetOffset() const noexcept = 0;
+	/// @brief	获得对象中该字段的地址
+	/// @note	不检查对象类型，对象必须为声明该字段的类型或其派生类型
+	virtual void* GetAddress(Object* object) = 0;
+	virtual ValueOperations const& GetValueOperations() const noexcept = 0;
+	/// @brief	获得以DEFINE_MEMBER_FIELD_WITH_ID等指定的持久化id
+	/// @return	未指定时返回0
+	virtual std::uint32_t GetFieldId() const noexcept = 0;
+
+	/// @brief	将count个对象的该字段依次复制到column中
+	/// @param	column	元素类型为字段类型的已构造数组，大小至少为count
+	/// @note	不检查对象类型及是否为nullptr
+	virtual void Gather(natRefPointer<Object> const* objects, size_t count, void* column) = 0;
+	/// @brief	将column中的值依次写入count个对象的该字段
+	/// @note	不检查对象类型及是否为nullptr，若字段不可赋值则抛出ReflectionException
+	virtual void Scatter(natRefPointer<Object> const* objects, size_t count, const void* column) = 0;
 };
 
 struct IAttribute;
 struct AttributeSet;
 
 ////////////////////////////////////////////////////////////////////////////////
-/// @brief	ͽӿ
+/// @brief	类型的反射虚表
+/// @note	生成后不再修改，直至类型销毁前保持有效
+////////////////////////////////////////////////////////////////////////////////
+struct VirtualTable
+{
+	/// @brief	本类型及沿第一个基类的所有祖先类型，这些类型的槽位对本类型的对象有效
+	std::vector<IType*> Types;
+	std::vector<IMemberMethod*> Methods;
+	std::vector<nString> Names;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型接口
 ////////////////////////////////////////////////////////////////////////////////
 struct IType
 	: Interface
 {
 	virtual void RegisterAttributes(AttributeSet&& attributes) = 0;
 	virtual void RegisterBaseClasses(std::initializer_list<natRefPointer<IType>> baseClasses) = 0;
+	virtual void RegisterConstructor(natRefPointer<IMethod> constructor, ConstructorCategory category) = 0;
 	virtual void RegisterNonMemberMethod(nStrView name, natRefPointer<IMethod> method) = 0;
 	virtual void RegisterMemberMethod(nStrView name, natRefPointer<IMemberMethod> method) = 0;
 	virtual void RegisterNonMemberField(nStrView name, natRefPointer<IField> field) = 0;
@@ -95,7 +314,22 @@ struct IType
 
 	virtual nStrView GetName() const noexcept = 0;
 	virtual bool IsBoxed() const noexcept = 0;
+	/// @brief	此类型能否由文本解析
+	/// @note	装箱的基本类型及RefString可以解析
+	virtual bool IsParsable() const noexcept = 0;
+	/// @brief	由文本解析出此类型的对象
+	/// @note	不依赖区域设置且除结果对象外不分配内存，文本须完整表示一个值
+	///			类型不可解析、文本格式不正确或超出范围时抛出ReflectionException
+	virtual natRefPointer<Object> Parse(nStrView text) = 0;
 	virtual natRefPointer<Object> Construct(ArgumentPack const& args) = 0;
+	/// @brief	获得参数类型完全匹配的构造函数
+	/// @note	可通过返回的构造函数的GetThunk以已拆箱的参数直接创建对象
+	virtual natRefPointer<IMethod> GetConstructor(std::initializer_list<natRefPointer<IType>> const& argTypes) = 0;
+	virtual natRefPointer<Object> CopyConstruct(natRefPointer<Object> const& object) = 0;
+	virtual natRefPointer<Object> MoveConstruct(natRefPointer<Object> const& object) = 0;
+	/// @brief	以相同参数构造count个对象，对象位于同一块连续存储中
+	/// @note	对象仍可单独持有，批次被释放时未被外部持有的对象将一并销毁
+	virtual natRefPointer<ObjectBatch> ConstructBatch(size_t count, ArgumentPack const& args) = 0;
 	virtual size_t GetBaseClassesCount() const noexcept = 0;
 	virtual natRefPointer<IType> GetBaseClass(size_t n) const noexcept = 0;
 	virtual Linq<const natRefPointer<IType>> GetBaseClasses() const noexcept = 0;
@@ -103,6 +337,17 @@ struct IType
 	virtual natRefPointer<Object> InvokeMember(natRefPointer<Object> object, nStrView name, ArgumentPack const& args) = 0;
 	virtual natRefPointer<IMethod> GetNonMemberMethod(nStrView name, std::initializer_list<natRefPointer<IType>> const& argTypes) = 0;
 	virtual natRefPointer<IMemberMethod> GetMemberMethod(nStrView name, std::initializer_list<natRefPointer<IType>> const& argTypes) = 0;
+
+	/// @brief	获得虚成员方法在反射虚表中的槽位
+	/// @note	派生类型会保留第一个基类的槽位布局，因此由基类型获得的槽位可直接用于派生类型的对象
+	virtual size_t GetVirtualSlot(nStrView name, std::initializer_list<natRefPointer<IType>> const& argTypes) = 0;
+	/// @brief	获得反射虚表，注册成员方法或基类后将重新生成
+	virtual VirtualTable const& GetVirtualTable() = 0;
+	virtual size_t GetVirtualMethodCount() = 0;
+	virtual nStrView GetVirtualMethodName(size_t slot) = 0;
+	virtual natRefPointer<IMemberMethod> GetVirtualMethod(size_t slot) = 0;
+	virtual natRefPointer<Object> InvokeVirtual(natRefPointer<Object> object, size_t slot, ArgumentPack const& args) = 0;
+
 	virtual bool IsNonMemberFieldPointer(nStrView name) = 0;
 	virtual bool IsMemberFieldPointer(nStrView name) = 0;
 	virtual natRefPointer<Object> ReadNonMemberField(nStrView name) = 0;
@@ -112,18 +357,25 @@ struct IType
 	virtual natRefPointer<IField> GetNonMemberField(nStrView name) = 0;
 	virtual natRefPointer<IMemberField> GetMemberField(nStrView name) = 0;
 
-	/// @brief	öٸµķǳԱöٺtrueʱö
-	///	@param	recurse		ݹöٸеķǳԱ
-	/// @param	enumFunc	öٺܲĺΪ ǳԱǷΪǷͣǷΪnullptrboolֵ
-	/// @return	Ƿöٺtrueö
+	/// @brief	按注册顺序获得本类型的成员字段，不包含基类的成员字段
+	virtual size_t GetMemberFieldCount() const noexcept = 0;
+	virtual nStrView GetMemberFieldName(size_t n) const = 0;
+	virtual natRefPointer<IMemberField> GetMemberFieldByIndex(size_t n) const = 0;
+	/// @brief	获得本类型对象的扁平记录布局，包含基类的成员字段
+	virtual natRefPointer<RecordLayout> GetRecordLayout() = 0;
+
+	/// @brief	枚举该类型下的非成员，当枚举函数返回true时立即结束枚举
+	///	@param	recurse		递归地枚举父类中的非成员
+	/// @param	enumFunc	枚举函数，接受参数的含义为 非成员名，是否为方法，非方法的类型（若是方法则为nullptr），返回bool值
+	/// @return	是否因枚举函数返回true而结束枚举
 	virtual bool EnumNonMember(bool recurse, Delegate<bool(nStrView, bool, natRefPointer<IType>)> enumFunc) const = 0;
 	virtual Linq<const std::pair<const nString, natRefPointer<IMethod>>> GetNonMemberMethods() const noexcept = 0;
 	virtual Linq<const std::pair<const nString, natRefPointer<IField>>> GetNonMemberFields() const noexcept = 0;
 
-	/// @brief	öٸµĳԱöٺtrueʱö
-	///	@param	recurse		ݹöٸеķǳԱ
-	/// @param	enumFunc	öٺܲĺΪ ԱǷΪǷͣǷΪnullptrboolֵ
-	/// @return	Ƿöٺtrueö
+	/// @brief	枚举该类型下的成员，当枚举函数返回true时立即结束枚举
+	///	@param	recurse		递归地枚举父类中的非成员
+	/// @param	enumFunc	枚举函数，接受参数的含义为 成员名，是否为方法，非方法的类型（若是方法则为nullptr），返回bool值
+	/// @return	是否因枚举函数返回true而结束枚举
 	virtual bool EnumMember(bool recurse, Delegate<bool(nStrView, bool, natRefPointer<IType>)> enumFunc) const = 0;
 	virtual Linq<const std::pair<const nString, natRefPointer<IMemberMethod>>> GetMemberMethods() const noexcept = 0;
 	virtual Linq<const std::pair<const nString, natRefPointer<IMemberField>>> GetMemberFields() const noexcept = 0;
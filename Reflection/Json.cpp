@@ -0,0 +1,1143 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <system_error>
+
+// SSE2是x64的基本指令集，x86下VS2017也默认启用，因此无需运行时检测
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define REFLECTION_JSON_SSE2
+#	include <emmintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	endif
+#endif
+
+static_assert(sizeof(nStrView::CharType) == 1, "JSON text is encoded in UTF-8.");
+
+namespace
+{
+	size_t HashKey(nStrView key) noexcept
+	{
+		// FNV-1a
+		std::uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < key.size(); ++i)
+		{
+			hash ^= static_cast<unsigned char>(key.data()[i]);
+			hash *= 1099511628211ull;
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	size_t FormatUnsigned(std::uint64_t value, char* buffer) noexcept
+	{
+		char digits[20];
+		size_t count = 0;
+		do
+		{
+			digits[count++] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		} while (value);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			buffer[i] = digits[count - 1 - i];
+		}
+		return count;
+	}
+
+	bool IsWhitespace(char c) noexcept
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	bool IsNumberChar(char c) noexcept
+	{
+		return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+	}
+
+#ifdef REFLECTION_JSON_SSE2
+	unsigned TrailingZeros(unsigned mask) noexcept
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<unsigned>(index);
+#else
+		return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+	}
+#endif
+
+	const char* SkipSpaces(const char* p, const char* end) noexcept
+	{
+		// 值之间通常至多有一个空白字符，先逐字节检查，较长的缩进再以16字节为单位跳过
+		if (p == end || !IsWhitespace(*p))
+		{
+			return p;
+		}
+		++p;
+
+#ifdef REFLECTION_JSON_SSE2
+		const auto space = _mm_set1_epi8(' '), newLine = _mm_set1_epi8('\n'), carriageReturn = _mm_set1_epi8('\r'), tab = _mm_set1_epi8('\t');
+		for (; end - p >= 16; p += 16)
+		{
+			const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const auto whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newLine)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, carriageReturn), _mm_cmpeq_epi8(chunk, tab)));
+			const auto mask = static_cast<unsigned>(_mm_movemask_epi8(whitespace)) ^ 0xFFFFu;
+			if (mask)
+			{
+				return p + TrailingZeros(mask);
+			}
+		}
+#endif
+
+		while (p != end && IsWhitespace(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	/// @brief	查找第一个引号、反斜杠或控制字符
+	const char* FindStringSpecial(const char* p, const char* end) noexcept
+	{
+#ifdef REFLECTION_JSON_SSE2
+		const auto quote = _mm_set1_epi8('"'), backslash = _mm_set1_epi8('\\'), control = _mm_set1_epi8(0x1F);
+		for (; end - p >= 16; p += 16)
+		{
+			const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			// 无符号比较chunk <= 0x1F
+			const auto special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+				_mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+			const auto mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+			if (mask)
+			{
+				return p + TrailingZeros(mask);
+			}
+		}
+#endif
+
+		for (; p != end; ++p)
+		{
+			const auto c = static_cast<unsigned char>(*p);
+			if (c == '"' || c == '\\' || c < 0x20)
+			{
+				return p;
+			}
+		}
+		return end;
+	}
+
+	void AppendUtf8(nString& result, std::uint32_t codePoint)
+	{
+		char buffer[4];
+		size_t size;
+		if (codePoint < 0x80)
+		{
+			buffer[0] = static_cast<char>(codePoint);
+			size = 1;
+		}
+		else if (codePoint < 0x800)
+		{
+			buffer[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+			buffer[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			size = 2;
+		}
+		else if (codePoint < 0x10000)
+		{
+			buffer[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+			buffer[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			buffer[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			size = 3;
+		}
+		else
+		{
+			buffer[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+			buffer[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			buffer[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			buffer[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			size = 4;
+		}
+
+		result.Append(nStrView{ buffer, size });
+	}
+
+	void* GetMemberAddress(JsonPlan::Member const& member, Object* object)
+	{
+		const auto offset = member.Field->GetOffset();
+		return offset >= 0 ? reinterpret_cast<nByte*>(object) + offset : member.Field->GetAddress(object);
+	}
+}
+
+JsonPlan::JsonPlan(natRefPointer<IType> type)
+	: m_Type{ std::move(type) }, m_Boxed{}
+{
+	if (!m_Type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	m_Boxed = rdetail_::FindBoxedScalar(m_Type->GetTypeIndex());
+	if (m_Boxed)
+	{
+		return;
+	}
+
+	if (m_Type->IsBoxed())
+	{
+		nat_Throw(ReflectionException, "Boxed type {0} cannot be represented in JSON."_nv, m_Type->GetName());
+	}
+
+	m_DefaultConstructor = m_Type->GetConstructor({});
+
+	const auto layout = m_Type->GetRecordLayout();
+	const auto count = layout->GetFieldCount();
+	m_Members.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto&& entry = layout->GetField(i);
+		Member member{ ValueKind::Object, 0, entry.Name, {}, entry.Field, entry.Operations, {} };
+		if (entry.Pointer)
+		{
+			// 指向的类型可能未注册，仅在解码该字段时才需要
+			try
+			{
+				member.ReferencedType = Reflection::GetInstance().GetType(entry.Operations->ReferencedType());
+			}
+			catch (ReflectionException&)
+			{
+			}
+		}
+		else if (const auto scalar = rdetail_::FindFieldScalar(entry.Field->GetFieldTypeIndex()))
+		{
+			member.Kind = rdetail_::ToValueKind<ValueKind>(scalar->Kind);
+			member.Size = scalar->Size;
+		}
+		else
+		{
+			nat_Throw(ReflectionException, "Member field {0} of type {1} cannot be represented in JSON."_nv, entry.Name, m_Type->GetName());
+		}
+
+		member.EncodedKey = nString{ "\""_nv };
+		member.EncodedKey.Append(entry.Name.GetView());
+		member.EncodedKey.Append("\":"_nv);
+		m_Members.emplace_back(std::move(member));
+	}
+
+	// 装载因子不超过1/2，查找总能遇到空位
+	size_t capacity = 8;
+	while (capacity < m_Members.size() * 2)
+	{
+		capacity *= 2;
+	}
+
+	m_KeyTable.assign(capacity, npos);
+	for (size_t i = 0; i < m_Members.size(); ++i)
+	{
+		const auto name = m_Members[i].Name.GetView();
+		auto slot = HashKey(name) & (capacity - 1);
+		// 同名时由之后的派生类字段覆盖
+		while (m_KeyTable[slot] != npos && m_Members[m_KeyTable[slot]].Name.GetView() != name)
+		{
+			slot = (slot + 1) & (capacity - 1);
+		}
+		m_KeyTable[slot] = i;
+	}
+}
+
+natRefPointer<JsonPlan> JsonPlan::Get(natRefPointer<IType> const& type)
+{
+	return rdetail_::GetCachedPlan<JsonPlan>(type);
+}
+
+natRefPointer<IType> const& JsonPlan::GetType() const noexcept
+{
+	return m_Type;
+}
+
+bool JsonPlan::IsBoxed() const noexcept
+{
+	return m_Boxed != nullptr;
+}
+
+size_t JsonPlan::GetMemberCount() const noexcept
+{
+	return m_Members.size();
+}
+
+JsonPlan::Member const& JsonPlan::GetMember(size_t n) const
+{
+	if (n >= m_Members.size())
+	{
+		nat_Throw(ReflectionException, "Member index {0} is out of range."_nv, n);
+	}
+
+	return m_Members[n];
+}
+
+size_t JsonPlan::FindMember(nStrView key) const noexcept
+{
+	if (m_KeyTable.empty())
+	{
+		return npos;
+	}
+
+	const auto mask = m_KeyTable.size() - 1;
+	for (auto slot = HashKey(key) & mask;; slot = (slot + 1) & mask)
+	{
+		const auto index = m_KeyTable[slot];
+		if (index == npos || m_Members[index].Name.GetView() == key)
+		{
+			return index;
+		}
+	}
+}
+
+natRefPointer<Object> JsonPlan::CreateInstance() const
+{
+	return rdetail_::CreateDefaultInstance(m_DefaultConstructor, m_Type);
+}
+
+JsonWriter::JsonWriter(natRefPointer<natStream> stream)
+	: m_Stream{ std::move(stream) }, m_Buffer(BufferSize), m_Used{}, m_Flushed{}, m_First{ true }
+{
+	if (!m_Stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+}
+
+JsonWriter::~JsonWriter()
+{
+	try
+	{
+		Flush();
+	}
+	catch (...)
+	{
+	}
+}
+
+void JsonWriter::Write(natRefPointer<Object> const& object)
+{
+	if (!m_First)
+	{
+		*Reserve(1) = '\n';
+	}
+	m_First = false;
+
+	WriteObject(object.Get(), 0);
+}
+
+void JsonWriter::Flush()
+{
+	if (!m_Used)
+	{
+		return;
+	}
+
+	if (m_Stream->WriteBytes(reinterpret_cast<ncData>(m_Buffer.data()), m_Used) != m_Used)
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+
+	m_Flushed += m_Used;
+	m_Used = 0;
+}
+
+nLen JsonWriter::GetWrittenSize() const noexcept
+{
+	return m_Flushed + m_Used;
+}
+
+JsonPlan const& JsonWriter::GetPlan(natRefPointer<IType> const& type)
+{
+	auto& plan = m_Plans[type.Get()];
+	if (!plan)
+	{
+		plan = JsonPlan::Get(type);
+	}
+
+	return *plan;
+}
+
+void JsonWriter::WriteObject(Object* object, size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		nat_Throw(ReflectionException, "Object graph is too deep or contains a cycle."_nv);
+	}
+
+	if (!object)
+	{
+		WriteRaw("null", 4);
+		return;
+	}
+
+	auto const& plan = GetPlan(object->GetType());
+	if (plan.m_Boxed)
+	{
+		WriteScalar(rdetail_::ToValueKind<JsonPlan::ValueKind>(plan.m_Boxed->Kind), plan.m_Boxed->Size, plan.m_Boxed->Value(object));
+		return;
+	}
+
+	*Reserve(1) = '{';
+	for (size_t i = 0; i < plan.m_Members.size(); ++i)
+	{
+		auto const& member = plan.m_Members[i];
+		if (i)
+		{
+			*Reserve(1) = ',';
+		}
+
+		WriteRaw(member.EncodedKey.data(), member.EncodedKey.size());
+		const auto address = GetMemberAddress(member, object);
+		if (member.Kind == JsonPlan::ValueKind::Object)
+		{
+			WriteObject(member.Operations->ReferencedObject(address), depth + 1);
+		}
+		else
+		{
+			WriteScalar(member.Kind, member.Size, address);
+		}
+	}
+	*Reserve(1) = '}';
+}
+
+void JsonWriter::WriteScalar(JsonPlan::ValueKind kind, size_t size, const void* value)
+{
+	switch (kind)
+	{
+	case JsonPlan::ValueKind::Bool:
+		if (*static_cast<const bool*>(value))
+		{
+			WriteRaw("true", 4);
+		}
+		else
+		{
+			WriteRaw("false", 5);
+		}
+		break;
+	case JsonPlan::ValueKind::Signed:
+	{
+		const auto number = rdetail_::LoadSigned(value, size);
+		const auto buffer = Reserve(21);
+		size_t length = 0;
+		if (number < 0)
+		{
+			buffer[length++] = '-';
+		}
+		length += FormatUnsigned(number < 0 ? 0 - static_cast<std::uint64_t>(number) : static_cast<std::uint64_t>(number), buffer + length);
+		m_Used -= 21 - length;
+		break;
+	}
+	case JsonPlan::ValueKind::Unsigned:
+	{
+		const auto buffer = Reserve(20);
+		m_Used -= 20 - FormatUnsigned(rdetail_::LoadUnsigned(value, size), buffer);
+		break;
+	}
+	case JsonPlan::ValueKind::Float:
+	case JsonPlan::ValueKind::Double:
+	{
+		const auto isFloat = kind == JsonPlan::ValueKind::Float;
+		const auto number = isFloat ? static_cast<double>(*static_cast<const float*>(value)) : *static_cast<const double*>(value);
+		if (!std::isfinite(number))
+		{
+			nat_Throw(ReflectionException, "Non-finite number cannot be represented in JSON."_nv);
+		}
+
+		char buffer[32];
+		WriteRaw(buffer, isFloat ? rdetail_::FormatFloatingPoint(*static_cast<const float*>(value), buffer, sizeof buffer) : rdetail_::FormatFloatingPoint(number, buffer, sizeof buffer));
+		break;
+	}
+	case JsonPlan::ValueKind::String:
+		WriteString(*static_cast<const nString*>(value));
+		break;
+	case JsonPlan::ValueKind::Object:
+		nat_Throw(ReflectionException, "Object is not a scalar."_nv);
+	}
+}
+
+void JsonWriter::WriteString(nStrView value)
+{
+	static const char s_Hex[] = "0123456789abcdef";
+
+	*Reserve(1) = '"';
+	auto current = value.data();
+	const auto end = current + value.size();
+	while (true)
+	{
+		const auto special = FindStringSpecial(current, end);
+		WriteRaw(current, static_cast<size_t>(special - current));
+		if (special == end)
+		{
+			break;
+		}
+
+		const auto c = static_cast<unsigned char>(*special);
+		switch (c)
+		{
+		case '"':
+			WriteRaw("\\\"", 2);
+			break;
+		case '\\':
+			WriteRaw("\\\\", 2);
+			break;
+		case '\n':
+			WriteRaw("\\n", 2);
+			break;
+		case '\r':
+			WriteRaw("\\r", 2);
+			break;
+		case '\t':
+			WriteRaw("\\t", 2);
+			break;
+		case '\b':
+			WriteRaw("\\b", 2);
+			break;
+		case '\f':
+			WriteRaw("\\f", 2);
+			break;
+		default:
+		{
+			const char escaped[]{ '\\', 'u', '0', '0', s_Hex[c >> 4], s_Hex[c & 0xF] };
+			WriteRaw(escaped, sizeof escaped);
+			break;
+		}
+		}
+		current = special + 1;
+	}
+	*Reserve(1) = '"';
+}
+
+void JsonWriter::WriteRaw(const char* data, size_t size)
+{
+	if (size <= m_Buffer.size())
+	{
+		std::memcpy(Reserve(size), data, size);
+		return;
+	}
+
+	// 大块数据直接写入流
+	Flush();
+	if (m_Stream->WriteBytes(reinterpret_cast<ncData>(data), size) != size)
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+	m_Flushed += size;
+}
+
+char* JsonWriter::Reserve(size_t size)
+{
+	if (m_Used + size > m_Buffer.size())
+	{
+		Flush();
+		if (size > m_Buffer.size())
+		{
+			m_Buffer.resize(size);
+		}
+	}
+
+	const auto result = m_Buffer.data() + m_Used;
+	m_Used += size;
+	return result;
+}
+
+JsonReader::JsonReader(nStrView text)
+	: m_Consumed{}, m_Begin{ text.data() }, m_Current{ m_Begin }, m_End{ m_Begin + text.size() }
+{
+}
+
+JsonReader::JsonReader(natRefPointer<natStream> stream)
+	: m_Stream{ std::move(stream) }, m_Storage(BufferSize), m_Consumed{}, m_Begin{ m_Storage.data() }, m_Current{ m_Begin }, m_End{ m_Begin }
+{
+	if (!m_Stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+}
+
+bool JsonReader::IsEnd()
+{
+	SkipWhitespace();
+	return m_Current == m_End;
+}
+
+natRefPointer<Object> JsonReader::Read(natRefPointer<IType> const& type)
+{
+	if (!type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	return ReadValue(GetPlan(type), 0);
+}
+
+void JsonReader::ReadInto(natRefPointer<Object> const& object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	auto const& plan = GetPlan(object->GetType());
+	if (plan.m_Boxed)
+	{
+		ReadScalar(rdetail_::ToValueKind<JsonPlan::ValueKind>(plan.m_Boxed->Kind), plan.m_Boxed->Size, plan.m_Boxed->Value(object.Get()));
+		return;
+	}
+
+	ReadMembers(plan, object, true, 0);
+}
+
+size_t JsonReader::GetPosition() const noexcept
+{
+	return m_Consumed + static_cast<size_t>(m_Current - m_Begin);
+}
+
+JsonPlan const& JsonReader::GetPlan(natRefPointer<IType> const& type)
+{
+	auto& plan = m_Plans[type.Get()];
+	if (!plan)
+	{
+		plan = JsonPlan::Get(type);
+	}
+
+	return *plan;
+}
+
+natRefPointer<Object> JsonReader::ReadValue(JsonPlan const& plan, size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		Fail("Nesting is too deep."_nv);
+	}
+
+	SkipWhitespace();
+	if (m_Current != m_End && *m_Current == 'n')
+	{
+		ExpectLiteral("null"_nv);
+		return {};
+	}
+
+	if (plan.m_Boxed)
+	{
+		auto object = plan.m_Boxed->Create();
+		ReadScalar(rdetail_::ToValueKind<JsonPlan::ValueKind>(plan.m_Boxed->Kind), plan.m_Boxed->Size, plan.m_Boxed->Value(object.Get()));
+		return object;
+	}
+
+	auto object = plan.CreateInstance();
+	ReadMembers(plan, object, false, depth);
+	DirtyTracking::Clear(object.Get());
+	return object;
+}
+
+void JsonReader::ReadMembers(JsonPlan const& plan, natRefPointer<Object> const& object, bool markDirty, size_t depth)
+{
+	Expect('{');
+	if (TryConsume('}'))
+	{
+		return;
+	}
+
+	do
+	{
+		// 键指向窗口，需在补充窗口前查找
+		const auto index = plan.FindMember(ReadKey());
+		Expect(':');
+		if (index == JsonPlan::npos)
+		{
+			SkipValue(depth + 1);
+			continue;
+		}
+
+		auto const& member = plan.m_Members[index];
+		if (member.Kind == JsonPlan::ValueKind::Object)
+		{
+			if (!member.ReferencedType)
+			{
+				Fail("Referenced type of member is not registered."_nv);
+			}
+
+			// WriteFrom会标记字段为已修改
+			member.Field->WriteFrom(object, ReadValue(GetPlan(member.ReferencedType), depth + 1));
+		}
+		else
+		{
+			ReadScalar(member.Kind, member.Size, GetMemberAddress(member, object.Get()));
+			if (markDirty)
+			{
+				DirtyTracking::MarkField(object.Get(), member.Field.Get());
+			}
+		}
+	} while (TryConsume(','));
+
+	Expect('}');
+}
+
+void JsonReader::ReadScalar(JsonPlan::ValueKind kind, size_t size, void* value)
+{
+	SkipWhitespace();
+	switch (kind)
+	{
+	case JsonPlan::ValueKind::Bool:
+		if (m_Current != m_End && *m_Current == 't')
+		{
+			ExpectLiteral("true"_nv);
+			*static_cast<bool*>(value) = true;
+		}
+		else
+		{
+			ExpectLiteral("false"_nv);
+			*static_cast<bool*>(value) = false;
+		}
+		break;
+	case JsonPlan::ValueKind::Signed:
+	case JsonPlan::ValueKind::Unsigned:
+	{
+		ScanNumber();
+		const auto negative = m_Current != m_End && *m_Current == '-';
+		if (negative)
+		{
+			++m_Current;
+		}
+
+		const auto digits = m_Current;
+		std::uint64_t magnitude = 0;
+		for (; m_Current != m_End && *m_Current >= '0' && *m_Current <= '9'; ++m_Current)
+		{
+			const auto digit = static_cast<unsigned>(*m_Current - '0');
+			if (magnitude > (std::numeric_limits<std::uint64_t>::max() - digit) / 10)
+			{
+				Fail("Integer is out of range."_nv);
+			}
+			magnitude = magnitude * 10 + digit;
+		}
+
+		if (m_Current == digits)
+		{
+			Fail("Expected a number."_nv);
+		}
+		if (m_Current - digits > 1 && *digits == '0')
+		{
+			Fail("Leading zeros are not allowed."_nv);
+		}
+		if (m_Current != m_End && (*m_Current == '.' || *m_Current == 'e' || *m_Current == 'E'))
+		{
+			Fail("Expected an integer."_nv);
+		}
+
+		const auto bits = size * 8;
+		if (kind == JsonPlan::ValueKind::Signed)
+		{
+			const auto limit = (std::uint64_t{ 1 } << (bits - 1)) - 1;
+			if (magnitude > limit + (negative ? 1 : 0))
+			{
+				Fail("Integer is out of range."_nv);
+			}
+			rdetail_::StoreInteger(value, size, negative ? 0 - magnitude : magnitude);
+		}
+		else
+		{
+			const auto limit = bits == 64 ? std::numeric_limits<std::uint64_t>::max() : (std::uint64_t{ 1 } << bits) - 1;
+			if ((negative && magnitude) || magnitude > limit)
+			{
+				Fail("Integer is out of range."_nv);
+			}
+			rdetail_::StoreInteger(value, size, magnitude);
+		}
+		break;
+	}
+	case JsonPlan::ValueKind::Float:
+	case JsonPlan::ValueKind::Double:
+	{
+		const auto length = ScanNumber();
+		if (!length)
+		{
+			Fail("Expected a number."_nv);
+		}
+
+		const auto start = m_Current;
+		m_Current += length;
+		const auto result = kind == JsonPlan::ValueKind::Float ? rdetail_::ParseFloatingPoint(start, m_Current, *static_cast<float*>(value)) : rdetail_::ParseFloatingPoint(start, m_Current, *static_cast<double*>(value));
+		if (result == std::errc::result_out_of_range)
+		{
+			Fail("Number is out of range."_nv);
+		}
+		if (result != std::errc{})
+		{
+			Fail("Invalid number."_nv);
+		}
+		break;
+	}
+	case JsonPlan::ValueKind::String:
+		ReadString(*static_cast<nString*>(value));
+		break;
+	case JsonPlan::ValueKind::Object:
+		Fail("Object is not a scalar."_nv);
+	}
+}
+
+void JsonReader::ReadString(nString& result)
+{
+	Expect('"');
+	ReadStringContent(result);
+}
+
+void JsonReader::ReadStringContent(nString& result)
+{
+	// 不含转义的字符串一次复制
+	auto special = FindStringSpecial(m_Current, m_End);
+	if (special != m_End && *special == '"')
+	{
+		result = nString{ nStrView{ m_Current, static_cast<size_t>(special - m_Current) } };
+		m_Current = special + 1;
+		return;
+	}
+
+	result = nString{};
+	while (true)
+	{
+		result.Append(nStrView{ m_Current, static_cast<size_t>(special - m_Current) });
+		m_Current = special;
+		if (m_Current == m_End)
+		{
+			if (!Fill(1))
+			{
+				Fail("Unterminated string."_nv);
+			}
+
+			special = FindStringSpecial(m_Current, m_End);
+			continue;
+		}
+
+		if (*m_Current == '"')
+		{
+			++m_Current;
+			return;
+		}
+
+		if (*m_Current != '\\')
+		{
+			Fail("Control character in string."_nv);
+		}
+
+		++m_Current;
+		ReadEscape(result);
+		special = FindStringSpecial(m_Current, m_End);
+	}
+}
+
+void JsonReader::ReadEscape(nString& result)
+{
+	// 转义字符及其后的4位十六进制数
+	Fill(5);
+	if (m_Current == m_End)
+	{
+		Fail("Unterminated string."_nv);
+	}
+
+	char c;
+	switch (*m_Current++)
+	{
+	case '"':
+		c = '"';
+		break;
+	case '\\':
+		c = '\\';
+		break;
+	case '/':
+		c = '/';
+		break;
+	case 'b':
+		c = '\b';
+		break;
+	case 'f':
+		c = '\f';
+		break;
+	case 'n':
+		c = '\n';
+		break;
+	case 'r':
+		c = '\r';
+		break;
+	case 't':
+		c = '\t';
+		break;
+	case 'u':
+	{
+		auto codePoint = ReadHex4();
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+		{
+			Fill(6);
+			if (m_End - m_Current < 2 || m_Current[0] != '\\' || m_Current[1] != 'u')
+			{
+				Fail("Unpaired surrogate."_nv);
+			}
+			m_Current += 2;
+
+			const auto low = ReadHex4();
+			if (low < 0xDC00 || low > 0xDFFF)
+			{
+				Fail("Unpaired surrogate."_nv);
+			}
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+		}
+		else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF)
+		{
+			Fail("Unpaired surrogate."_nv);
+		}
+
+		AppendUtf8(result, codePoint);
+		return;
+	}
+	default:
+		Fail("Invalid escape sequence."_nv);
+	}
+
+	result.Append(nStrView{ &c, 1 });
+}
+
+std::uint32_t JsonReader::ReadHex4()
+{
+	if (m_End - m_Current < 4)
+	{
+		Fail("Invalid escape sequence."_nv);
+	}
+
+	std::uint32_t result = 0;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const auto c = *m_Current++;
+		result <<= 4;
+		if (c >= '0' && c <= '9')
+		{
+			result |= static_cast<std::uint32_t>(c - '0');
+		}
+		else if (c >= 'a' && c <= 'f')
+		{
+			result |= static_cast<std::uint32_t>(c - 'a' + 10);
+		}
+		else if (c >= 'A' && c <= 'F')
+		{
+			result |= static_cast<std::uint32_t>(c - 'A' + 10);
+		}
+		else
+		{
+			Fail("Invalid escape sequence."_nv);
+		}
+	}
+
+	return result;
+}
+
+nStrView JsonReader::ReadKey()
+{
+	Expect('"');
+
+	auto special = FindStringSpecial(m_Current, m_End);
+	if (special == m_End && static_cast<size_t>(m_End - m_Current) < m_Storage.size() && Fill(static_cast<size_t>(m_End - m_Current) + 1))
+	{
+		// 键跨越了窗口末尾，补充后重新查找
+		special = FindStringSpecial(m_Current, m_End);
+	}
+
+	if (special != m_End && *special == '"')
+	{
+		const nStrView key{ m_Current, static_cast<size_t>(special - m_Current) };
+		m_Current = special + 1;
+		return key;
+	}
+
+	// 含有转义或超出窗口，逐段解码
+	m_Key = nString{};
+	ReadStringContent(m_Key);
+	return m_Key.GetView();
+}
+
+void JsonReader::SkipValue(size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		Fail("Nesting is too deep."_nv);
+	}
+
+	SkipWhitespace();
+	if (m_Current == m_End)
+	{
+		Fail("Unexpected end of text."_nv);
+	}
+
+	switch (*m_Current)
+	{
+	case '{':
+		++m_Current;
+		if (TryConsume('}'))
+		{
+			return;
+		}
+
+		do
+		{
+			ReadKey();
+			Expect(':');
+			SkipValue(depth + 1);
+		} while (TryConsume(','));
+		Expect('}');
+		return;
+	case '[':
+		++m_Current;
+		if (TryConsume(']'))
+		{
+			return;
+		}
+
+		do
+		{
+			SkipValue(depth + 1);
+		} while (TryConsume(','));
+		Expect(']');
+		return;
+	case '"':
+		ReadKey();
+		return;
+	case 't':
+		ExpectLiteral("true"_nv);
+		return;
+	case 'f':
+		ExpectLiteral("false"_nv);
+		return;
+	case 'n':
+		ExpectLiteral("null"_nv);
+		return;
+	default:
+	{
+		const auto length = ScanNumber();
+		if (!length)
+		{
+			Fail("Unexpected character."_nv);
+		}
+
+		m_Current += length;
+		return;
+	}
+	}
+}
+
+size_t JsonReader::ScanNumber()
+{
+	size_t length = 0;
+	while (true)
+	{
+		while (m_Current + length != m_End && IsNumberChar(m_Current[length]))
+		{
+			++length;
+		}
+
+		if (m_Current + length != m_End)
+		{
+			return length;
+		}
+
+		// 数字可能跨越窗口末尾
+		if (length >= BufferSize)
+		{
+			Fail("Number is too long."_nv);
+		}
+		if (!Fill(length + 1))
+		{
+			return length;
+		}
+	}
+}
+
+void JsonReader::SkipWhitespace()
+{
+	do
+	{
+		m_Current = SkipSpaces(m_Current, m_End);
+	} while (m_Current == m_End && Fill(1));
+}
+
+bool JsonReader::TryConsume(char c)
+{
+	SkipWhitespace();
+	if (m_Current != m_End && *m_Current == c)
+	{
+		++m_Current;
+		return true;
+	}
+
+	return false;
+}
+
+void JsonReader::Expect(char c)
+{
+	if (!TryConsume(c))
+	{
+		nString message{ "Expected "_nv };
+		message.Append(nStrView{ &c, 1 });
+		Fail(message.GetView());
+	}
+}
+
+void JsonReader::ExpectLiteral(nStrView literal)
+{
+	SkipWhitespace();
+	Fill(literal.size());
+	if (static_cast<size_t>(m_End - m_Current) < literal.size() || std::memcmp(m_Current, literal.data(), literal.size()))
+	{
+		nString message{ "Expected "_nv };
+		message.Append(literal);
+		Fail(message.GetView());
+	}
+
+	m_Current += literal.size();
+}
+
+void JsonReader::Fail(nStrView message) const
+{
+	nat_Throw(ReflectionException, "Invalid JSON at offset {0}: {1}"_nv, GetPosition(), message);
+}
+
+bool JsonReader::Fill(size_t size)
+{
+	const auto available = static_cast<size_t>(m_End - m_Current);
+	if (available >= size)
+	{
+		return true;
+	}
+
+	if (!m_Stream)
+	{
+		return false;
+	}
+
+	m_Consumed += static_cast<size_t>(m_Current - m_Begin);
+	std::memmove(m_Storage.data(), m_Current, available);
+	if (m_Storage.size() < size)
+	{
+		m_Storage.resize(size);
+	}
+
+	auto filled = available;
+	do
+	{
+		const auto read = static_cast<size_t>(m_Stream->ReadBytes(reinterpret_cast<nData>(m_Storage.data() + filled), m_Storage.size() - filled));
+		if (!read)
+		{
+			m_Stream = {};
+			break;
+		}
+		filled += read;
+	} while (filled < size);
+
+	m_Begin = m_Current = m_Storage.data();
+	m_End = m_Begin + filled;
+	return filled >= size;
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "SerializationDetail.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型的JSON编解码计划
+/// @note	由类型的RecordLayout生成，对象编码为以字段名为键的JSON对象
+///			bool、整数及浮点数字段直接按地址读写，nString编码为字符串，natRefPointer字段编码为嵌套的对象或null
+///			装箱的基本类型及RefString编码为其值
+///			键查找使用预先生成的开放寻址表，同名字段优先匹配派生类的字段
+////////////////////////////////////////////////////////////////////////////////
+class JsonPlan final
+	: public natRefObjImpl<JsonPlan, Interface>
+{
+public:
+	enum class ValueKind
+	{
+		Bool,
+		Signed,
+		Unsigned,
+		Float,
+		Double,
+		String,
+		Object,
+	};
+
+	struct Member
+	{
+		ValueKind Kind;
+		/// @brief	整数及浮点数的字节数
+		size_t Size;
+		nString Name;
+		/// @brief	已编码的"Name":，写入时直接复制
+		nString EncodedKey;
+		natRefPointer<IMemberField> Field;
+		ValueOperations const* Operations;
+		/// @brief	Object成员声明的指向类型，类型未注册时为nullptr
+		natRefPointer<IType> ReferencedType;
+	};
+
+	static constexpr size_t npos = size_t(-1);
+
+	/// @brief	若类型存在无法以JSON表示的字段则抛出ReflectionException
+	explicit JsonPlan(natRefPointer<IType> type);
+
+	/// @brief	获得类型的计划，首次获得时生成
+	static natRefPointer<JsonPlan> Get(natRefPointer<IType> const& type);
+
+	natRefPointer<IType> const& GetType() const noexcept;
+	bool IsBoxed() const noexcept;
+	size_t GetMemberCount() const noexcept;
+	Member const& GetMember(size_t n) const;
+	/// @brief	以未转义的键查找成员
+	/// @return	成员的序号，找不到时返回npos
+	size_t FindMember(nStrView key) const noexcept;
+
+	/// @brief	以无参构造函数创建用于解码的对象
+	/// @note	类型没有注册无参构造函数时抛出ReflectionException
+	natRefPointer<Object> CreateInstance() const;
+
+private:
+	friend class JsonWriter;
+	friend class JsonReader;
+
+	natRefPointer<IType> m_Type;
+	rdetail_::ScalarInfo const* m_Boxed;
+	std::vector<Member> m_Members;
+	std::vector<size_t> m_KeyTable;
+	natRefPointer<IMethod> m_DefaultConstructor;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	将对象编码为JSON并写入流
+/// @note	不生成中间的DOM，数据先写入内部缓冲区，缓冲区满、调用Flush或析构时写入流
+///			多次调用Write时各值以换行分隔
+///			浮点数以足以精确往返的有效位数输出，非有限值无法以JSON表示，将抛出ReflectionException
+///			不处理共享及循环引用，循环引用将因超过MaxDepth而抛出异常
+////////////////////////////////////////////////////////////////////////////////
+class JsonWriter final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = 256;
+
+	explicit JsonWriter(natRefPointer<natStream> stream);
+	~JsonWriter();
+
+	JsonWriter(JsonWriter const&) = delete;
+	JsonWriter& operator=(JsonWriter const&) = delete;
+
+	/// @brief	写入对象，object可为nullptr
+	void Write(natRefPointer<Object> const& object);
+	void Flush();
+
+	/// @brief	已写入的字节数，包括尚在缓冲区中的部分
+	nLen GetWrittenSize() const noexcept;
+
+private:
+	JsonPlan const& GetPlan(natRefPointer<IType> const& type);
+	void WriteObject(Object* object, size_t depth);
+	void WriteScalar(JsonPlan::ValueKind kind, size_t size, const void* value);
+	void WriteString(nStrView value);
+	void WriteRaw(const char* data, size_t size);
+	char* Reserve(size_t size);
+
+	natRefPointer<natStream> m_Stream;
+	std::vector<char> m_Buffer;
+	size_t m_Used;
+	nLen m_Flushed;
+	bool m_First;
+	std::unordered_map<IType*, natRefPointer<JsonPlan>> m_Plans;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	从JSON文本中解码对象
+/// @note	单遍扫描文本并直接写入对象的字段，不生成中间的DOM，空白及字符串内容以SIMD扫描
+///			从流读取时只保留大小为BufferSize的窗口，在记号边界处补充数据，单个记号超出窗口时才扩大窗口
+///			未知的键被跳过，缺少的键保持无参构造函数设置的值
+///			文本不合法或与类型不符时抛出ReflectionException，描述中包含出错的位置
+////////////////////////////////////////////////////////////////////////////////
+class JsonReader final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = 256;
+
+	/// @brief	读取文本，text需在读取期间保持有效
+	explicit JsonReader(nStrView text);
+	/// @brief	从流中按需读取文本
+	/// @note	读取的数据可能超出最后一个值的末尾，读取完成后流的位置不确定
+	explicit JsonReader(natRefPointer<natStream> stream);
+
+	JsonReader(JsonReader const&) = delete;
+	JsonReader& operator=(JsonReader const&) = delete;
+
+	/// @brief	跳过空白后是否已到达文本末尾
+	bool IsEnd();
+	/// @brief	读取下一个值作为type类型的对象，值为null时返回nullptr
+	natRefPointer<Object> Read(natRefPointer<IType> const& type);
+	/// @brief	将下一个JSON对象的成员读入已存在的对象
+	/// @note	出现的字段被标记为已修改，natRefPointer字段指向新创建的对象
+	void ReadInto(natRefPointer<Object> const& object);
+
+	/// @brief	已读取的文本的字节数
+	size_t GetPosition() const noexcept;
+
+private:
+	JsonPlan const& GetPlan(natRefPointer<IType> const& type);
+	natRefPointer<Object> ReadValue(JsonPlan const& plan, size_t depth);
+	void ReadMembers(JsonPlan const& plan, natRefPointer<Object> const& object, bool markDirty, size_t depth);
+	void ReadScalar(JsonPlan::ValueKind kind, size_t size, void* value);
+	void ReadString(nString& result);
+	/// @brief	读取起始引号之后的字符串内容
+	void ReadStringContent(nString& result);
+	void ReadEscape(nString& result);
+	std::uint32_t ReadHex4();
+	/// @brief	读取键，不含转义且完整位于窗口中时直接返回窗口中的区间
+	/// @note	返回的区间在下一次补充窗口前有效
+	nStrView ReadKey();
+	void SkipValue(size_t depth);
+	/// @brief	确保数字记号完整位于窗口中，返回其长度
+	size_t ScanNumber();
+	void SkipWhitespace();
+	bool TryConsume(char c);
+	void Expect(char c);
+	void ExpectLiteral(nStrView literal);
+	[[noreturn]] void Fail(nStrView message) const;
+	/// @brief	确保窗口中至少有size个未读取的字节，流已结束且不足时返回false
+	/// @note	未读取的部分移动到窗口起始处，此前指向窗口的指针失效
+	bool Fill(size_t size);
+
+	natRefPointer<natStream> m_Stream;
+	std::vector<char> m_Storage;
+	size_t m_Consumed;
+	const char* m_Begin;
+	const char* m_Current;
+	const char* m_End;
+	nString m_Key;
+	std::unordered_map<IType*, natRefPointer<JsonPlan>> m_Plans;
+};
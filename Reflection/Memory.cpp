@@ -0,0 +1,523 @@
+#include "Reflection.h"
+
+namespace
+{
+	thread_local rdetail_::BatchConstructionContext t_BatchConstructionContext{};
+	thread_local ScratchArena* t_ScratchArena{};
+
+	void* TakeArmedBatchSlot(size_t size) noexcept
+	{
+		auto& context = t_BatchConstructionContext;
+		if (context.Armed)
+		{
+			context.Armed = false;
+			return context.Storage->TakeSlot(size);
+		}
+
+		return nullptr;
+	}
+}
+
+void* rdetail_::AllocateObject(size_t size)
+{
+	if (const auto ptr = TakeArmedBatchSlot(size))
+	{
+		return ptr;
+	}
+
+	if (const auto arena = t_ScratchArena)
+	{
+		return arena->Allocate(size);
+	}
+
+	return InitializeObjectHeader(::operator new(sizeof(ObjectHeader) + size), nullptr);
+}
+
+void* rdetail_::AllocatePooledObject(size_t size)
+{
+	if (const auto ptr = TakeArmedBatchSlot(size))
+	{
+		return ptr;
+	}
+
+	if (const auto arena = t_ScratchArena)
+	{
+		return arena->Allocate(size);
+	}
+
+	if (const auto pool = ObjectPool::GetThreadPool())
+	{
+		if (const auto ptr = pool->Allocate(size))
+		{
+			return ptr;
+		}
+	}
+
+	return InitializeObjectHeader(::operator new(sizeof(ObjectHeader) + size), nullptr);
+}
+
+void rdetail_::DeallocateObject(void* ptr) noexcept
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	const auto header = GetObjectHeader(ptr);
+	if (const auto owner = header->Owner)
+	{
+		owner->Deallocate(ptr);
+	}
+	else
+	{
+		::operator delete(header);
+	}
+}
+
+void rdetail_::PrepareBatchSlot(std::type_info const& type) noexcept
+{
+	auto& context = t_BatchConstructionContext;
+	if (context.Storage && *context.Type == type)
+	{
+		context.Armed = true;
+	}
+}
+
+rdetail_::BatchConstructionScope::BatchConstructionScope(ContiguousObjectStorage* storage, std::type_info const& type) noexcept
+	: m_Previous(t_BatchConstructionContext)
+{
+	t_BatchConstructionContext = { storage, &type, false };
+}
+
+rdetail_::BatchConstructionScope::~BatchConstructionScope()
+{
+	t_BatchConstructionContext = m_Previous;
+}
+
+ContiguousObjectStorage::ContiguousObjectStorage(size_t slotSize, size_t capacity)
+	: m_RefCount{ 1 }, m_SlotSize{ slotSize }, m_Stride{ (sizeof(rdetail_::ObjectHeader) + slotSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t) }, m_Capacity{ capacity }, m_Used{}, m_Buffer{ static_cast<nByte*>(::operator new(m_Stride * capacity)) }
+{
+}
+
+ContiguousObjectStorage::~ContiguousObjectStorage()
+{
+	::operator delete(m_Buffer);
+}
+
+void ContiguousObjectStorage::AddRef() noexcept
+{
+	m_RefCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ContiguousObjectStorage::Release() noexcept
+{
+	if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		delete this;
+	}
+}
+
+void* ContiguousObjectStorage::TakeSlot(size_t size) noexcept
+{
+	if (size > m_SlotSize || m_Used == m_Capacity)
+	{
+		return nullptr;
+	}
+
+	AddRef();
+	return rdetail_::InitializeObjectHeader(m_Buffer + m_Stride * m_Used++, this);
+}
+
+void ContiguousObjectStorage::Deallocate(void* /*ptr*/) noexcept
+{
+	Release();
+}
+
+size_t ContiguousObjectStorage::GetSlotSize() const noexcept
+{
+	return m_SlotSize;
+}
+
+size_t ContiguousObjectStorage::GetCapacity() const noexcept
+{
+	return m_Capacity;
+}
+
+size_t ContiguousObjectStorage::GetUsedCount() const noexcept
+{
+	return m_Used;
+}
+
+ObjectBatch::ObjectBatch(size_t objectSize, size_t capacity)
+	: m_Storage{ new ContiguousObjectStorage(objectSize, capacity) }
+{
+	m_Objects.reserve(capacity);
+}
+
+ObjectBatch::~ObjectBatch()
+{
+	Clear();
+	m_Storage->Release();
+}
+
+size_t ObjectBatch::Size() const noexcept
+{
+	return m_Objects.size();
+}
+
+natRefPointer<Object> ObjectBatch::Get(size_t n) const
+{
+	return m_Objects.at(n);
+}
+
+Linq<const natRefPointer<Object>> ObjectBatch::GetObjects() const noexcept
+{
+	return from(m_Objects);
+}
+
+void ObjectBatch::Clear() noexcept
+{
+	// 逆序释放，与构造顺序相反
+	while (!m_Objects.empty())
+	{
+		m_Objects.pop_back();
+	}
+}
+
+namespace
+{
+	thread_local ObjectPool* t_ObjectPool{};
+	thread_local bool t_ObjectPoolDestroyed{};
+
+	// 远程释放链表被置为此值表示所属线程已退出
+	constexpr std::uintptr_t OrphanedMark = alignof(std::max_align_t);
+}
+
+class ObjectPool::ThreadPoolHolder
+{
+public:
+	~ThreadPoolHolder()
+	{
+		if (t_ObjectPool)
+		{
+			const auto pool = t_ObjectPool;
+			t_ObjectPool = nullptr;
+			t_ObjectPoolDestroyed = true;
+			pool->Orphan();
+		}
+	}
+};
+
+ObjectPool* ObjectPool::GetThreadPool() noexcept
+{
+	if (t_ObjectPool || t_ObjectPoolDestroyed)
+	{
+		return t_ObjectPool;
+	}
+
+	// 首次使用时创建，持有者负责在线程退出时交出对象池
+	thread_local ThreadPoolHolder holder;
+	static_cast<void>(holder);
+	t_ObjectPool = new ObjectPool;
+	return t_ObjectPool;
+}
+
+size_t ObjectPool::GetSizeClass(size_t size) noexcept
+{
+	const auto blockSize = sizeof(rdetail_::ObjectHeader) + size;
+	return blockSize > MaxBlockSize ? SizeClassCount : (blockSize - 1) / SizeClassGranularity;
+}
+
+ObjectPool::ObjectPool()
+	: m_RemoteFreeList{}, m_OrphanedLiveCount{}, m_SizeClasses{}
+{
+	for (size_t i = 0; i < SizeClassCount; ++i)
+	{
+		m_SizeClasses[i].Statistics.BlockSize = (i + 1) * SizeClassGranularity;
+	}
+}
+
+ObjectPool::~ObjectPool()
+{
+	for (auto slab : m_Slabs)
+	{
+		::operator delete(slab);
+	}
+}
+
+void* ObjectPool::Allocate(size_t size)
+{
+	const auto sizeClass = GetSizeClass(size);
+	if (sizeClass >= SizeClassCount)
+	{
+		return nullptr;
+	}
+
+	auto& state = m_SizeClasses[sizeClass];
+	void* block;
+	if (state.FreeList)
+	{
+		block = state.FreeList;
+		state.FreeList = state.FreeList->Next;
+	}
+	else if (state.Current != state.End)
+	{
+		block = state.Current;
+		state.Current += state.Statistics.BlockSize;
+	}
+	else
+	{
+		block = AllocateSlow(sizeClass);
+	}
+
+	++state.Statistics.AllocationCount;
+	++state.Statistics.LiveCount;
+	return rdetail_::InitializeObjectHeader(block, this, sizeClass);
+}
+
+void ObjectPool::Deallocate(void* ptr) noexcept
+{
+	const auto block = rdetail_::GetObjectHeader(ptr);
+	const auto sizeClass = block->Tag;
+
+	if (t_ObjectPool == this)
+	{
+		auto& state = m_SizeClasses[sizeClass];
+		state.FreeList = ::new(static_cast<void*>(block)) FreeBlock{ state.FreeList, sizeClass };
+		++state.Statistics.DeallocationCount;
+		--state.Statistics.LiveCount;
+		return;
+	}
+
+	const auto freeBlock = ::new(static_cast<void*>(block)) FreeBlock{ nullptr, sizeClass };
+	auto head = m_RemoteFreeList.load(std::memory_order_relaxed);
+	while (true)
+	{
+		if (reinterpret_cast<std::uintptr_t>(head) == OrphanedMark)
+		{
+			if (m_OrphanedLiveCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				delete this;
+			}
+			return;
+		}
+
+		freeBlock->Next = head;
+		if (m_RemoteFreeList.compare_exchange_weak(head, freeBlock, std::memory_order_release, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+}
+
+PoolStatistics ObjectPool::GetStatistics(size_t sizeClass) const noexcept
+{
+	return m_SizeClasses[sizeClass].Statistics;
+}
+
+void* ObjectPool::AllocateSlow(size_t sizeClass)
+{
+	auto& state = m_SizeClasses[sizeClass];
+
+	ReclaimRemoteBlocks(m_RemoteFreeList.exchange(nullptr, std::memory_order_acquire));
+	if (state.FreeList)
+	{
+		const auto block = state.FreeList;
+		state.FreeList = block->Next;
+		return block;
+	}
+
+	const auto slab = static_cast<nByte*>(::operator new(SlabSize));
+	m_Slabs.emplace_back(slab);
+	++state.Statistics.SlabCount;
+	state.Current = slab + state.Statistics.BlockSize;
+	state.End = slab + SlabSize / state.Statistics.BlockSize * state.Statistics.BlockSize;
+	return slab;
+}
+
+void ObjectPool::ReclaimRemoteBlocks(FreeBlock* list) noexcept
+{
+	while (list)
+	{
+		const auto next = list->Next;
+		auto& state = m_SizeClasses[list->SizeClass];
+		list->Next = state.FreeList;
+		state.FreeList = list;
+		++state.Statistics.RemoteDeallocationCount;
+		--state.Statistics.LiveCount;
+		list = next;
+	}
+}
+
+void ObjectPool::Orphan() noexcept
+{
+	ReclaimRemoteBlocks(m_RemoteFreeList.exchange(reinterpret_cast<FreeBlock*>(OrphanedMark), std::memory_order_acq_rel));
+
+	std::ptrdiff_t liveCount{};
+	for (auto const& state : m_SizeClasses)
+	{
+		liveCount += static_cast<std::ptrdiff_t>(state.Statistics.LiveCount);
+	}
+
+	// 其他线程可能先于此处递减，计数恰好归零者负责销毁
+	if (m_OrphanedLiveCount.fetch_add(liveCount, std::memory_order_acq_rel) + liveCount == 0)
+	{
+		delete this;
+	}
+}
+
+// 每个分配出去的对象持有一个对块的引用，区域本身也持有一个引用
+class ScratchArena::Chunk final
+	: public IObjectStorage
+{
+public:
+	explicit Chunk(size_t size)
+		: m_RefCount{ 1 }, m_Size{ size }, m_Used{}, m_Buffer{ static_cast<nByte*>(::operator new(size)) }
+	{
+	}
+
+	void Release() noexcept
+	{
+		if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			delete this;
+		}
+	}
+
+	void* Allocate(size_t blockSize) noexcept
+	{
+		if (m_Size - m_Used < blockSize)
+		{
+			return nullptr;
+		}
+
+		m_RefCount.fetch_add(1, std::memory_order_relaxed);
+		const auto block = m_Buffer + m_Used;
+		m_Used += blockSize;
+		return rdetail_::InitializeObjectHeader(block, this);
+	}
+
+	void Deallocate(void* /*ptr*/) noexcept override
+	{
+		Release();
+	}
+
+	// 仅由区域持有时可以重置
+	bool TryReset() noexcept
+	{
+		if (m_RefCount.load(std::memory_order_acquire) == 1)
+		{
+			m_Used = 0;
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	~Chunk()
+	{
+		::operator delete(m_Buffer);
+	}
+
+	std::atomic<size_t> m_RefCount;
+	size_t m_Size;
+	size_t m_Used;
+	nByte* m_Buffer;
+};
+
+ScratchArena::ScratchArena(size_t chunkSize)
+	: m_ChunkSize{ chunkSize }, m_Depth{}, m_Current{}, m_EscapedChunkCount{}
+{
+}
+
+ScratchArena::~ScratchArena()
+{
+	for (auto chunk : m_Chunks)
+	{
+		chunk->Release();
+	}
+}
+
+ScratchArena& ScratchArena::GetThreadArena()
+{
+	thread_local ScratchArena arena;
+	return arena;
+}
+
+void* ScratchArena::Allocate(size_t size)
+{
+	const auto blockSize = (sizeof(rdetail_::ObjectHeader) + size + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+	if (blockSize > m_ChunkSize / 4)
+	{
+		return rdetail_::InitializeObjectHeader(::operator new(sizeof(rdetail_::ObjectHeader) + size), nullptr);
+	}
+
+	for (; m_Current < m_Chunks.size(); ++m_Current)
+	{
+		if (const auto ptr = m_Chunks[m_Current]->Allocate(blockSize))
+		{
+			return ptr;
+		}
+	}
+
+	m_Chunks.emplace_back(new Chunk(m_ChunkSize));
+	return m_Chunks.back()->Allocate(blockSize);
+}
+
+size_t ScratchArena::GetChunkSize() const noexcept
+{
+	return m_ChunkSize;
+}
+
+size_t ScratchArena::GetChunkCount() const noexcept
+{
+	return m_Chunks.size();
+}
+
+size_t ScratchArena::GetEscapedChunkCount() const noexcept
+{
+	return m_EscapedChunkCount;
+}
+
+void ScratchArena::EndScope() noexcept
+{
+	// 仍有对象存活的块交由这些对象持有，其余块重置后复用
+	auto kept = m_Chunks.begin();
+	for (auto chunk : m_Chunks)
+	{
+		if (chunk->TryReset())
+		{
+			*kept++ = chunk;
+		}
+		else
+		{
+			chunk->Release();
+			++m_EscapedChunkCount;
+		}
+	}
+
+	m_Chunks.erase(kept, m_Chunks.end());
+	m_Current = 0;
+}
+
+ScratchScope::ScratchScope()
+	: ScratchScope(ScratchArena::GetThreadArena())
+{
+}
+
+ScratchScope::ScratchScope(ScratchArena& arena) noexcept
+	: m_Arena{ &arena }, m_Previous{ t_ScratchArena }
+{
+	++arena.m_Depth;
+	t_ScratchArena = &arena;
+}
+
+ScratchScope::~ScratchScope()
+{
+	t_ScratchArena = m_Previous;
+	if (--m_Arena->m_Depth == 0)
+	{
+		m_Arena->EndScope();
+	}
+}
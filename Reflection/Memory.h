@@ -0,0 +1,277 @@
+#pragma once
+#include "Interface.h"
+#include <atomic>
+#include <cstddef>
+#include <typeinfo>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对象存储接口
+/// @note	经由Object::operator new分配的对象前均带有记录其所有者的头部，对象销毁时内存交还给所有者
+///			所有者为nullptr表示内存直接来自全局堆
+////////////////////////////////////////////////////////////////////////////////
+struct IObjectStorage
+{
+	virtual void Deallocate(void* ptr) noexcept = 0;
+
+protected:
+	~IObjectStorage() = default;
+};
+
+class ContiguousObjectStorage;
+
+namespace rdetail_
+{
+	struct alignas(std::max_align_t) ObjectHeader
+	{
+		IObjectStorage* Owner;
+		// 供所有者使用的附加信息
+		size_t Tag;
+	};
+
+	inline void* InitializeObjectHeader(void* block, IObjectStorage* owner, size_t tag = 0) noexcept
+	{
+		const auto header = ::new(block) ObjectHeader{ owner, tag };
+		return header + 1;
+	}
+
+	inline ObjectHeader* GetObjectHeader(void* ptr) noexcept
+	{
+		return static_cast<ObjectHeader*>(ptr) - 1;
+	}
+
+	void* AllocateObject(size_t size);
+	// 优先从当前线程的对象池中分配，大小超出对象池的最大块时退化为AllocateObject
+	void* AllocatePooledObject(size_t size);
+	void DeallocateObject(void* ptr) noexcept;
+
+	// 若当前处于type类型的批量构造中，则令下一次对象分配使用批量构造的连续存储
+	void PrepareBatchSlot(std::type_info const& type) noexcept;
+
+	struct BatchConstructionContext
+	{
+		ContiguousObjectStorage* Storage;
+		const std::type_info* Type;
+		bool Armed;
+	};
+
+	class BatchConstructionScope
+	{
+	public:
+		BatchConstructionScope(ContiguousObjectStorage* storage, std::type_info const& type) noexcept;
+		~BatchConstructionScope();
+
+		BatchConstructionScope(BatchConstructionScope const&) = delete;
+		BatchConstructionScope& operator=(BatchConstructionScope const&) = delete;
+
+	private:
+		BatchConstructionContext m_Previous;
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	由固定大小的槽位组成的连续存储
+/// @note	每个被分配出去的槽位持有一个对存储的引用，所有者及所有对象均释放后整块归还
+////////////////////////////////////////////////////////////////////////////////
+class ContiguousObjectStorage final
+	: public IObjectStorage
+{
+public:
+	ContiguousObjectStorage(size_t slotSize, size_t capacity);
+
+	void AddRef() noexcept;
+	void Release() noexcept;
+
+	/// @brief	分配一个槽位
+	/// @return	若大小超出槽位或槽位已耗尽则返回nullptr
+	void* TakeSlot(size_t size) noexcept;
+	void Deallocate(void* ptr) noexcept override;
+
+	size_t GetSlotSize() const noexcept;
+	size_t GetCapacity() const noexcept;
+	size_t GetUsedCount() const noexcept;
+
+private:
+	~ContiguousObjectStorage();
+
+	std::atomic<size_t> m_RefCount;
+	size_t m_SlotSize;
+	size_t m_Stride;
+	size_t m_Capacity;
+	size_t m_Used;
+	nByte* m_Buffer;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	构造于同一块连续存储中的一批对象
+/// @note	对象仍然各自进行引用计数，可以单独被持有或释放
+////////////////////////////////////////////////////////////////////////////////
+class ObjectBatch final
+	: public natRefObjImpl<ObjectBatch, Interface>
+{
+public:
+	ObjectBatch(size_t objectSize, size_t capacity);
+	~ObjectBatch();
+
+	/// @brief	构造一个对象并加入本批
+	/// @note	构造过程中由CommonConstructor创建的type类型的对象将使用本批的连续存储
+	template <typename Func>
+	void Emplace(std::type_info const& type, Func&& constructor)
+	{
+		rdetail_::BatchConstructionScope scope{ m_Storage, type };
+		m_Objects.emplace_back(constructor());
+	}
+
+	size_t Size() const noexcept;
+	natRefPointer<Object> Get(size_t n) const;
+	Linq<const natRefPointer<Object>> GetObjects() const noexcept;
+
+	/// @brief	释放本批持有的所有引用
+	/// @note	未被外部持有的对象将被立即析构，存储在所有对象销毁后整块释放
+	void Clear() noexcept;
+
+private:
+	ContiguousObjectStorage* m_Storage;
+	std::vector<natRefPointer<Object>> m_Objects;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对象池单个大小类的统计信息
+////////////////////////////////////////////////////////////////////////////////
+struct PoolStatistics
+{
+	size_t BlockSize;
+	size_t AllocationCount;
+	size_t DeallocationCount;
+	/// @brief	由其他线程释放并已被回收的块数
+	size_t RemoteDeallocationCount;
+	size_t SlabCount;
+	size_t LiveCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	按大小类分配小对象的线程局部对象池
+/// @note	每个线程拥有独立的对象池，分配及同线程释放均无需同步
+///			其他线程释放的块进入无锁的远程释放链表，由所属线程在下次分配时回收
+///			线程退出后对象池在最后一个块被释放时销毁
+////////////////////////////////////////////////////////////////////////////////
+class ObjectPool final
+	: public IObjectStorage
+{
+public:
+	static constexpr size_t SizeClassGranularity = alignof(std::max_align_t);
+	static constexpr size_t SizeClassCount = 16;
+	static constexpr size_t MaxBlockSize = SizeClassGranularity * SizeClassCount;
+	static constexpr size_t SlabSize = 64 * 1024;
+
+	/// @brief	获得当前线程的对象池
+	/// @return	若当前线程的对象池已被销毁则返回nullptr
+	static ObjectPool* GetThreadPool() noexcept;
+
+	/// @brief	获得容纳size字节大小的对象的大小类
+	/// @return	若超出最大块则返回SizeClassCount
+	static size_t GetSizeClass(size_t size) noexcept;
+
+	/// @brief	分配可容纳size字节大小的对象的块
+	/// @return	若超出最大块则返回nullptr
+	void* Allocate(size_t size);
+	void Deallocate(void* ptr) noexcept override;
+
+	PoolStatistics GetStatistics(size_t sizeClass) const noexcept;
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* Next;
+		size_t SizeClass;
+	};
+
+	struct SizeClassState
+	{
+		FreeBlock* FreeList;
+		nByte* Current;
+		nByte* End;
+		PoolStatistics Statistics;
+	};
+
+	class ThreadPoolHolder;
+
+	ObjectPool();
+	~ObjectPool();
+
+	void* AllocateSlow(size_t sizeClass);
+	void ReclaimRemoteBlocks(FreeBlock* list) noexcept;
+	void Orphan() noexcept;
+
+	std::atomic<FreeBlock*> m_RemoteFreeList;
+	std::atomic<std::ptrdiff_t> m_OrphanedLiveCount;
+	std::vector<void*> m_Slabs;
+	SizeClassState m_SizeClasses[SizeClassCount];
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	用于反射调用临时对象的线性分配区域
+/// @note	仅在ScratchScope的作用域内生效，作用域内创建的对象（包括使用对象池的装箱对象）均在当前块中顺序分配
+///			作用域结束时未被继续持有的块将被整块重置复用，逃逸出作用域的对象保持其所在的块存活直至其被释放
+///			逃逸的对象会令整个块无法复用，因此不应在作用域内创建需要长期持有的对象
+///			区域只能由一个线程使用，逃逸的对象可在任意线程释放
+////////////////////////////////////////////////////////////////////////////////
+class ScratchArena final
+{
+public:
+	static constexpr size_t DefaultChunkSize = 64 * 1024;
+
+	explicit ScratchArena(size_t chunkSize = DefaultChunkSize);
+	~ScratchArena();
+
+	ScratchArena(ScratchArena const&) = delete;
+	ScratchArena& operator=(ScratchArena const&) = delete;
+
+	/// @brief	获得当前线程的默认区域
+	static ScratchArena& GetThreadArena();
+
+	/// @brief	分配可容纳size字节大小的对象的内存
+	/// @note	超过块大小四分之一的对象直接由全局堆分配
+	void* Allocate(size_t size);
+
+	size_t GetChunkSize() const noexcept;
+	/// @brief	当前由区域持有的块数
+	size_t GetChunkCount() const noexcept;
+	/// @brief	因存在逃逸的对象而被交出的块的累计数量
+	size_t GetEscapedChunkCount() const noexcept;
+
+private:
+	friend class ScratchScope;
+	class Chunk;
+
+	void EndScope() noexcept;
+
+	size_t m_ChunkSize;
+	size_t m_Depth;
+	size_t m_Current;
+	size_t m_EscapedChunkCount;
+	std::vector<Chunk*> m_Chunks;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	在当前线程启用临时对象区域
+/// @note	可嵌套，同一区域的最外层作用域结束时统一回收
+////////////////////////////////////////////////////////////////////////////////
+class ScratchScope
+{
+public:
+	ScratchScope();
+	explicit ScratchScope(ScratchArena& arena) noexcept;
+	~ScratchScope();
+
+	ScratchScope(ScratchScope const&) = delete;
+	ScratchScope& operator=(ScratchScope const&) = delete;
+
+private:
+	ScratchArena* m_Arena;
+	ScratchArena* m_Previous;
+};
+
+// 令类型使用对象池分配，用于频繁创建的小对象
+#define USE_OBJECT_POOL static void* operator new(size_t size) { return rdetail_::AllocatePooledObject(size); }\
+static void operator delete(void* ptr) noexcept { rdetail_::DeallocateObject(ptr); }
@@ -13,6 +13,138 @@ namespace rdetail_
 
 	constexpr forward_call_t forward_call;
 
+	template <typename T>
+	T ThunkArg(void* arg) noexcept
+	{
+		return static_cast<T>(*static_cast<std::remove_reference_t<T>*>(arg));
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// @brief	由装箱的实参获得形参类型T的值
+	/// @note	Prepare返回的对象及Unbox返回的值均为所在调用表达式的临时对象，在调用结束前有效
+	////////////////////////////////////////////////////////////////////////////////
+	template <typename T, typename = void>
+	struct ArgumentCast
+	{
+		typedef std::remove_cv_t<std::remove_reference_t<T>> ValueType;
+
+		static bool CompatWith(std::type_index type) noexcept
+		{
+			return type == typeid(boxed_type_t<T>);
+		}
+
+		static natRefPointer<Object> Prepare(natRefPointer<Object> const& obj)
+		{
+			return Convert::ConvertTo<ValueType>(obj);
+		}
+
+		static ValueType& Unbox(natRefPointer<Object> const& obj)
+		{
+			return obj->Unbox<ValueType>();
+		}
+	};
+
+	// nStrView形参直接引用RefString或RefStringView的数据
+	template <typename T>
+	struct ArgumentCast<T, std::enable_if_t<std::is_same<T, nStrView>::value || std::is_same<T, nStrView const&>::value>>
+	{
+		static bool CompatWith(std::type_index type) noexcept
+		{
+			return type == typeid(RefStringView) || type == typeid(RefString);
+		}
+
+		static natRefPointer<Object> Prepare(natRefPointer<Object> const& obj)
+		{
+			return obj->GetType()->GetTypeIndex() == typeid(RefString) ? obj : Convert::ConvertTo<nStrView>(obj);
+		}
+
+		static nStrView Unbox(natRefPointer<Object> const& obj)
+		{
+			if (obj->GetType()->GetTypeIndex() == typeid(RefString))
+			{
+				return static_cast<RefString*>(obj.Get())->GetObj().GetView();
+			}
+			return obj->Unbox<nStrView>();
+		}
+	};
+
+	// nString需要持有数据，由RefStringView传入时在调用期间构造一次，由RefString传入时不复制
+	struct StringArgument
+	{
+		nString const* Reference;
+		nString Value;
+
+		operator nString const&() const noexcept
+		{
+			return Reference ? *Reference : Value;
+		}
+	};
+
+	template <typename T>
+	struct ArgumentCast<T, std::enable_if_t<std::is_same<T, nString>::value || std::is_same<T, nString const&>::value>>
+	{
+		static bool CompatWith(std::type_index type) noexcept
+		{
+			return type == typeid(RefString) || type == typeid(RefStringView);
+		}
+
+		static natRefPointer<Object> Prepare(natRefPointer<Object> const& obj)
+		{
+			return obj->GetType()->GetTypeIndex() == typeid(RefStringView) ? obj : Convert::ConvertTo<nString>(obj);
+		}
+
+		static StringArgument Unbox(natRefPointer<Object> const& obj)
+		{
+			if (obj->GetType()->GetTypeIndex() == typeid(RefStringView))
+			{
+				return { nullptr, nString{ static_cast<RefStringView*>(obj.Get())->GetObj() } };
+			}
+			return { &obj->Unbox<nString>(), {} };
+		}
+	};
+
+	template <typename Ret>
+	struct ThunkReturn
+	{
+		template <typename Func>
+		static void Store(void* ret, Func&& func)
+		{
+			::new(ret) Ret(func());
+		}
+	};
+
+	template <typename Ret>
+	struct ThunkReturn<Ret&>
+	{
+		template <typename Func>
+		static void Store(void* ret, Func&& func)
+		{
+			*static_cast<Ret**>(ret) = std::addressof(func());
+		}
+	};
+
+	template <typename Ret>
+	struct ThunkReturn<Ret&&>
+	{
+		template <typename Func>
+		static void Store(void* ret, Func&& func)
+		{
+			// std::addressof不接受右值，需先绑定到具名引用
+			auto&& result = func();
+			*static_cast<Ret**>(ret) = std::addressof(result);
+		}
+	};
+
+	template <>
+	struct ThunkReturn<void>
+	{
+		template <typename Func>
+		static void Store(void* /*ret*/, Func&& func)
+		{
+			func();
+		}
+	};
+
 	template <typename T, typename RetVoidTest = void>
 	struct InvokeNonMemberHelper
 	{
@@ -86,17 +218,29 @@ struct MethodHelper<Ret(*)(Args...)>
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		static_cast<void>(self);
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return method(rdetail_::ThunkArg<Args>(args[i])...); });
 	}
 };
 
@@ -131,17 +275,29 @@ struct MethodHelper<Ret(*)(rdetail_::forward_call_t, std::tuple<Args...>&&)>
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		static_cast<void>(self);
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return method(rdetail_::forward_call, std::forward_as_tuple(rdetail_::ThunkArg<Args>(args[i])...)); });
 	}
 };
 
@@ -169,7 +325,7 @@ struct MethodHelper<Ret(Class::*)(Args...)>
 
 	static bool CompatWith(natRefPointer<Object> object, ArgumentPack const& pack)
 	{
-		return object->GetType()->GetTypeIndex() == typeid(Class) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
+		return object->GetType()->GetTypeIndex() == typeid(boxed_type_t<Class>) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
 	}
 
 	static std::vector<natRefPointer<IType>> GetType()
@@ -177,17 +333,28 @@ struct MethodHelper<Ret(Class::*)(Args...)>
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Class>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(Class* object, MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(object, method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(object, method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return (static_cast<Class*>(self)->*method)(rdetail_::ThunkArg<Args>(args[i])...); });
 	}
 };
 
@@ -215,7 +382,7 @@ struct MethodHelper<Ret(Class::*)(rdetail_::forward_call_t, std::tuple<Args...>&
 
 	static bool CompatWith(natRefPointer<Object> object, ArgumentPack const& pack)
 	{
-		return object->GetType()->GetTypeIndex() == typeid(Class) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
+		return object->GetType()->GetTypeIndex() == typeid(boxed_type_t<Class>) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
 	}
 
 	static std::vector<natRefPointer<IType>> GetType()
@@ -223,17 +390,28 @@ struct MethodHelper<Ret(Class::*)(rdetail_::forward_call_t, std::tuple<Args...>&
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Class>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(Class* object, MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(object, method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(object, method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return (static_cast<Class*>(self)->*method)(rdetail_::forward_call, std::forward_as_tuple(rdetail_::ThunkArg<Args>(args[i])...)); });
 	}
 };
 
@@ -261,7 +439,7 @@ struct MethodHelper<Ret(Class::*)(Args...) const>
 
 	static bool CompatWith(natRefPointer<Object> object, ArgumentPack const& pack)
 	{
-		return object->GetType()->GetTypeIndex() == typeid(Class) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
+		return object->GetType()->GetTypeIndex() == typeid(boxed_type_t<Class>) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
 	}
 
 	static std::vector<natRefPointer<IType>> GetType()
@@ -269,17 +447,28 @@ struct MethodHelper<Ret(Class::*)(Args...) const>
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Class>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(const Class* object, MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(object, method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(object, method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return (static_cast<const Class*>(self)->*method)(rdetail_::ThunkArg<Args>(args[i])...); });
 	}
 };
 
@@ -307,7 +496,7 @@ struct MethodHelper<Ret(Class::*)(rdetail_::forward_call_t, std::tuple<Args...>&
 
 	static bool CompatWith(natRefPointer<Object> object, ArgumentPack const& pack)
 	{
-		return object->GetType()->GetTypeIndex() == typeid(Class) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
+		return object->GetType()->GetTypeIndex() == typeid(boxed_type_t<Class>) && CompatWithImpl(pack, std::make_index_sequence<sizeof...(Args)>{});
 	}
 
 	static std::vector<natRefPointer<IType>> GetType()
@@ -315,17 +504,28 @@ struct MethodHelper<Ret(Class::*)(rdetail_::forward_call_t, std::tuple<Args...>&
 		return{ Reflection::GetInstance().GetType<Ret>(), Reflection::GetInstance().GetType<Class>(), Reflection::GetInstance().GetType<Args>()... };
 	}
 
+	static void Thunk(const void* method, void* self, void* const* args, void* ret)
+	{
+		ThunkImpl(*static_cast<const MethodType*>(method), self, args, ret, std::make_index_sequence<sizeof...(Args)>{});
+	}
+
 private:
 	template <size_t... i>
 	static decltype(auto) InvokeWithArgPackHelper(const Class* object, MethodType method, ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return InvokeWithArgs(object, method, static_cast<Args>(Convert::ConvertTo<std::remove_cv_t<std::remove_reference_t<Args>>>(pack.Get(i))->Unbox<std::remove_cv_t<std::remove_reference_t<Args>>>())...);
+		return InvokeWithArgs(object, method, static_cast<Args>(rdetail_::ArgumentCast<Args>::Unbox(rdetail_::ArgumentCast<Args>::Prepare(pack.Get(i))))...);
 	}
 
 	template <size_t... i>
 	static bool CompatWithImpl(ArgumentPack const& pack, std::index_sequence<i...>)
 	{
-		return pack.Size() == sizeof...(i) && std::make_tuple((pack.GetType(i)->GetTypeIndex() == typeid(boxed_type_t<Args>))...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+		return pack.Size() == sizeof...(i) && std::make_tuple(rdetail_::ArgumentCast<Args>::CompatWith(pack.GetType(i)->GetTypeIndex())...) == std::make_tuple(std::bool_constant<i >= 0>::value...);
+	}
+
+	template <size_t... i>
+	static void ThunkImpl(MethodType method, void* self, void* const* args, void* ret, std::index_sequence<i...>)
+	{
+		rdetail_::ThunkReturn<Ret>::Store(ret, [&]() -> decltype(auto) { return (static_cast<const Class*>(self)->*method)(rdetail_::forward_call, std::forward_as_tuple(rdetail_::ThunkArg<Args>(args[i])...)); });
 	}
 };
 
@@ -379,6 +579,11 @@ public:
 		return m_Types.at(n + 1);
 	}
 
+	CallThunk GetThunk() const noexcept override
+	{
+		return{ &MethodHelper<MethodType>::Thunk, &m_Func };
+	}
+
 	MethodType Get() const noexcept
 	{
 		return m_Func;
@@ -465,6 +670,11 @@ public:
 		return m_IsVirtual;
 	}
 
+	CallThunk GetThunk() const noexcept override
+	{
+		return{ &MethodHelper<MethodType>::Thunk, &m_Func };
+	}
+
 	MethodType Get() const noexcept
 	{
 		return m_Func;
@@ -539,6 +749,11 @@ public:
 		return m_IsVirtual;
 	}
 
+	CallThunk GetThunk() const noexcept override
+	{
+		return{ &MethodHelper<MethodType>::Thunk, &m_Func };
+	}
+
 	MethodType Get() const noexcept
 	{
 		return m_Func;
@@ -1,9 +1,13 @@
 #pragma once
 #include "Interface.h"
+#include "Memory.h"
+#include "RefCount.h"
+#include "DirtyFields.h"
 
 template <typename Class, typename... Args, size_t... i>
 natRefPointer<Object> CommonConstructor(std::tuple<Args...>&& args, std::index_sequence<i...>)
 {
+	rdetail_::PrepareBatchSlot(typeid(Class));
 	return make_ref<Class>(std::forward<Args>(std::get<i>(args))...);
 }
 
@@ -12,6 +16,10 @@ struct Object
 {
 	virtual ~Object();
 
+	// 分配的内存前附带所有者头部，参见IObjectStorage
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr) noexcept;
+
 	static nStrView GetName() noexcept
 	{
 		return "Object"_nv;
@@ -19,7 +27,13 @@ struct Object
 
 	virtual natRefPointer<IType> GetType() const noexcept;
 	virtual nString ToString() const noexcept;
+	/// @brief	将与ToString相同的内容追加到output
+	/// @note	基本类型的装箱对象直接格式化到output中，在多次调用间复用output可避免分配内存
+	virtual void AppendString(nString& output) const;
 	virtual std::type_index GetUnboxedType();
+	/// @brief	获得对象的已修改字段集合，未启用修改跟踪时返回nullptr
+	/// @note	参见USE_DIRTY_TRACKING
+	virtual DirtyFieldSet* GetDirtyFieldSet() noexcept;
 
 	template <typename T>
 	T& Unbox();
@@ -39,7 +53,7 @@ struct Object
 	template <typename T>
 	static std::enable_if_t<!std::is_base_of<Object, T>::value, natRefPointer<Object>> Box(natRefPointer<T> const& ptr);
 
-	// ע
+	// 开洞注意
 	static natRefPointer<Object> Box(nStrView const& view)
 	{
 		return Box(nString{ view });
@@ -0,0 +1,574 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	constexpr size_t StringSlotSize = 2 * sizeof(std::uint32_t);
+	constexpr size_t ObjectSlotSize = sizeof(std::uint32_t);
+
+	std::uint32_t Load32(const nByte* data) noexcept
+	{
+		std::uint32_t result;
+		std::memcpy(&result, data, sizeof result);
+		return result;
+	}
+
+	// FNV-1a
+	std::uint32_t HashBytes(std::uint32_t hash, const void* data, size_t size) noexcept
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= static_cast<const nByte*>(data)[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	void* GetFieldAddress(ViewLayout::Slot const& slot, Object* object)
+	{
+		const auto offset = slot.Field->GetOffset();
+		return offset >= 0 ? reinterpret_cast<nByte*>(object) + offset : slot.Field->GetAddress(object);
+	}
+}
+
+ViewLayout::ViewLayout(natRefPointer<IType> type)
+	: m_Type{ std::move(type) }, m_RecordSize{ HeaderSize }, m_Signature{ 2166136261u }
+{
+	if (!m_Type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	if (m_Type->IsBoxed())
+	{
+		nat_Throw(ReflectionException, "Boxed type {0} cannot be viewed."_nv, m_Type->GetName());
+	}
+
+	m_DefaultConstructor = m_Type->GetConstructor({});
+
+	const auto layout = m_Type->GetRecordLayout();
+	const auto count = layout->GetFieldCount();
+	m_Slots.reserve(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto&& entry = layout->GetField(i);
+		const auto fieldType = entry.Field->GetFieldTypeIndex();
+
+		SlotKind kind;
+		size_t size;
+		if (entry.Pointer)
+		{
+			kind = SlotKind::Object;
+			size = ObjectSlotSize;
+		}
+		else if (fieldType == typeid(nString))
+		{
+			kind = SlotKind::String;
+			size = StringSlotSize;
+		}
+		else if (fieldType == typeid(bool))
+		{
+			kind = SlotKind::Bool;
+			size = 1;
+		}
+		else if (entry.Operations->TriviallyCopyable)
+		{
+			kind = SlotKind::Raw;
+			size = entry.Operations->Size;
+		}
+		else
+		{
+			nat_Throw(ReflectionException, "Member field {0} of type {1} cannot be viewed."_nv, entry.Name, m_Type->GetName());
+		}
+
+		m_Slots.push_back({ kind, entry.Name, m_RecordSize, size, entry.Field, entry.Operations });
+		m_RecordSize += size;
+
+		// 同时计入名称的长度，避免不同的字段组合得到相同的字节序列
+		const auto fieldTypeName = entry.Field->GetType()->GetName();
+		const std::uint32_t shape[] = { static_cast<std::uint32_t>(kind), static_cast<std::uint32_t>(size), static_cast<std::uint32_t>(entry.Name.size()), static_cast<std::uint32_t>(fieldTypeName.size()) };
+		m_Signature = HashBytes(m_Signature, shape, sizeof shape);
+		m_Signature = HashBytes(m_Signature, entry.Name.data(), entry.Name.size() * sizeof(nStrView::CharType));
+		m_Signature = HashBytes(m_Signature, fieldTypeName.data(), fieldTypeName.size() * sizeof(nStrView::CharType));
+	}
+}
+
+natRefPointer<ViewLayout> ViewLayout::Get(natRefPointer<IType> const& type)
+{
+	return rdetail_::GetCachedPlan<ViewLayout>(type);
+}
+
+natRefPointer<IType> const& ViewLayout::GetType() const noexcept
+{
+	return m_Type;
+}
+
+size_t ViewLayout::GetRecordSize() const noexcept
+{
+	return m_RecordSize;
+}
+
+std::uint32_t ViewLayout::GetSignature() const noexcept
+{
+	return m_Signature;
+}
+
+size_t ViewLayout::GetSlotCount() const noexcept
+{
+	return m_Slots.size();
+}
+
+ViewLayout::Slot const& ViewLayout::GetSlot(size_t n) const
+{
+	if (n >= m_Slots.size())
+	{
+		nat_Throw(ReflectionException, "Slot index {0} is out of range."_nv, n);
+	}
+
+	return m_Slots[n];
+}
+
+size_t ViewLayout::GetSlotIndex(nStrView name) const
+{
+	for (auto i = m_Slots.size(); i--;)
+	{
+		if (m_Slots[i].Name.GetView() == name)
+		{
+			return i;
+		}
+	}
+
+	nat_Throw(ReflectionException, "No such member field named {0}."_nv, name);
+}
+
+natRefPointer<Object> ViewLayout::CreateInstance() const
+{
+	return rdetail_::CreateDefaultInstance(m_DefaultConstructor, m_Type);
+}
+
+ViewWriter::ViewWriter()
+	: m_Buffer(ViewBuffer::HeaderSize), m_Finished{}
+{
+}
+
+size_t ViewWriter::Add(natRefPointer<Object> const& object)
+{
+	if (m_Finished)
+	{
+		nat_Throw(ReflectionException, "Writer has been finished."_nv);
+	}
+
+	// 以显式的栈代替递归，深层的对象图不会耗尽调用栈
+	std::vector<PendingObject> pending;
+	m_Roots.emplace_back(GetRecord(object.Get(), pending));
+	while (!pending.empty())
+	{
+		const auto current = pending.back();
+		pending.pop_back();
+
+		for (size_t i = 0, count = current.Layout->GetSlotCount(); i < count; ++i)
+		{
+			auto const& slot = current.Layout->GetSlot(i);
+			const auto address = static_cast<const nByte*>(GetFieldAddress(slot, current.Target));
+			const auto slotOffset = current.RecordOffset + slot.RecordOffset;
+			switch (slot.Kind)
+			{
+			case ViewLayout::SlotKind::Raw:
+				std::memcpy(m_Buffer.data() + slotOffset, address, slot.Size);
+				break;
+			case ViewLayout::SlotKind::Bool:
+				m_Buffer[slotOffset] = *reinterpret_cast<const bool*>(address) ? 1 : 0;
+				break;
+			case ViewLayout::SlotKind::String:
+			{
+				auto const& value = *reinterpret_cast<const nString*>(address);
+				const auto length = value.size() * sizeof(nStrView::CharType);
+				const auto stringOffset = AppendString(value);
+				Store32(slotOffset, stringOffset);
+				Store32(slotOffset + sizeof(std::uint32_t), static_cast<std::uint32_t>(length));
+				break;
+			}
+			case ViewLayout::SlotKind::Object:
+				Store32(slotOffset, GetRecord(slot.Operations->ReferencedObject(address), pending));
+				break;
+			}
+		}
+	}
+
+	return m_Roots.size() - 1;
+}
+
+std::vector<nByte> ViewWriter::Finish()
+{
+	if (m_Finished)
+	{
+		nat_Throw(ReflectionException, "Writer has been finished."_nv);
+	}
+
+	const auto typeTable = Allocate(sizeof(std::uint32_t));
+	Store32(typeTable, static_cast<std::uint32_t>(m_TypeList.size()));
+	for (auto const& type : m_TypeList)
+	{
+		const auto name = type->GetName();
+		const auto length = name.size() * sizeof(nStrView::CharType);
+		const auto offset = Allocate(3 * sizeof(std::uint32_t) + length);
+		auto const& layout = *m_Types[type.Get()].Layout;
+		Store32(offset, static_cast<std::uint32_t>(length));
+		std::memcpy(m_Buffer.data() + offset + sizeof(std::uint32_t), name.data(), length);
+		Store32(offset + sizeof(std::uint32_t) + length, static_cast<std::uint32_t>(layout.GetRecordSize()));
+		Store32(offset + 2 * sizeof(std::uint32_t) + length, layout.GetSignature());
+	}
+
+	const auto rootTable = Allocate(sizeof(std::uint32_t) * (m_Roots.size() + 1));
+	Store32(rootTable, static_cast<std::uint32_t>(m_Roots.size()));
+	std::memcpy(m_Buffer.data() + rootTable + sizeof(std::uint32_t), m_Roots.data(), sizeof(std::uint32_t) * m_Roots.size());
+
+	Store32(0, ViewBuffer::Magic);
+	Store32(sizeof(std::uint32_t), ViewBuffer::Version);
+	Store32(2 * sizeof(std::uint32_t), static_cast<std::uint32_t>(typeTable));
+	Store32(3 * sizeof(std::uint32_t), static_cast<std::uint32_t>(rootTable));
+
+	m_Finished = true;
+	m_Types.clear();
+	m_TypeList.clear();
+	m_Records.clear();
+	m_Roots.clear();
+	return std::move(m_Buffer);
+}
+
+void ViewWriter::Finish(natRefPointer<natStream> const& stream)
+{
+	if (!stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+
+	const auto buffer = Finish();
+	if (stream->WriteBytes(buffer.data(), buffer.size()) != buffer.size())
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+}
+
+std::uint32_t ViewWriter::GetRecord(Object* object, std::vector<PendingObject>& pending)
+{
+	if (!object)
+	{
+		return 0;
+	}
+
+	const auto iter = m_Records.find(object);
+	if (iter != m_Records.end())
+	{
+		return iter->second.Offset;
+	}
+
+	const auto type = object->GetType();
+	auto& entry = m_Types[type.Get()];
+	if (!entry.Layout)
+	{
+		entry.Layout = ViewLayout::Get(type);
+		entry.Index = static_cast<std::uint32_t>(m_TypeList.size());
+		m_TypeList.emplace_back(type);
+	}
+
+	const auto offset = Allocate(entry.Layout->GetRecordSize());
+	Store32(offset, entry.Index);
+	m_Records.emplace(object, RecordEntry{ static_cast<std::uint32_t>(offset), natRefPointer<Object>{ object } });
+	pending.push_back({ object, entry.Layout.Get(), offset });
+	return static_cast<std::uint32_t>(offset);
+}
+
+std::uint32_t ViewWriter::AppendString(nStrView value)
+{
+	const auto length = value.size() * sizeof(nStrView::CharType);
+	const auto offset = Allocate(length);
+	std::memcpy(m_Buffer.data() + offset, value.data(), length);
+	return static_cast<std::uint32_t>(offset);
+}
+
+size_t ViewWriter::Allocate(size_t size)
+{
+	const auto offset = m_Buffer.size();
+	if (size > std::numeric_limits<std::uint32_t>::max() - offset)
+	{
+		nat_Throw(ReflectionException, "View buffer exceeds 4GiB."_nv);
+	}
+
+	m_Buffer.resize(offset + size);
+	return offset;
+}
+
+void ViewWriter::Store32(size_t offset, std::uint32_t value) noexcept
+{
+	std::memcpy(m_Buffer.data() + offset, &value, sizeof value);
+}
+
+ObjectView::ObjectView() noexcept
+	: m_Buffer{}, m_Layout{}, m_Record{}
+{
+}
+
+ObjectView::ObjectView(ViewBuffer const* buffer, ViewLayout const* layout, const nByte* record) noexcept
+	: m_Buffer{ buffer }, m_Layout{ layout }, m_Record{ record }
+{
+}
+
+bool ObjectView::IsNull() const noexcept
+{
+	return !m_Record;
+}
+
+ObjectView::operator bool() const noexcept
+{
+	return m_Record != nullptr;
+}
+
+natRefPointer<IType> const& ObjectView::GetType() const
+{
+	return GetLayout().GetType();
+}
+
+ViewLayout const& ObjectView::GetLayout() const
+{
+	if (!m_Layout)
+	{
+		nat_Throw(NullPointerException, "View is null."_nv);
+	}
+
+	return *m_Layout;
+}
+
+size_t ObjectView::GetFieldIndex(nStrView name) const
+{
+	return GetLayout().GetSlotIndex(name);
+}
+
+template <>
+bool ObjectView::Read<bool>(size_t index) const
+{
+	return *GetValue(index, typeid(bool)) != 0;
+}
+
+nStrView ObjectView::ReadString(size_t index) const
+{
+	auto const& slot = GetSlot(index, ViewLayout::SlotKind::String);
+	const auto value = m_Record + slot.RecordOffset;
+	return m_Buffer->GetString(Load32(value), Load32(value + sizeof(std::uint32_t)));
+}
+
+nStrView ObjectView::ReadString(nStrView name) const
+{
+	return ReadString(GetFieldIndex(name));
+}
+
+ObjectView ObjectView::ReadObject(size_t index) const
+{
+	auto const& slot = GetSlot(index, ViewLayout::SlotKind::Object);
+	return m_Buffer->GetView(Load32(m_Record + slot.RecordOffset));
+}
+
+ObjectView ObjectView::ReadObject(nStrView name) const
+{
+	return ReadObject(GetFieldIndex(name));
+}
+
+natRefPointer<Object> ObjectView::Construct() const
+{
+	if (IsNull())
+	{
+		return {};
+	}
+
+	std::unordered_map<const nByte*, natRefPointer<Object>> created;
+	std::vector<ObjectView> pending;
+	const auto getObject = [&](ObjectView const& view)
+	{
+		auto& object = created[view.m_Record];
+		if (!object)
+		{
+			object = view.m_Layout->CreateInstance();
+			pending.emplace_back(view);
+		}
+		return object;
+	};
+
+	auto result = getObject(*this);
+	while (!pending.empty())
+	{
+		const auto current = pending.back();
+		pending.pop_back();
+
+		const auto& object = created[current.m_Record];
+		for (size_t i = 0, count = current.m_Layout->GetSlotCount(); i < count; ++i)
+		{
+			auto const& slot = current.m_Layout->GetSlot(i);
+			const auto value = current.m_Record + slot.RecordOffset;
+			switch (slot.Kind)
+			{
+			case ViewLayout::SlotKind::Raw:
+				std::memcpy(GetFieldAddress(slot, object.Get()), value, slot.Size);
+				break;
+			case ViewLayout::SlotKind::Bool:
+				*static_cast<bool*>(GetFieldAddress(slot, object.Get())) = *value != 0;
+				break;
+			case ViewLayout::SlotKind::String:
+				*static_cast<nString*>(GetFieldAddress(slot, object.Get())) = m_Buffer->GetString(Load32(value), Load32(value + sizeof(std::uint32_t)));
+				break;
+			case ViewLayout::SlotKind::Object:
+			{
+				const auto child = m_Buffer->GetView(Load32(value));
+				slot.Field->WriteFrom(object, child ? getObject(child) : natRefPointer<Object>{});
+				break;
+			}
+			}
+		}
+	}
+
+	for (auto const& item : created)
+	{
+		DirtyTracking::Clear(item.second.Get());
+	}
+
+	return result;
+}
+
+ViewLayout::Slot const& ObjectView::GetSlot(size_t index, ViewLayout::SlotKind kind) const
+{
+	auto const& slot = GetLayout().GetSlot(index);
+	if (slot.Kind != kind)
+	{
+		nat_Throw(ReflectionException, "Type wrong."_nv);
+	}
+
+	return slot;
+}
+
+const nByte* ObjectView::GetValue(size_t index, std::type_index type) const
+{
+	auto const& slot = GetLayout().GetSlot(index);
+	if ((slot.Kind != ViewLayout::SlotKind::Raw && slot.Kind != ViewLayout::SlotKind::Bool) || slot.Field->GetFieldTypeIndex() != type)
+	{
+		nat_Throw(ReflectionException, "Type wrong."_nv);
+	}
+
+	return m_Record + slot.RecordOffset;
+}
+
+ViewBuffer::ViewBuffer(const void* data, size_t size, natRefPointer<natRefObj> owner)
+	: m_Data{ static_cast<const nByte*>(data) }, m_Size{ size }, m_Owner{ std::move(owner) }, m_RootTable{}, m_RootCount{}
+{
+	if (!m_Data && m_Size)
+	{
+		nat_Throw(NullPointerException, "Data is nullptr."_nv);
+	}
+
+	if (m_Size < HeaderSize || Load32(0) != Magic)
+	{
+		nat_Throw(ReflectionException, "Data is not a view buffer."_nv);
+	}
+
+	if (Load32(sizeof(std::uint32_t)) != Version)
+	{
+		nat_Throw(ReflectionException, "Unsupported view buffer version {0}."_nv, Load32(sizeof(std::uint32_t)));
+	}
+
+	auto position = static_cast<size_t>(Load32(2 * sizeof(std::uint32_t)));
+	const auto typeCount = Load32(position);
+	position += sizeof(std::uint32_t);
+	m_Layouts.reserve(std::min<size_t>(typeCount, m_Size / sizeof(std::uint32_t)));
+	for (std::uint32_t i = 0; i < typeCount; ++i)
+	{
+		const auto length = Load32(position);
+		const auto name = GetString(static_cast<std::uint32_t>(position + sizeof(std::uint32_t)), length);
+		position += sizeof(std::uint32_t) + length;
+		auto layout = ViewLayout::Get(Reflection::GetInstance().GetType(name));
+		// 槽的位置由当前的类型元数据决定，字段改变后的缓冲区无法正确读取
+		if (Load32(position) != layout->GetRecordSize() || Load32(position + sizeof(std::uint32_t)) != layout->GetSignature())
+		{
+			nat_Throw(ReflectionException, "Fields of type {0} do not match the view buffer."_nv, name);
+		}
+		m_Layouts.emplace_back(std::move(layout));
+		position += 2 * sizeof(std::uint32_t);
+	}
+
+	m_RootTable = Load32(3 * sizeof(std::uint32_t));
+	m_RootCount = Load32(m_RootTable);
+	if (m_RootCount > (m_Size - m_RootTable) / sizeof(std::uint32_t) - 1)
+	{
+		nat_Throw(ReflectionException, "Root table is out of range."_nv);
+	}
+}
+
+ViewBuffer::ViewBuffer(natRefPointer<natMemoryStream> const& stream)
+	: ViewBuffer{ stream ? stream->GetInternalBuffer() : nullptr, stream ? static_cast<size_t>(stream->GetSize()) : 0, stream }
+{
+}
+
+const nByte* ViewBuffer::GetData() const noexcept
+{
+	return m_Data;
+}
+
+size_t ViewBuffer::GetSize() const noexcept
+{
+	return m_Size;
+}
+
+size_t ViewBuffer::GetRootCount() const noexcept
+{
+	return m_RootCount;
+}
+
+ObjectView ViewBuffer::GetRoot(size_t n) const
+{
+	if (n >= m_RootCount)
+	{
+		nat_Throw(ReflectionException, "Root index {0} is out of range."_nv, n);
+	}
+
+	return GetView(Load32(m_RootTable + (n + 1) * sizeof(std::uint32_t)));
+}
+
+ObjectView ViewBuffer::GetView(std::uint32_t offset) const
+{
+	if (!offset)
+	{
+		return {};
+	}
+
+	const auto typeIndex = Load32(offset);
+	if (typeIndex >= m_Layouts.size())
+	{
+		nat_Throw(ReflectionException, "Invalid type index {0}."_nv, typeIndex);
+	}
+
+	const auto layout = m_Layouts[typeIndex].Get();
+	if (layout->GetRecordSize() > m_Size - offset)
+	{
+		nat_Throw(ReflectionException, "Record at {0} is out of range."_nv, offset);
+	}
+
+	return { this, layout, m_Data + offset };
+}
+
+nStrView ViewBuffer::GetString(std::uint32_t offset, std::uint32_t length) const
+{
+	if (offset > m_Size || length > m_Size - offset || length % sizeof(nStrView::CharType))
+	{
+		nat_Throw(ReflectionException, "String at {0} is out of range."_nv, offset);
+	}
+
+	return { reinterpret_cast<const nStrView::CharType*>(m_Data + offset), length / sizeof(nStrView::CharType) };
+}
+
+std::uint32_t ViewBuffer::Load32(size_t offset) const
+{
+	if (offset > m_Size || m_Size - offset < sizeof(std::uint32_t))
+	{
+		nat_Throw(ReflectionException, "Offset {0} is out of range."_nv, offset);
+	}
+
+	return ::Load32(m_Data + offset);
+}
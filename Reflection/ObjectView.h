@@ -0,0 +1,237 @@
+#pragma once
+#include "Interface.h"
+#include <natStream.h>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+class ObjectView;
+class ViewBuffer;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型在视图格式中的记录布局
+/// @note	记录以4字节的类型序号开头，之后按RecordLayout的顺序无填充地存放各字段的槽
+///			可平凡复制的字段的槽为其原生字节，bool为1字节
+///			nString的槽为4字节偏移及4字节长度，natRefPointer字段的槽为所指向记录的4字节偏移，0表示nullptr
+///			槽的位置仅由类型元数据决定，因此不写入缓冲区，缓冲区中仅记录布局的签名以检查读写双方的字段是否一致
+////////////////////////////////////////////////////////////////////////////////
+class ViewLayout final
+	: public natRefObjImpl<ViewLayout, Interface>
+{
+public:
+	enum class SlotKind
+	{
+		Raw,
+		Bool,
+		String,
+		Object,
+	};
+
+	struct Slot
+	{
+		SlotKind Kind;
+		nString Name;
+		/// @brief	槽在记录中的偏移
+		size_t RecordOffset;
+		size_t Size;
+		natRefPointer<IMemberField> Field;
+		ValueOperations const* Operations;
+	};
+
+	static constexpr size_t HeaderSize = sizeof(std::uint32_t);
+
+	/// @brief	若类型为装箱类型或存在无法放入视图的字段则抛出ReflectionException
+	explicit ViewLayout(natRefPointer<IType> type);
+
+	/// @brief	获得类型的布局，首次获得时生成
+	static natRefPointer<ViewLayout> Get(natRefPointer<IType> const& type);
+
+	natRefPointer<IType> const& GetType() const noexcept;
+	/// @brief	记录的总大小，包括类型序号
+	size_t GetRecordSize() const noexcept;
+	/// @brief	由各槽的名称、字段类型、种类及大小计算的哈希值
+	std::uint32_t GetSignature() const noexcept;
+	size_t GetSlotCount() const noexcept;
+	Slot const& GetSlot(size_t n) const;
+	/// @brief	按名称查找字段，同名时优先匹配派生类的字段
+	/// @note	找不到时抛出ReflectionException
+	size_t GetSlotIndex(nStrView name) const;
+
+	/// @brief	以无参构造函数创建用于物化的对象
+	/// @note	类型没有注册无参构造函数时抛出ReflectionException
+	natRefPointer<Object> CreateInstance() const;
+
+private:
+	natRefPointer<IType> m_Type;
+	std::vector<Slot> m_Slots;
+	size_t m_RecordSize;
+	std::uint32_t m_Signature;
+	natRefPointer<IMethod> m_DefaultConstructor;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	将对象图编码为可被ObjectView直接读取的缓冲区
+/// @note	缓冲区依次为头部、各对象记录及字符串、类型表及根对象表，所有偏移均相对于缓冲区开头
+///			类型表的每项为类型名、记录大小及布局签名
+///			同一对象只编码一次，共享及循环引用在视图中保持原有结构
+///			数值按原生字节序存放，缓冲区大小不能超过4GiB
+////////////////////////////////////////////////////////////////////////////////
+class ViewWriter final
+{
+public:
+	ViewWriter();
+
+	ViewWriter(ViewWriter const&) = delete;
+	ViewWriter& operator=(ViewWriter const&) = delete;
+
+	/// @brief	添加根对象
+	/// @return	根对象的序号
+	size_t Add(natRefPointer<Object> const& object);
+
+	/// @brief	完成编码并取出缓冲区，之后不能再添加对象
+	std::vector<nByte> Finish();
+	/// @brief	完成编码并将缓冲区写入流
+	void Finish(natRefPointer<natStream> const& stream);
+
+private:
+	struct TypeEntry
+	{
+		std::uint32_t Index;
+		natRefPointer<ViewLayout> Layout;
+	};
+
+	/// @brief	持有已编码的对象，以免其地址被复用后与其他对象混淆
+	struct RecordEntry
+	{
+		std::uint32_t Offset;
+		natRefPointer<Object> Target;
+	};
+
+	struct PendingObject
+	{
+		Object* Target;
+		ViewLayout const* Layout;
+		size_t RecordOffset;
+	};
+
+	/// @brief	获得对象记录的偏移，对象首次出现时为其分配记录
+	std::uint32_t GetRecord(Object* object, std::vector<PendingObject>& pending);
+	std::uint32_t AppendString(nStrView value);
+	size_t Allocate(size_t size);
+	void Store32(size_t offset, std::uint32_t value) noexcept;
+
+	std::vector<nByte> m_Buffer;
+	std::unordered_map<IType*, TypeEntry> m_Types;
+	std::vector<natRefPointer<IType>> m_TypeList;
+	std::unordered_map<Object*, RecordEntry> m_Records;
+	std::vector<std::uint32_t> m_Roots;
+	bool m_Finished;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对象的只读视图，直接读取缓冲区中的字段而不创建对象
+/// @note	视图不持有缓冲区，在其所属的ViewBuffer销毁后不能再使用
+///			字段以序号或名称访问，频繁访问时应先以GetFieldIndex获得序号
+////////////////////////////////////////////////////////////////////////////////
+class ObjectView final
+{
+public:
+	ObjectView() noexcept;
+
+	bool IsNull() const noexcept;
+	explicit operator bool() const noexcept;
+
+	natRefPointer<IType> const& GetType() const;
+	ViewLayout const& GetLayout() const;
+	size_t GetFieldIndex(nStrView name) const;
+
+	/// @brief	读取可平凡复制的字段
+	/// @note	T需与字段类型一致，否则抛出ReflectionException
+	template <typename T>
+	T Read(size_t index) const;
+	template <typename T>
+	T Read(nStrView name) const
+	{
+		return Read<T>(GetFieldIndex(name));
+	}
+
+	/// @brief	读取nString字段，返回的视图指向缓冲区
+	nStrView ReadString(size_t index) const;
+	nStrView ReadString(nStrView name) const;
+
+	/// @brief	获得natRefPointer字段所指向对象的视图
+	ObjectView ReadObject(size_t index) const;
+	ObjectView ReadObject(nStrView name) const;
+
+	/// @brief	物化对象及其引用的所有对象
+	/// @note	对象以无参构造函数创建后逐字段写入，共享及循环引用保持原有结构
+	natRefPointer<Object> Construct() const;
+
+private:
+	friend class ViewBuffer;
+
+	ObjectView(ViewBuffer const* buffer, ViewLayout const* layout, const nByte* record) noexcept;
+
+	ViewLayout::Slot const& GetSlot(size_t index, ViewLayout::SlotKind kind) const;
+	const nByte* GetValue(size_t index, std::type_index type) const;
+
+	ViewBuffer const* m_Buffer;
+	ViewLayout const* m_Layout;
+	const nByte* m_Record;
+};
+
+template <typename T>
+T ObjectView::Read(size_t index) const
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T should be trivially copyable.");
+
+	T result;
+	std::memcpy(&result, GetValue(index, typeid(T)), sizeof(T));
+	return result;
+}
+
+template <>
+bool ObjectView::Read<bool>(size_t index) const;
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	由ViewWriter生成的缓冲区
+/// @note	可以是映射到内存的文件或任意字节区间，不会复制其内容
+///			构造时检查头部、类型表及根对象表，读取时检查所访问的记录及字符串是否越界
+///			类型的字段与写入时不同导致记录大小或布局签名不一致时同样视为数据不合法
+///			数据不合法时抛出ReflectionException
+////////////////////////////////////////////////////////////////////////////////
+class ViewBuffer final
+	: public natRefObjImpl<ViewBuffer, Interface>
+{
+public:
+	static constexpr std::uint32_t Magic = 0x564F4652; // "RFOV"
+	static constexpr std::uint32_t Version = 2;
+	static constexpr size_t HeaderSize = 4 * sizeof(std::uint32_t);
+
+	/// @param	data	需在ViewBuffer及其视图的生命周期内保持有效
+	/// @param	owner	持有data的对象，可为nullptr
+	ViewBuffer(const void* data, size_t size, natRefPointer<natRefObj> owner = {});
+	/// @brief	直接使用内存流的内部缓冲区，流在此期间不能被写入
+	explicit ViewBuffer(natRefPointer<natMemoryStream> const& stream);
+
+	const nByte* GetData() const noexcept;
+	size_t GetSize() const noexcept;
+
+	size_t GetRootCount() const noexcept;
+	ObjectView GetRoot(size_t n) const;
+
+	/// @brief	获得偏移处记录的视图，偏移为0时返回空视图
+	ObjectView GetView(std::uint32_t offset) const;
+	nStrView GetString(std::uint32_t offset, std::uint32_t length) const;
+
+private:
+	std::uint32_t Load32(size_t offset) const;
+
+	const nByte* m_Data;
+	size_t m_Size;
+	natRefPointer<natRefObj> m_Owner;
+	std::vector<natRefPointer<ViewLayout>> m_Layouts;
+	size_t m_RootTable;
+	size_t m_RootCount;
+};
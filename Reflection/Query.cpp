@@ -0,0 +1,301 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+namespace
+{
+	template <typename T>
+	size_t FilterSelection(IMemberField* field, std::ptrdiff_t offset, CompareOp op, T operand,
+		natRefPointer<Object> const* objects, std::uint32_t* selection, size_t count, std::vector<std::int64_t>& buffer)
+	{
+		// buffer的前半部分存放值，后半部分存放ColumnKernels::Filter选出的序号
+		const auto values = reinterpret_cast<T*>(buffer.data());
+		const auto matched = reinterpret_cast<std::uint32_t*>(buffer.data() + Query::BatchSize);
+		if (offset < 0)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = *static_cast<const T*>(field->GetAddress(objects[selection[i]].Get()));
+			}
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				values[i] = *reinterpret_cast<const T*>(reinterpret_cast<const nByte*>(objects[selection[i]].Get()) + offset);
+			}
+		}
+
+		const auto result = ColumnKernels::Filter(values, count, op, operand, matched);
+		// matched[i] >= i，可以原地写回
+		for (size_t i = 0; i < result; ++i)
+		{
+			selection[i] = selection[matched[i]];
+		}
+
+		return result;
+	}
+
+	template <typename T>
+	auto MakeCompareStage(natRefPointer<IMemberField> const& field, CompareOp op, T operand)
+	{
+		const auto offset = field->GetOffset();
+		return [field, offset, op, operand](natRefPointer<Object> const* objects, std::uint32_t* selection, size_t count, std::vector<std::int64_t>& buffer)
+		{
+			return FilterSelection(field.Get(), offset, op, operand, objects, selection, count, buffer);
+		};
+	}
+}
+
+size_t QueryResult::GetSize() const noexcept
+{
+	return m_Indices.size();
+}
+
+std::vector<size_t> const& QueryResult::GetIndices() const noexcept
+{
+	return m_Indices;
+}
+
+std::vector<natRefPointer<Object>> const& QueryResult::GetObjects() const noexcept
+{
+	return m_Objects;
+}
+
+size_t QueryResult::GetColumnCount() const noexcept
+{
+	return m_Columns.size();
+}
+
+FieldColumn const& QueryResult::GetColumn(size_t n) const
+{
+	if (n >= m_Columns.size())
+	{
+		nat_Throw(ReflectionException, "Column index {0} is out of range."_nv, n);
+	}
+
+	return m_Columns[n].second;
+}
+
+FieldColumn const& QueryResult::GetColumn(nStrView name) const
+{
+	const auto iter = std::find_if(m_Columns.begin(), m_Columns.end(), [name](auto const& column)
+	{
+		return column.first.GetView() == name;
+	});
+	if (iter == m_Columns.end())
+	{
+		nat_Throw(ReflectionException, "No such column named {0}."_nv, name);
+	}
+
+	return iter->second;
+}
+
+Query::Query(natRefPointer<IType> type)
+	: m_Type{ std::move(type) }
+{
+	if (!m_Type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+}
+
+natRefPointer<IType> const& Query::GetType() const noexcept
+{
+	return m_Type;
+}
+
+Query& Query::Select(nStrView fieldName)
+{
+	auto field = FindField(fieldName);
+	// 构造空列以验证字段类型
+	FieldColumn{ field, nullptr, 0 };
+	m_Projections.emplace_back(nString{ fieldName }, std::move(field));
+	return *this;
+}
+
+QueryResult Query::Execute(natRefPointer<Object> const* objects, size_t count, bool parallel) const
+{
+	QueryResult result;
+
+	const auto hardwareThreads = static_cast<size_t>(std::thread::hardware_concurrency());
+	if (parallel && count >= ParallelThreshold && hardwareThreads > 1)
+	{
+		// 按批的边界分段，最后一段由当前线程执行
+		const auto batchCount = (count + BatchSize - 1) / BatchSize;
+		const auto threadCount = std::min(hardwareThreads, batchCount);
+		const auto batchesPerThread = (batchCount + threadCount - 1) / threadCount;
+		std::vector<std::vector<size_t>> partIndices(threadCount);
+		std::vector<std::exception_ptr> exceptions(threadCount);
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+
+		const auto runPart = [&](size_t part)
+		{
+			try
+			{
+				const auto begin = std::min(count, part * batchesPerThread * BatchSize);
+				const auto end = std::min(count, begin + batchesPerThread * BatchSize);
+				ExecuteRange(objects, begin, end, partIndices[part]);
+			}
+			catch (...)
+			{
+				exceptions[part] = std::current_exception();
+			}
+		};
+
+		for (size_t i = 0; i + 1 < threadCount; ++i)
+		{
+			threads.emplace_back(runPart, i);
+		}
+		runPart(threadCount - 1);
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+
+		for (auto const& exception : exceptions)
+		{
+			if (exception)
+			{
+				std::rethrow_exception(exception);
+			}
+		}
+
+		size_t total = 0;
+		for (auto const& indices : partIndices)
+		{
+			total += indices.size();
+		}
+		result.m_Indices.reserve(total);
+		for (auto const& indices : partIndices)
+		{
+			result.m_Indices.insert(result.m_Indices.end(), indices.begin(), indices.end());
+		}
+	}
+	else
+	{
+		ExecuteRange(objects, 0, count, result.m_Indices);
+	}
+
+	result.m_Objects.reserve(result.m_Indices.size());
+	for (const auto index : result.m_Indices)
+	{
+		result.m_Objects.emplace_back(objects[index]);
+	}
+
+	result.m_Columns.reserve(m_Projections.size());
+	for (auto const& projection : m_Projections)
+	{
+		result.m_Columns.emplace_back(projection.first, FieldColumn{ projection.second, result.m_Objects.data(), result.m_Objects.size() });
+	}
+
+	return result;
+}
+
+QueryResult Query::Execute(std::vector<natRefPointer<Object>> const& objects, bool parallel) const
+{
+	return Execute(objects.data(), objects.size(), parallel);
+}
+
+natRefPointer<IMemberField> Query::FindField(nStrView fieldName) const
+{
+	// 依次在类型及其基类中查找
+	std::vector<natRefPointer<IType>> pending{ m_Type };
+	while (!pending.empty())
+	{
+		const auto type = std::move(pending.back());
+		pending.pop_back();
+
+		const auto count = type->GetMemberFieldCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (type->GetMemberFieldName(i) == fieldName)
+			{
+				return type->GetMemberFieldByIndex(i);
+			}
+		}
+
+		for (auto&& baseClass : type->GetBaseClasses())
+		{
+			pending.emplace_back(baseClass);
+		}
+	}
+
+	nat_Throw(ReflectionException, "No such member field named {0}."_nv, fieldName);
+}
+
+Query& Query::WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, std::int32_t operand)
+{
+	m_Stages.emplace_back(MakeCompareStage(field, op, operand));
+	return *this;
+}
+
+Query& Query::WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, std::int64_t operand)
+{
+	m_Stages.emplace_back(MakeCompareStage(field, op, operand));
+	return *this;
+}
+
+Query& Query::WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, float operand)
+{
+	m_Stages.emplace_back(MakeCompareStage(field, op, operand));
+	return *this;
+}
+
+Query& Query::WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, double operand)
+{
+	m_Stages.emplace_back(MakeCompareStage(field, op, operand));
+	return *this;
+}
+
+void Query::ExecuteRange(natRefPointer<Object> const* objects, size_t begin, size_t end, std::vector<size_t>& indices) const
+{
+	std::uint32_t selection[BatchSize];
+	// 前BatchSize个元素存放值，之后存放序号
+	std::vector<std::int64_t> buffer(BatchSize + BatchSize / 2);
+	// 集合中的对象通常类型相同，仅在类型变化时重新检查
+	IType* checkedType{};
+
+	for (auto batchBegin = begin; batchBegin < end; batchBegin += BatchSize)
+	{
+		const auto batch = objects + batchBegin;
+		auto count = std::min(BatchSize, end - batchBegin);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!batch[i])
+			{
+				nat_Throw(NullPointerException, "Object at index {0} is nullptr."_nv, batchBegin + i);
+			}
+
+			const auto type = batch[i]->GetType();
+			if (type.Get() != checkedType)
+			{
+				if (!type->Equal(m_Type.Get()) && !type->IsExtendFrom(m_Type))
+				{
+					nat_Throw(ReflectionException, "Object at index {0} of type {1} is not a {2}."_nv, batchBegin + i, type->GetName(), m_Type->GetName());
+				}
+
+				checkedType = type.Get();
+			}
+
+			selection[i] = static_cast<std::uint32_t>(i);
+		}
+
+		for (auto const& stage : m_Stages)
+		{
+			if (!count)
+			{
+				break;
+			}
+
+			count = stage(batch, selection, count, buffer);
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			indices.emplace_back(batchBegin + selection[i]);
+		}
+	}
+}
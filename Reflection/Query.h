@@ -0,0 +1,124 @@
+#pragma once
+#include "Column.h"
+#include <functional>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	查询的结果
+/// @note	结果按对象在源集合中的顺序排列
+////////////////////////////////////////////////////////////////////////////////
+class QueryResult final
+{
+public:
+	size_t GetSize() const noexcept;
+
+	/// @brief	满足条件的对象在源集合中的序号
+	std::vector<size_t> const& GetIndices() const noexcept;
+	std::vector<natRefPointer<Object>> const& GetObjects() const noexcept;
+
+	/// @brief	获得由Select指定的投影列，顺序与调用Select的顺序一致
+	size_t GetColumnCount() const noexcept;
+	FieldColumn const& GetColumn(size_t n) const;
+	FieldColumn const& GetColumn(nStrView name) const;
+
+private:
+	friend class Query;
+
+	std::vector<size_t> m_Indices;
+	std::vector<natRefPointer<Object>> m_Objects;
+	std::vector<std::pair<nString, FieldColumn>> m_Columns;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对某一类型的对象集合进行过滤及投影的查询
+/// @note	条件在添加时即针对类型的成员字段完成解析，执行时直接通过偏移访问对象，不进行装箱
+///			执行时按BatchSize分批依次应用各条件，每个条件只处理前一条件选出的对象
+///			对象必须为查询的类型或其派生类型，否则执行时抛出ReflectionException
+////////////////////////////////////////////////////////////////////////////////
+class Query final
+{
+public:
+	/// @brief	每批处理的对象个数
+	static constexpr size_t BatchSize = 1024;
+	/// @brief	对象个数不小于此值时才会并行执行
+	static constexpr size_t ParallelThreshold = 65536;
+
+	explicit Query(natRefPointer<IType> type);
+
+	natRefPointer<IType> const& GetType() const noexcept;
+
+	/// @brief	添加条件field op operand
+	/// @note	字段类型需为int32_t、int64_t、float或double，operand将被转换为字段类型，比较使用ColumnKernels
+	template <typename U>
+	Query& Where(nStrView fieldName, CompareOp op, U operand)
+	{
+		const auto field = FindField(fieldName);
+		const auto type = field->GetFieldTypeIndex();
+		if (type == typeid(std::int32_t))
+		{
+			return WhereCompare(field, op, static_cast<std::int32_t>(operand));
+		}
+		if (type == typeid(std::int64_t))
+		{
+			return WhereCompare(field, op, static_cast<std::int64_t>(operand));
+		}
+		if (type == typeid(float))
+		{
+			return WhereCompare(field, op, static_cast<float>(operand));
+		}
+		if (type == typeid(double))
+		{
+			return WhereCompare(field, op, static_cast<double>(operand));
+		}
+
+		nat_Throw(ReflectionException, "Member field {0} cannot be compared by column kernels."_nv, fieldName);
+	}
+
+	/// @brief	添加以谓词判断字段值的条件
+	/// @tparam	T			字段类型，需与字段的实际类型一致
+	/// @param	predicate	以T const&为参数返回bool的可调用对象，可能被多个线程同时调用
+	template <typename T, typename Predicate>
+	Query& Where(nStrView fieldName, Predicate predicate)
+	{
+		FieldRef<const T> ref{ FindField(fieldName) };
+		m_Stages.emplace_back([ref = std::move(ref), predicate = std::move(predicate)](natRefPointer<Object> const* objects, std::uint32_t* selection, size_t count, std::vector<std::int64_t>&)
+		{
+			size_t result = 0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (predicate(ref.Get(objects[selection[i]])))
+				{
+					selection[result++] = selection[i];
+				}
+			}
+			return result;
+		});
+
+		return *this;
+	}
+
+	/// @brief	将字段投影为结果中的列
+	/// @note	字段类型需为FieldColumn支持的类型
+	Query& Select(nStrView fieldName);
+
+	/// @param	parallel	是否允许在对象个数较多时分段并行执行
+	QueryResult Execute(natRefPointer<Object> const* objects, size_t count, bool parallel = true) const;
+	QueryResult Execute(std::vector<natRefPointer<Object>> const& objects, bool parallel = true) const;
+
+private:
+	/// @brief	过滤一批对象中selection所选出的对象
+	/// @return	保留的对象个数，保留的序号依次写回selection
+	typedef std::function<size_t(natRefPointer<Object> const* objects, std::uint32_t* selection, size_t count, std::vector<std::int64_t>& buffer)> Stage;
+
+	natRefPointer<IMemberField> FindField(nStrView fieldName) const;
+
+	Query& WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, std::int32_t operand);
+	Query& WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, std::int64_t operand);
+	Query& WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, float operand);
+	Query& WhereCompare(natRefPointer<IMemberField> const& field, CompareOp op, double operand);
+
+	void ExecuteRange(natRefPointer<Object> const* objects, size_t begin, size_t end, std::vector<size_t>& indices) const;
+
+	natRefPointer<IType> m_Type;
+	std::vector<Stage> m_Stages;
+	std::vector<std::pair<nString, natRefPointer<IMemberField>>> m_Projections;
+};
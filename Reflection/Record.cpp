@@ -0,0 +1,564 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	size_t HashCombine(size_t seed, size_t value) noexcept
+	{
+		return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
+	const void* GetFieldAddress(RecordLayout::FieldEntry const& entry, Object* object)
+	{
+		const auto offset = entry.Field->GetOffset();
+		return offset < 0 ? entry.Field->GetAddress(object) : reinterpret_cast<const nByte*>(object) + offset;
+	}
+
+	Object* GetReferencedObject(RecordLayout::FieldEntry const& entry, Object* object)
+	{
+		return entry.Operations->ReferencedObject(GetFieldAddress(entry, object));
+	}
+
+	class CloneContext
+	{
+	public:
+		natRefPointer<Object> Clone(natRefPointer<Object> const& object)
+		{
+			if (!object)
+			{
+				return {};
+			}
+
+			const auto iter = m_Cloned.find(object.Get());
+			if (iter != m_Cloned.end())
+			{
+				return iter->second;
+			}
+
+			const auto type = object->GetType();
+			// 装箱对象没有成员字段，视为不可变值共享
+			if (type->IsBoxed())
+			{
+				return object;
+			}
+
+			const auto layout = type->GetRecordLayout();
+			natRefPointer<Object> result;
+			if (layout->IsAssignable())
+			{
+				if (const auto constructor = type->GetConstructor({}))
+				{
+					result = constructor->Invoke({});
+					m_Cloned.emplace(object.Get(), result);
+					CopyFields(result, object, *layout);
+					DirtyTracking::Clear(result.Get());
+					return result;
+				}
+			}
+
+			result = type->CopyConstruct(object);
+			m_Cloned.emplace(object.Get(), result);
+			if (layout->HasPointers())
+			{
+				const auto count = layout->GetFieldCount();
+				for (size_t i = 0; i < count; ++i)
+				{
+					auto&& entry = layout->GetField(i);
+					if (entry.Pointer)
+					{
+						entry.Field->WriteFrom(result, Clone(natRefPointer<Object>{ GetReferencedObject(entry, object.Get()) }));
+					}
+				}
+			}
+			DirtyTracking::Clear(result.Get());
+			return result;
+		}
+
+		void CopyFields(natRefPointer<Object> const& dest, natRefPointer<Object> const& source, RecordLayout const& layout)
+		{
+			const auto count = layout.GetFieldCount();
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto&& entry = layout.GetField(i);
+				if (entry.Pointer)
+				{
+					entry.Field->WriteFrom(dest, Clone(natRefPointer<Object>{ GetReferencedObject(entry, source.Get()) }));
+				}
+				else if (entry.Operations->CopyAssign)
+				{
+					entry.Operations->CopyAssign(const_cast<void*>(GetFieldAddress(entry, dest.Get())), GetFieldAddress(entry, source.Get()));
+				}
+			}
+		}
+
+	private:
+		std::unordered_map<Object*, natRefPointer<Object>> m_Cloned;
+	};
+
+	// 递归时在调用栈上记录正在处理的对象，用于终止循环引用
+	struct VisitFrame
+	{
+		Object* A;
+		Object* B;
+		VisitFrame const* Parent;
+
+		bool Contains(Object* a, Object* b) const noexcept
+		{
+			for (auto frame = this; frame; frame = frame->Parent)
+			{
+				if (frame->A == a && frame->B == b)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	};
+
+	bool EqualObjects(Object* a, Object* b, VisitFrame const* parent)
+	{
+		if (a == b)
+		{
+			return true;
+		}
+
+		if (!a || !b)
+		{
+			return false;
+		}
+
+		const auto type = a->GetType();
+		if (!type->Equal(b->GetType().Get()) || type->IsBoxed())
+		{
+			return false;
+		}
+
+		const auto layout = type->GetRecordLayout();
+		const auto count = layout->GetFieldCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto&& entry = layout->GetField(i);
+			if (entry.Pointer)
+			{
+				continue;
+			}
+
+			if (!entry.Operations->Equal)
+			{
+				nat_Throw(ReflectionException, "Member field {0} is not equality comparable."_nv, entry.Name);
+			}
+
+			if (!entry.Operations->Equal(GetFieldAddress(entry, a), GetFieldAddress(entry, b)))
+			{
+				return false;
+			}
+		}
+
+		// 正在比较的对象对视为相等
+		if (!layout->HasPointers() || (parent && parent->Contains(a, b)))
+		{
+			return true;
+		}
+
+		const VisitFrame frame{ a, b, parent };
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto&& entry = layout->GetField(i);
+			if (entry.Pointer && !EqualObjects(GetReferencedObject(entry, a), GetReferencedObject(entry, b), &frame))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// 哈希只展开固定层数的引用，使结果与循环引用的形状无关
+	// EqualObjects将正在比较的对象对视为相等，自环A→A与环B1→B2→B1可能相等，因此不能在循环处截断
+	constexpr size_t HashDepth = 2;
+
+	size_t HashObject(Object* object, size_t depth)
+	{
+		if (!object)
+		{
+			return 0;
+		}
+
+		const auto type = object->GetType();
+		if (type->IsBoxed())
+		{
+			return std::hash<Object*>{}(object);
+		}
+
+		auto seed = std::hash<std::type_index>{}(type->GetTypeIndex());
+		const auto layout = type->GetRecordLayout();
+		const auto count = layout->GetFieldCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto&& entry = layout->GetField(i);
+			if (!entry.Pointer && entry.Operations->Hash)
+			{
+				seed = HashCombine(seed, entry.Operations->Hash(GetFieldAddress(entry, object)));
+			}
+		}
+
+		if (!layout->HasPointers() || !depth)
+		{
+			return seed;
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto&& entry = layout->GetField(i);
+			if (entry.Pointer)
+			{
+				seed = HashCombine(seed, HashObject(GetReferencedObject(entry, object), depth - 1));
+			}
+		}
+
+		return seed;
+	}
+}
+
+RecordLayout::RecordLayout(IType* type)
+	: m_Type{ type }, m_Size{}, m_Alignment{ 1 }, m_Trivial{ true }, m_HasPointers{}, m_Assignable{ true }
+{
+	const auto append = [this](nStrView name, natRefPointer<IMemberField> field)
+	{
+		auto const& operations = field->GetValueOperations();
+		if (!operations.CopyConstruct)
+		{
+			nat_Throw(ReflectionException, "Member field {0} is not copy constructible."_nv, name);
+		}
+
+		const auto offset = (m_Size + operations.Alignment - 1) / operations.Alignment * operations.Alignment;
+		m_Size = offset + operations.Size;
+		m_Alignment = std::max(m_Alignment, operations.Alignment);
+		m_Trivial = m_Trivial && operations.TriviallyCopyable;
+		m_FieldIndices.emplace(field.Get(), m_Fields.size());
+		const auto pointer = operations.ReferencedObject != nullptr;
+		m_HasPointers = m_HasPointers || pointer;
+		m_Assignable = m_Assignable && (pointer || operations.CopyAssign);
+		m_Fields.push_back({ nString{ name }, std::move(field), &operations, offset, pointer });
+	};
+
+	for (auto&& baseClass : type->GetBaseClasses())
+	{
+		for (auto&& entry : baseClass->GetRecordLayout()->GetFields())
+		{
+			append(entry.Name.GetView(), entry.Field);
+		}
+	}
+
+	const auto count = type->GetMemberFieldCount();
+	for (size_t i = 0; i < count; ++i)
+	{
+		append(type->GetMemberFieldName(i), type->GetMemberFieldByIndex(i));
+	}
+
+	m_Size = (m_Size + m_Alignment - 1) / m_Alignment * m_Alignment;
+}
+
+IType* RecordLayout::GetType() const noexcept
+{
+	return m_Type;
+}
+
+size_t RecordLayout::GetSize() const noexcept
+{
+	return m_Size;
+}
+
+size_t RecordLayout::GetAlignment() const noexcept
+{
+	return m_Alignment;
+}
+
+bool RecordLayout::IsTrivial() const noexcept
+{
+	return m_Trivial;
+}
+
+bool RecordLayout::HasPointers() const noexcept
+{
+	return m_HasPointers;
+}
+
+bool RecordLayout::IsAssignable() const noexcept
+{
+	return m_Assignable;
+}
+
+size_t RecordLayout::GetFieldCount() const noexcept
+{
+	return m_Fields.size();
+}
+
+RecordLayout::FieldEntry const& RecordLayout::GetField(size_t n) const
+{
+	if (n >= m_Fields.size())
+	{
+		nat_Throw(ReflectionException, "Field index {0} is out of range."_nv, n);
+	}
+
+	return m_Fields[n];
+}
+
+Linq<const RecordLayout::FieldEntry> RecordLayout::GetFields() const noexcept
+{
+	return from(m_Fields);
+}
+
+size_t RecordLayout::GetFieldIndex(IMemberField const* field) const
+{
+	const auto iter = m_FieldIndices.find(field);
+	if (iter == m_FieldIndices.end())
+	{
+		nat_Throw(ReflectionException, "Field does not belong to this layout."_nv);
+	}
+
+	return iter->second;
+}
+
+void RecordLayout::Snapshot(Object* object, void* record) const
+{
+	CheckObject(object);
+
+	const auto buffer = static_cast<nByte*>(record);
+	if (m_Trivial)
+	{
+		for (auto&& entry : m_Fields)
+		{
+			std::memcpy(buffer + entry.RecordOffset, entry.Field->GetAddress(object), entry.Operations->Size);
+		}
+		return;
+	}
+
+	size_t constructed = 0;
+	try
+	{
+		for (; constructed < m_Fields.size(); ++constructed)
+		{
+			auto&& entry = m_Fields[constructed];
+			entry.Operations->CopyConstruct(buffer + entry.RecordOffset, entry.Field->GetAddress(object));
+		}
+	}
+	catch (...)
+	{
+		while (constructed--)
+		{
+			auto&& entry = m_Fields[constructed];
+			entry.Operations->Destroy(buffer + entry.RecordOffset);
+		}
+		throw;
+	}
+}
+
+void RecordLayout::Restore(Object* object, const void* record) const
+{
+	CheckObject(object);
+
+	const auto buffer = static_cast<const nByte*>(record);
+	for (auto&& entry : m_Fields)
+	{
+		if (entry.Operations->CopyAssign)
+		{
+			entry.Operations->CopyAssign(entry.Field->GetAddress(object), buffer + entry.RecordOffset);
+		}
+	}
+}
+
+void RecordLayout::Destroy(void* record) const noexcept
+{
+	if (m_Trivial)
+	{
+		return;
+	}
+
+	const auto buffer = static_cast<nByte*>(record);
+	for (auto&& entry : m_Fields)
+	{
+		entry.Operations->Destroy(buffer + entry.RecordOffset);
+	}
+}
+
+std::vector<size_t> RecordLayout::Diff(const void* a, const void* b) const
+{
+	const auto bufferA = static_cast<const nByte*>(a), bufferB = static_cast<const nByte*>(b);
+	std::vector<size_t> result;
+	for (size_t i = 0; i < m_Fields.size(); ++i)
+	{
+		auto&& entry = m_Fields[i];
+		const auto valueA = bufferA + entry.RecordOffset, valueB = bufferB + entry.RecordOffset;
+		if (!entry.Operations->Equal || !entry.Operations->Equal(valueA, valueB))
+		{
+			result.emplace_back(i);
+		}
+	}
+
+	return result;
+}
+
+void RecordLayout::CheckObject(Object* object) const
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	// 字段按偏移直接访问，对象类型不符时会越界读写
+	const auto objectType = object->GetType();
+	if (objectType.Get() != m_Type && !objectType->Equal(m_Type) && !objectType->IsExtendFrom(natRefPointer<IType>{ m_Type }))
+	{
+		nat_Throw(ReflectionException, "Object of type {0} is not a {1}."_nv, objectType->GetName(), m_Type->GetName());
+	}
+}
+
+Record::Record(natRefPointer<RecordLayout> layout)
+	: m_Layout{ std::move(layout) }, m_Buffer{}, m_Captured{}
+{
+	if (!m_Layout)
+	{
+		nat_Throw(NullPointerException, "Layout is nullptr."_nv);
+	}
+
+	if (m_Layout->GetAlignment() > alignof(std::max_align_t))
+	{
+		nat_Throw(ReflectionException, "Over-aligned records are not supported."_nv);
+	}
+
+	m_Buffer = ::operator new(std::max(m_Layout->GetSize(), size_t{ 1 }));
+}
+
+Record::Record(natRefPointer<RecordLayout> layout, Object* object)
+	: Record(std::move(layout))
+{
+	Capture(object);
+}
+
+Record::Record(Record&& other) noexcept
+	: m_Layout{ std::move(other.m_Layout) }, m_Buffer{ std::exchange(other.m_Buffer, nullptr) }, m_Captured{ std::exchange(other.m_Captured, false) }
+{
+}
+
+Record::~Record()
+{
+	Reset();
+	::operator delete(m_Buffer);
+}
+
+Record& Record::operator=(Record&& other) noexcept
+{
+	if (this != &other)
+	{
+		Reset();
+		::operator delete(m_Buffer);
+		m_Layout = std::move(other.m_Layout);
+		m_Buffer = std::exchange(other.m_Buffer, nullptr);
+		m_Captured = std::exchange(other.m_Captured, false);
+	}
+
+	return *this;
+}
+
+natRefPointer<RecordLayout> const& Record::GetLayout() const noexcept
+{
+	return m_Layout;
+}
+
+bool Record::IsEmpty() const noexcept
+{
+	return !m_Captured;
+}
+
+const void* Record::GetData() const noexcept
+{
+	return m_Buffer;
+}
+
+void Record::Capture(Object* object)
+{
+	Reset();
+	m_Layout->Snapshot(object, m_Buffer);
+	m_Captured = true;
+}
+
+void Record::Apply(Object* object) const
+{
+	if (!m_Captured)
+	{
+		nat_Throw(ReflectionException, "Record is empty."_nv);
+	}
+
+	m_Layout->Restore(object, m_Buffer);
+}
+
+std::vector<size_t> Record::Diff(Record const& other) const
+{
+	if (!m_Captured || !other.m_Captured)
+	{
+		nat_Throw(ReflectionException, "Record is empty."_nv);
+	}
+
+	if (m_Layout != other.m_Layout)
+	{
+		nat_Throw(InvalidArgumentException, "Records have different layouts."_nv);
+	}
+
+	return m_Layout->Diff(m_Buffer, other.m_Buffer);
+}
+
+void Record::Reset() noexcept
+{
+	if (m_Captured)
+	{
+		m_Layout->Destroy(m_Buffer);
+		m_Captured = false;
+	}
+}
+
+natRefPointer<Object> Memberwise::Clone(natRefPointer<Object> const& object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	CloneContext context;
+	return context.Clone(object);
+}
+
+void Memberwise::Copy(natRefPointer<Object> const& dest, natRefPointer<Object> const& source)
+{
+	if (!dest || !source)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	const auto type = source->GetType();
+	if (!type->Equal(dest->GetType().Get()))
+	{
+		nat_Throw(InvalidArgumentException, "Objects have different types."_nv);
+	}
+
+	if (dest == source)
+	{
+		return;
+	}
+
+	CloneContext context;
+	context.CopyFields(dest, source, *type->GetRecordLayout());
+	DirtyTracking::MarkAll(dest.Get());
+}
+
+bool Memberwise::Equals(Object* a, Object* b)
+{
+	return EqualObjects(a, b, nullptr);
+}
+
+size_t Memberwise::Hash(Object* object)
+{
+	return HashObject(object, HashDepth);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "Interface.h"
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	对象全部成员字段的扁平记录布局
+/// @note	记录中依次存放各基类及本类型按注册顺序排列的成员字段，各字段按其对齐要求紧凑排列
+///			Snapshot于未初始化的缓冲区中构造记录，记录使用完毕后需要调用Destroy
+///			Snapshot及Restore的对象必须为生成布局的类型或其派生类型，否则抛出ReflectionException
+////////////////////////////////////////////////////////////////////////////////
+class RecordLayout final
+	: public natRefObjImpl<RecordLayout, Interface>
+{
+public:
+	struct FieldEntry
+	{
+		nString Name;
+		natRefPointer<IMemberField> Field;
+		ValueOperations const* Operations;
+		size_t RecordOffset;
+		/// @brief	字段是否为指向Object派生类型的natRefPointer
+		bool Pointer;
+	};
+
+	/// @brief	由类型的成员字段生成布局
+	/// @note	若存在不可复制构造的成员字段则抛出ReflectionException
+	explicit RecordLayout(IType* type);
+
+	/// @brief	生成该布局的类型
+	IType* GetType() const noexcept;
+	size_t GetSize() const noexcept;
+	size_t GetAlignment() const noexcept;
+	/// @brief	所有字段均可平凡复制时记录无需销毁
+	bool IsTrivial() const noexcept;
+	/// @brief	是否存在natRefPointer字段
+	bool HasPointers() const noexcept;
+	/// @brief	所有非指针字段是否均可赋值
+	bool IsAssignable() const noexcept;
+
+	size_t GetFieldCount() const noexcept;
+	FieldEntry const& GetField(size_t n) const;
+	Linq<const FieldEntry> GetFields() const noexcept;
+	/// @brief	获得字段在布局中的序号
+	/// @note	若字段不属于该布局则抛出ReflectionException
+	size_t GetFieldIndex(IMemberField const* field) const;
+
+	/// @brief	将对象的所有成员字段复制到记录中
+	/// @param	record	大小至少为GetSize()且满足GetAlignment()对齐的未初始化缓冲区
+	void Snapshot(Object* object, void* record) const;
+
+	/// @brief	将记录中的值写回对象
+	/// @note	跳过不可赋值（如const）的字段
+	void Restore(Object* object, const void* record) const;
+
+	void Destroy(void* record) const noexcept;
+
+	/// @brief	比较两个记录
+	/// @return	值不同的字段的序号，不可比较的字段总被视为不同
+	std::vector<size_t> Diff(const void* a, const void* b) const;
+
+private:
+	void CheckObject(Object* object) const;
+
+	IType* m_Type;
+	std::vector<FieldEntry> m_Fields;
+	std::unordered_map<IMemberField const*, size_t> m_FieldIndices;
+	size_t m_Size;
+	size_t m_Alignment;
+	bool m_Trivial;
+	bool m_HasPointers;
+	bool m_Assignable;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	持有一条记录的缓冲区
+////////////////////////////////////////////////////////////////////////////////
+class Record final
+{
+public:
+	explicit Record(natRefPointer<RecordLayout> layout);
+	Record(natRefPointer<RecordLayout> layout, Object* object);
+	Record(Record&& other) noexcept;
+	~Record();
+
+	Record(Record const&) = delete;
+	Record& operator=(Record const&) = delete;
+	Record& operator=(Record&& other) noexcept;
+
+	natRefPointer<RecordLayout> const& GetLayout() const noexcept;
+	bool IsEmpty() const noexcept;
+	const void* GetData() const noexcept;
+
+	/// @brief	以对象的当前状态覆盖记录
+	void Capture(Object* object);
+	/// @brief	将记录写回对象
+	void Apply(Object* object) const;
+	/// @brief	与另一条同一布局的记录比较
+	std::vector<size_t> Diff(Record const& other) const;
+
+	void Reset() noexcept;
+
+private:
+	natRefPointer<RecordLayout> m_Layout;
+	void* m_Buffer;
+	bool m_Captured;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	按对象实际类型的RecordLayout逐字段进行的复制、比较及哈希
+/// @note	值字段直接通过ValueOperations访问，natRefPointer字段指向的对象被递归处理，复制时经由反射写入
+///			共享及循环引用在复制后保持原有结构，比较及哈希时循环引用不会导致无限递归
+////////////////////////////////////////////////////////////////////////////////
+namespace Memberwise
+{
+	/// @brief	深复制对象
+	/// @note	若类型具有无参构造函数且所有字段均可赋值，则构造后逐字段赋值，否则使用注册的复制构造函数
+	natRefPointer<Object> Clone(natRefPointer<Object> const& object);
+
+	/// @brief	将source的所有字段赋值给dest，natRefPointer字段指向的对象被深复制
+	/// @note	dest与source必须为同一类型，跳过不可赋值的字段
+	void Copy(natRefPointer<Object> const& dest, natRefPointer<Object> const& source);
+
+	/// @brief	比较两个对象的所有字段
+	/// @note	实际类型不同的对象不相等，若存在不可比较的字段则抛出ReflectionException
+	bool Equals(Object* a, Object* b);
+
+	/// @brief	组合所有可哈希字段的哈希值
+	/// @note	Equals为true的对象哈希值相同，natRefPointer字段指向的对象仅展开有限的层数
+	size_t Hash(Object* object);
+}
@@ -0,0 +1,236 @@
+#include "Reflection.h"
+
+namespace rdetail_
+{
+	// 每个线程一个，线程及由该线程创建的对象各持有一个引用
+	class BiasedOwnerRecord
+	{
+	public:
+		BiasedOwnerRecord()
+			: m_RefCount{ 1 }, m_Queue{}
+		{
+		}
+
+		void AddRef() noexcept
+		{
+			m_RefCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void Release() noexcept
+		{
+			if (m_RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			{
+				delete this;
+			}
+		}
+
+		// 所有者线程已退出时返回false，此时由调用者直接合并
+		bool Enqueue(BiasedRefCount* refCount) noexcept
+		{
+			auto head = m_Queue.load(std::memory_order_acquire);
+			do
+			{
+				if (reinterpret_cast<std::uintptr_t>(head) == ExitedMark)
+				{
+					return false;
+				}
+
+				refCount->m_NextQueued = head;
+			} while (!m_Queue.compare_exchange_weak(head, refCount, std::memory_order_release, std::memory_order_acquire));
+
+			return true;
+		}
+
+		bool HasQueued() const noexcept
+		{
+			return m_Queue.load(std::memory_order_relaxed) != nullptr;
+		}
+
+		void Collect() noexcept
+		{
+			MergeAll(m_Queue.exchange(nullptr, std::memory_order_acquire));
+		}
+
+		void Exit() noexcept
+		{
+			MergeAll(m_Queue.exchange(reinterpret_cast<BiasedRefCount*>(ExitedMark), std::memory_order_acq_rel));
+			Release();
+		}
+
+	private:
+		static constexpr std::uintptr_t ExitedMark = alignof(BiasedRefCount);
+
+		static void MergeAll(BiasedRefCount* list) noexcept
+		{
+			while (list)
+			{
+				const auto next = list->m_NextQueued;
+				list->Merge(list->m_Object, BiasedRefCount::QueuedFlag);
+				list = next;
+			}
+		}
+
+		std::atomic<size_t> m_RefCount;
+		std::atomic<BiasedRefCount*> m_Queue;
+	};
+}
+
+namespace
+{
+	thread_local rdetail_::BiasedOwnerRecord* t_OwnerRecord{};
+	thread_local bool t_OwnerRecordExited{};
+
+	class OwnerRecordHolder
+	{
+	public:
+		~OwnerRecordHolder()
+		{
+			const auto record = t_OwnerRecord;
+			t_OwnerRecord = nullptr;
+			t_OwnerRecordExited = true;
+			record->Exit();
+		}
+	};
+
+	// 返回的记录已为调用者增加一个引用
+	rdetail_::BiasedOwnerRecord* AcquireOwnerRecord()
+	{
+		if (const auto record = t_OwnerRecord)
+		{
+			record->AddRef();
+			return record;
+		}
+
+		const auto record = new rdetail_::BiasedOwnerRecord;
+		record->AddRef();
+		if (t_OwnerRecordExited)
+		{
+			// 线程退出过程中创建的对象没有所有者，所有引用均走共享计数
+			// Exit释放线程的引用，调用者的引用已在之前取得，因此记录在此之后仍然有效
+			record->Exit();
+			return record;
+		}
+
+		thread_local OwnerRecordHolder holder;
+		static_cast<void>(holder);
+		t_OwnerRecord = record;
+		return record;
+	}
+}
+
+BiasedRefCount::BiasedRefCount()
+	: m_Owner{ AcquireOwnerRecord() }, m_BiasedCount{ 1 }, m_Merged{ false }, m_Shared{ 0 }, m_Object{}, m_NextQueued{}
+{
+	if (m_Owner == t_OwnerRecord && m_Owner->HasQueued())
+	{
+		m_Owner->Collect();
+	}
+}
+
+BiasedRefCount::BiasedRefCount(BiasedRefCount const&)
+	: BiasedRefCount()
+{
+}
+
+BiasedRefCount::~BiasedRefCount()
+{
+	m_Owner->Release();
+}
+
+void BiasedRefCount::AddRef() noexcept
+{
+	if (IsOwnedByCurrentThread())
+	{
+		++m_BiasedCount;
+		return;
+	}
+
+	m_Shared.fetch_add(CountUnit, std::memory_order_relaxed);
+}
+
+bool BiasedRefCount::Release(const natRefObj* object) noexcept
+{
+	if (IsOwnedByCurrentThread())
+	{
+		if (--m_BiasedCount == 0)
+		{
+			return Merge(object, 0);
+		}
+
+		return false;
+	}
+
+	// 偏向引用被移交到本线程释放导致计数为负时，在同一原子操作中标记排队以请求所有者合并
+	auto value = m_Shared.load(std::memory_order_relaxed);
+	std::ptrdiff_t newValue;
+	do
+	{
+		newValue = value - CountUnit;
+		if (!(newValue & (MergedFlag | QueuedFlag)) && GetCount(newValue) < 0)
+		{
+			newValue |= QueuedFlag;
+		}
+	} while (!m_Shared.compare_exchange_weak(value, newValue, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+	if (newValue & MergedFlag)
+	{
+		// 排队中的对象由合并队列负责销毁
+		if (GetCount(newValue) == 0 && !(newValue & QueuedFlag))
+		{
+			delete object;
+			return true;
+		}
+
+		return false;
+	}
+
+	if ((newValue & QueuedFlag) && !(value & QueuedFlag))
+	{
+		m_Object = object;
+		if (!m_Owner->Enqueue(this))
+		{
+			return Merge(object, QueuedFlag);
+		}
+	}
+
+	return false;
+}
+
+void BiasedRefCount::Collect() noexcept
+{
+	if (const auto record = t_OwnerRecord)
+	{
+		record->Collect();
+	}
+}
+
+bool BiasedRefCount::IsOwnedByCurrentThread() const noexcept
+{
+	return !m_Merged && m_Owner == t_OwnerRecord;
+}
+
+// 由所有者线程或在所有者线程退出后调用，将偏向计数并入共享计数并清除clearFlags
+bool BiasedRefCount::Merge(const natRefObj* object, std::ptrdiff_t clearFlags) noexcept
+{
+	std::ptrdiff_t value;
+	if (m_Merged || (m_Shared.load(std::memory_order_acquire) & MergedFlag))
+	{
+		value = m_Shared.fetch_sub(clearFlags, std::memory_order_acq_rel) - clearFlags;
+	}
+	else
+	{
+		const auto biasedCount = static_cast<std::ptrdiff_t>(m_BiasedCount);
+		m_BiasedCount = 0;
+		m_Merged = true;
+		const auto delta = biasedCount * CountUnit + MergedFlag - clearFlags;
+		value = m_Shared.fetch_add(delta, std::memory_order_acq_rel) + delta;
+	}
+
+	if (GetCount(value) == 0 && !(value & QueuedFlag))
+	{
+		delete object;
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Interface.h"
+#include <atomic>
+#include <cstddef>
+
+namespace rdetail_
+{
+	class BiasedOwnerRecord;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	偏向引用计数
+/// @note	创建对象的线程（所有者线程）使用非原子的偏向计数，其他线程使用原子的共享计数
+///			所有者线程释放全部偏向引用后两个计数合并，之后所有线程均使用共享计数
+///			若对象的引用被移交到其他线程释放导致共享计数为负，对象将被排入所有者线程的合并队列，
+///			由所有者线程在下次创建对象、调用Collect或退出时合并；所有者线程已退出时由释放线程直接合并
+///			因此对象可以安全地在线程间共享，仅在所有者线程上访问时可以避免原子操作
+////////////////////////////////////////////////////////////////////////////////
+class BiasedRefCount
+{
+public:
+	BiasedRefCount();
+	BiasedRefCount(BiasedRefCount const&);
+	~BiasedRefCount();
+
+	BiasedRefCount& operator=(BiasedRefCount const&) noexcept
+	{
+		return *this;
+	}
+
+	void AddRef() noexcept;
+
+	/// @brief	释放一个引用
+	/// @param	object	持有本计数的对象，计数归零时将被销毁
+	/// @return	对象是否已被销毁
+	bool Release(const natRefObj* object) noexcept;
+
+	/// @brief	合并当前线程的合并队列中的所有对象
+	static void Collect() noexcept;
+
+private:
+	friend class rdetail_::BiasedOwnerRecord;
+
+	// 共享计数的低两位分别为已合并及已排队标记
+	static constexpr std::ptrdiff_t MergedFlag = 1;
+	static constexpr std::ptrdiff_t QueuedFlag = 2;
+	static constexpr std::ptrdiff_t CountUnit = 4;
+
+	static constexpr std::ptrdiff_t GetCount(std::ptrdiff_t value) noexcept
+	{
+		return (value - (value & (CountUnit - 1))) / CountUnit;
+	}
+
+	bool IsOwnedByCurrentThread() const noexcept;
+	bool Merge(const natRefObj* object, std::ptrdiff_t clearFlags) noexcept;
+
+	rdetail_::BiasedOwnerRecord* m_Owner;
+	size_t m_BiasedCount;
+	// 仅由所有者线程访问
+	bool m_Merged;
+	std::atomic<std::ptrdiff_t> m_Shared;
+	// 排队时记录，供合并队列销毁对象
+	const natRefObj* m_Object;
+	BiasedRefCount* m_NextQueued;
+};
+
+// 令可反射类型使用偏向引用计数，需要置于类定义内
+#define USE_BIASED_REFCOUNT private: mutable BiasedRefCount _m_BiasedRefCount_;\
+public: void AddRef() const override { _m_BiasedRefCount_.AddRef(); }\
+bool Release() const override { return _m_BiasedRefCount_.Release(this); }
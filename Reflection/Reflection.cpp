@@ -1,17 +1,90 @@
 #include "Reflection.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cwchar>
+#include <iterator>
+#include <limits>
+
+namespace
+{
+	template <typename T>
+	void AppendInteger(nString& output, T value)
+	{
+		char buffer[24];
+		const auto result = std::to_chars(std::begin(buffer), std::end(buffer), value);
+		output.Append(nStrView{ buffer, static_cast<size_t>(result.ptr - buffer) });
+	}
 
-#ifdef _WIN32
-	#ifdef _UNICODE
-		#define toTString std::to_wstring
-		typedef WideStringView TStrView;
-	#else
-		#define toTString std::to_string
-		typedef AnsiStringView TStrView;
-	#endif
-#else
-	#define toTString std::to_string
-	typedef U8StringView TStrView;
-#endif
+	void AppendFloatingPoint(nString& output, double value)
+	{
+		// 保持与std::to_string相同的格式，足以容纳最大的double的整数部分、符号及小数部分
+		char buffer[std::numeric_limits<double>::max_exponent10 + 16];
+		output.Append(nStrView{ buffer, rdetail_::FormatFixedPoint(value, buffer, sizeof buffer) });
+	}
+
+	void AppendCodePoint(nString& output, std::uint32_t codePoint)
+	{
+		char buffer[4];
+		size_t length;
+		if (codePoint < 0x80)
+		{
+			buffer[0] = static_cast<char>(codePoint);
+			length = 1;
+		}
+		else if (codePoint < 0x800)
+		{
+			buffer[0] = static_cast<char>(0xC0 | (codePoint >> 6));
+			buffer[1] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			length = 2;
+		}
+		else if (codePoint < 0x10000)
+		{
+			buffer[0] = static_cast<char>(0xE0 | (codePoint >> 12));
+			buffer[1] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			buffer[2] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			length = 3;
+		}
+		else
+		{
+			buffer[0] = static_cast<char>(0xF0 | (codePoint >> 18));
+			buffer[1] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			buffer[2] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			buffer[3] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			length = 4;
+		}
+		output.Append(nStrView{ buffer, length });
+	}
+
+	[[noreturn]] void ThrowParseFailure(nStrView text, nStrView typeName)
+	{
+		nat_Throw(ReflectionException, "Cannot parse \"{0}\" as {1}."_nv, text, typeName);
+	}
+
+	template <typename T>
+	natRefPointer<Object> ParseInteger(nStrView text)
+	{
+		const auto begin = text.data(), end = begin + text.size();
+		T value;
+		const auto result = std::from_chars(begin, end, value);
+		if (result.ec != std::errc{} || result.ptr != end)
+		{
+			ThrowParseFailure(text, BoxedObject<T>::GetName());
+		}
+		return make_ref<BoxedObject<T>>(value);
+	}
+
+	template <typename T>
+	natRefPointer<Object> ParseFloatingPoint(nStrView text)
+	{
+		T value;
+		if (rdetail_::ParseFloatingPoint(text.data(), text.data() + text.size(), value) != std::errc{})
+		{
+			ThrowParseFailure(text, BoxedObject<T>::GetName());
+		}
+		return make_ref<BoxedObject<T>>(value);
+	}
+}
 
 Reflection& Reflection::GetInstance()
 {
@@ -32,6 +105,17 @@ natRefPointer<IType> Reflection::GetType(nStrView typeName)
 	nat_Throw(ReflectionException, "Type not found."_nv);
 }
 
+natRefPointer<IType> Reflection::GetType(std::type_index typeIndex)
+{
+	const auto iter = m_TypeTable.find(typeIndex);
+	if (iter != m_TypeTable.end())
+	{
+		return iter->second;
+	}
+
+	nat_Throw(ReflectionException, "Type not found."_nv);
+}
+
 Linq<const natRefPointer<IType>> Reflection::GetTypes() const
 {
 	return from(m_TypeTable).select([](auto&& pair) -> natRefPointer<IType> const& { return pair.second; });
@@ -64,6 +148,7 @@ INITIALIZEBOXEDOBJECT(uint64_t, ULong);
 INITIALIZEBOXEDOBJECT(float, Float);
 INITIALIZEBOXEDOBJECT(double, Double);
 INITIALIZEBOXEDOBJECT(nString, RefString);
+INITIALIZEBOXEDOBJECT(nStrView, RefStringView);
 INITIALIZEBOXEDOBJECT(void, Void);
 
 #undef INITIALIZEBOXEDOBJECT
@@ -292,6 +377,66 @@ INITIALIZEBOXEDOBJECT(double, Double);
 
 Reflection::ReflectionNonMemberMethodRegister<RefString> RefString::s_BoxedObject_Constructor_nString_ = { AccessSpecifier::AccessSpecifier_public, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(nString)>(&RefString::Constructor) };
 
+template <>
+void SByte::_appendString(const SByte* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void Byte::_appendString(const Byte* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void Short::_appendString(const Short* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void UShort::_appendString(const UShort* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void Integer::_appendString(const Integer* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void UInteger::_appendString(const UInteger* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void Long::_appendString(const Long* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void ULong::_appendString(const ULong* pThis, nString& output)
+{
+	AppendInteger(output, pThis->m_Obj);
+}
+
+template <>
+void Float::_appendString(const Float* pThis, nString& output)
+{
+	AppendFloatingPoint(output, pThis->m_Obj);
+}
+
+template <>
+void Double::_appendString(const Double* pThis, nString& output)
+{
+	AppendFloatingPoint(output, pThis->m_Obj);
+}
+
 template <>
 nString Bool::_toString(const Bool* pThis) noexcept
 {
@@ -313,71 +458,231 @@ nString WChar::_toString(const WChar* pThis) noexcept
 template <>
 nString SByte::_toString(const SByte* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Byte::_toString(const Byte* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Short::_toString(const Short* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString UShort::_toString(const UShort* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Integer::_toString(const Integer* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString UInteger::_toString(const UInteger* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Long::_toString(const Long* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString ULong::_toString(const ULong* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Float::_toString(const Float* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
 }
 
 template <>
 nString Double::_toString(const Double* pThis) noexcept
 {
-	const auto tmpStr{ toTString(pThis->m_Obj) };
-	return TStrView{ tmpStr.c_str(), tmpStr.size() };
+	nString result;
+	_appendString(pThis, result);
+	return result;
+}
+
+template <>
+void Bool::_appendString(const Bool* pThis, nString& output)
+{
+	output.Append(pThis->m_Obj ? "true"_nv : "false"_nv);
+}
+
+template <>
+void Char::_appendString(const Char* pThis, nString& output)
+{
+	// 非ASCII字符需按当前代码页转换
+	if (static_cast<unsigned char>(pThis->m_Obj) < 0x80)
+	{
+		output.Append(nStrView{ &pThis->m_Obj, 1 });
+	}
+	else
+	{
+		output.Append(_toString(pThis).GetView());
+	}
+}
+
+template <>
+void WChar::_appendString(const WChar* pThis, nString& output)
+{
+	// 单独的代理项无法直接编码，与ToString相同地转换
+	const auto codePoint = static_cast<std::uint32_t>(pThis->m_Obj);
+	if ((codePoint >= 0xD800 && codePoint < 0xE000) || codePoint > 0x10FFFF)
+	{
+		output.Append(_toString(pThis).GetView());
+	}
+	else
+	{
+		AppendCodePoint(output, codePoint);
+	}
+}
+
+template <>
+natRefPointer<Object> Bool::Parse(nStrView text)
+{
+	if (text == "true"_nv)
+	{
+		return make_ref<Bool>(true);
+	}
+	if (text == "false"_nv)
+	{
+		return make_ref<Bool>(false);
+	}
+	ThrowParseFailure(text, GetName());
+}
+
+template <>
+natRefPointer<Object> Char::Parse(nStrView text)
+{
+	if (text.size() != 1)
+	{
+		ThrowParseFailure(text, GetName());
+	}
+	return make_ref<Char>(*text.data());
+}
+
+template <>
+natRefPointer<Object> WChar::Parse(nStrView text)
+{
+	// 文本为UTF-8，解码恰好一个不超出wchar_t范围的码点
+	const auto bytes = reinterpret_cast<const unsigned char*>(text.data());
+	const auto size = text.size();
+	const size_t length = !size ? 0 : bytes[0] < 0x80 ? 1 : (bytes[0] & 0xE0) == 0xC0 ? 2 : (bytes[0] & 0xF0) == 0xE0 ? 3 : (bytes[0] & 0xF8) == 0xF0 ? 4 : 0;
+	if (!length || length != size)
+	{
+		ThrowParseFailure(text, GetName());
+	}
+
+	static constexpr std::uint32_t LeadMask[]{ 0, 0x7F, 0x1F, 0x0F, 0x07 };
+	static constexpr std::uint32_t MinValue[]{ 0, 0, 0x80, 0x800, 0x10000 };
+	std::uint32_t value = bytes[0] & LeadMask[length];
+	for (size_t i = 1; i < length; ++i)
+	{
+		if ((bytes[i] & 0xC0) != 0x80)
+		{
+			ThrowParseFailure(text, GetName());
+		}
+		value = value << 6 | (bytes[i] & 0x3F);
+	}
+
+	if (value < MinValue[length] || (value >= 0xD800 && value <= 0xDFFF) || value > static_cast<std::uint32_t>(WCHAR_MAX))
+	{
+		ThrowParseFailure(text, GetName());
+	}
+	return make_ref<WChar>(static_cast<wchar_t>(value));
+}
+
+template <>
+natRefPointer<Object> SByte::Parse(nStrView text)
+{
+	return ParseInteger<int8_t>(text);
+}
+
+template <>
+natRefPointer<Object> Byte::Parse(nStrView text)
+{
+	return ParseInteger<uint8_t>(text);
+}
+
+template <>
+natRefPointer<Object> Short::Parse(nStrView text)
+{
+	return ParseInteger<int16_t>(text);
+}
+
+template <>
+natRefPointer<Object> UShort::Parse(nStrView text)
+{
+	return ParseInteger<uint16_t>(text);
+}
+
+template <>
+natRefPointer<Object> Integer::Parse(nStrView text)
+{
+	return ParseInteger<int32_t>(text);
+}
+
+template <>
+natRefPointer<Object> UInteger::Parse(nStrView text)
+{
+	return ParseInteger<uint32_t>(text);
+}
+
+template <>
+natRefPointer<Object> Long::Parse(nStrView text)
+{
+	return ParseInteger<int64_t>(text);
+}
+
+template <>
+natRefPointer<Object> ULong::Parse(nStrView text)
+{
+	return ParseInteger<uint64_t>(text);
+}
+
+template <>
+natRefPointer<Object> Float::Parse(nStrView text)
+{
+	return ParseFloatingPoint<float>(text);
+}
+
+template <>
+natRefPointer<Object> Double::Parse(nStrView text)
+{
+	return ParseFloatingPoint<double>(text);
 }
 
 #undef INITIALIZEBOXEDOBJECT
@@ -402,6 +707,7 @@ Reflection::Reflection()
 	INITIALIZEBOXEDOBJECT(float, Float);
 	INITIALIZEBOXEDOBJECT(double, Double);
 	INITIALIZEBOXEDOBJECT(nString, RefString);
+	INITIALIZEBOXEDOBJECT(nStrView, RefStringView);
 	INITIALIZEBOXEDOBJECT(void, Void);
 }
 
@@ -409,6 +715,16 @@ Reflection::~Reflection()
 {
 }
 
+void* Object::operator new(size_t size)
+{
+	return rdetail_::AllocateObject(size);
+}
+
+void Object::operator delete(void* ptr) noexcept
+{
+	rdetail_::DeallocateObject(ptr);
+}
+
 Object::~Object()
 {
 }
@@ -423,11 +739,21 @@ nString Object::ToString() const noexcept
 	return GetType()->GetName();
 }
 
+void Object::AppendString(nString& output) const
+{
+	output.Append(ToString().GetView());
+}
+
 std::type_index Object::GetUnboxedType()
 {
 	return GetType()->GetTypeIndex();
 }
 
+DirtyFieldSet* Object::GetDirtyFieldSet() noexcept
+{
+	return nullptr;
+}
+
 natRefPointer<Object> Object::Box()
 {
 	return make_ref<BoxedObject<void>>();
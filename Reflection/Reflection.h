@@ -3,6 +3,9 @@
 #include <natException.h>
 #include <natConcepts.h>
 #include <natString.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <unordered_map>
 #include <typeindex>
 
@@ -44,11 +47,11 @@ accessspecifier: static returntype methodname(__VA_ARGS__)
 #define DEFINE_NONMEMBER_METHOD(accessspecifier, classname, methodname, id, returntype, ...) Reflection::ReflectionNonMemberMethodRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##methodname##_##id##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, #methodname##_nv, static_cast<returntype(*)(__VA_ARGS__)>(&classname::methodname) };\
 returntype classname::methodname
 
-#define DECLARE_CONSTRUCTOR(accessspecifier, classname, specifiers, id, ...) private: static Reflection::ReflectionNonMemberMethodRegister<classname> _s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_##id##_;\
+#define DECLARE_CONSTRUCTOR(accessspecifier, classname, specifiers, id, ...) private: static Reflection::ReflectionConstructorRegister<classname> _s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_##id##_;\
 static natRefPointer<Object> Constructor(rdetail_::forward_call_t, std::tuple<__VA_ARGS__>&&);\
 accessspecifier: specifiers classname(__VA_ARGS__)
 
-#define DEFINE_CONSTRUCTOR(accessspecifier, classname, specifiers, id, ...) Reflection::ReflectionNonMemberMethodRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_##id##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<__VA_ARGS__>&&)>(&classname::Constructor) };\
+#define DEFINE_CONSTRUCTOR(accessspecifier, classname, specifiers, id, ...) Reflection::ReflectionConstructorRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_##id##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, ConstructorCategory::Normal, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<__VA_ARGS__>&&)>(&classname::Constructor) };\
 natRefPointer<Object> classname::Constructor(rdetail_::forward_call_t, std::tuple<__VA_ARGS__>&& args)\
 {\
 	return ::CommonConstructor<classname>(std::move(args), typename std::make_index_sequence<std::tuple_size<std::remove_reference_t<decltype(args)>>::value>{});\
@@ -56,14 +59,14 @@ natRefPointer<Object> classname::Constructor(rdetail_::forward_call_t, std::tupl
 classname::classname
 
 #define DECLARE_DEFAULT_COPYCONSTRUCTOR(accessspecifier, classname) DECLARE_CONSTRUCTOR(accessspecifier, classname, , CopyConstructor, classname const&) = default
-#define DEFINE_DEFAULT_COPYCONSTRUCTOR(accessspecifier, classname) Reflection::ReflectionNonMemberMethodRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_CopyConstructor##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<classname const&>&&)>(&classname::Constructor) };\
+#define DEFINE_DEFAULT_COPYCONSTRUCTOR(accessspecifier, classname) Reflection::ReflectionConstructorRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_CopyConstructor##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, ConstructorCategory::Copy, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<classname const&>&&)>(&classname::Constructor) };\
 natRefPointer<Object> classname::Constructor(rdetail_::forward_call_t, std::tuple<classname const&>&& args)\
 {\
 	return ::CommonConstructor<classname>(std::move(args), typename std::make_index_sequence<std::tuple_size<std::remove_reference_t<decltype(args)>>::value>{});\
 }
 
 #define DECLARE_DEFAULT_MOVECONSTRUCTOR(accessspecifier, classname) DECLARE_CONSTRUCTOR(accessspecifier, classname, , MoveConstructor, classname &&) = default
-#define DEFINE_DEFAULT_MOVECONSTRUCTOR(accessspecifier, classname) Reflection::ReflectionNonMemberMethodRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_MoveConstructor##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<classname &&>&&)>(&classname::Constructor) };\
+#define DEFINE_DEFAULT_MOVECONSTRUCTOR(accessspecifier, classname) Reflection::ReflectionConstructorRegister<classname> classname::_s_ReflectionHelper_##classname##_NonMemberMethod_##Constructor##_MoveConstructor##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, ConstructorCategory::Move, static_cast<natRefPointer<Object>(*)(rdetail_::forward_call_t, std::tuple<classname &&>&&)>(&classname::Constructor) };\
 natRefPointer<Object> classname::Constructor(rdetail_::forward_call_t, std::tuple<classname &&>&& args)\
 {\
 	return ::CommonConstructor<classname>(std::move(args), typename std::make_index_sequence<std::tuple_size<std::remove_reference_t<decltype(args)>>::value>{});\
@@ -177,6 +180,11 @@ accessspecifier: natRefPointer<pointertotype> fieldname
 
 #define DEFINE_MEMBER_POINTER_FIELD(accessspecifier, classname, pointertotype, fieldname) Reflection::ReflectionMemberFieldRegister<classname> classname::_s_ReflectionHelper_##classname##_MemberPointerField_##fieldname##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, #fieldname##_nv, &classname::fieldname }
 
+// 指定字段的持久化id，id需为非0且在类及其基类的所有字段中唯一，字段更名或调整顺序后仍应保持不变
+#define DEFINE_MEMBER_FIELD_WITH_ID(accessspecifier, classname, fieldtype, fieldname, id) Reflection::ReflectionMemberFieldRegister<classname> classname::_s_ReflectionHelper_##classname##_MemberField_##fieldname##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, #fieldname##_nv, &classname::fieldname, id }
+
+#define DEFINE_MEMBER_POINTER_FIELD_WITH_ID(accessspecifier, classname, pointertotype, fieldname, id) Reflection::ReflectionMemberFieldRegister<classname> classname::_s_ReflectionHelper_##classname##_MemberPointerField_##fieldname##_{ AccessSpecifier::AccessSpecifier_##accessspecifier, #fieldname##_nv, &classname::fieldname, id }
+
 #define typeof(type) Reflection::GetInstance().GetType<type>()
 #define typeofexp(expression) Reflection::GetInstance().GetType<decltype(expression)>()
 #define typeofname(name) Reflection::GetInstance().GetType(name)
@@ -237,6 +245,16 @@ public:
 		}
 	};
 
+	template <typename T>
+	struct ReflectionConstructorRegister
+	{
+		template <typename Func>
+		ReflectionConstructorRegister(AccessSpecifier accessSpecifier, ConstructorCategory category, Func constructor)
+		{
+			GetInstance().RegisterConstructor<T>(accessSpecifier, category, constructor);
+		}
+	};
+
 	template <typename T>
 	struct ReflectionMemberMethodRegister
 	{
@@ -261,9 +279,9 @@ public:
 	struct ReflectionMemberFieldRegister
 	{
 		template <typename U>
-		ReflectionMemberFieldRegister(AccessSpecifier accessSpecifier, nStrView name, U field)
+		ReflectionMemberFieldRegister(AccessSpecifier accessSpecifier, nStrView name, U field, std::uint32_t id = 0)
 		{
-			GetInstance().RegisterMemberField<T>(accessSpecifier, name, field);
+			GetInstance().RegisterMemberField<T>(accessSpecifier, name, field, id);
 		}
 	};
 
@@ -297,6 +315,9 @@ public:
 	template <typename Class, typename Func>
 	void RegisterNonMemberMethod(AccessSpecifier accessSpecifier, nStrView name, Func method);
 
+	template <typename Class, typename Func>
+	void RegisterConstructor(AccessSpecifier accessSpecifier, ConstructorCategory category, Func constructor);
+
 	template <typename Class, typename Func>
 	void RegisterMemberMethod(AccessSpecifier accessSpecifier, bool isVirtual, nStrView name, Func method);
 
@@ -304,12 +325,13 @@ public:
 	void RegisterNonMemberField(AccessSpecifier accessSpecifier, nStrView name, Field field);
 
 	template <typename Class, typename Field>
-	void RegisterMemberField(AccessSpecifier accessSpecifier, nStrView name, Field field);
+	void RegisterMemberField(AccessSpecifier accessSpecifier, nStrView name, Field field, std::uint32_t id = 0);
 
 	template <typename Class>
 	natRefPointer<IType> GetType();
 
 	natRefPointer<IType> GetType(nStrView typeName);
+	natRefPointer<IType> GetType(std::type_index typeIndex);
 
 	Linq<const natRefPointer<IType>> GetTypes() const;
 
@@ -361,9 +383,9 @@ struct should_box<T, std::void_t<std::enable_if_t<!std::is_base_of<Object, T>::v
 {
 };
 
-// ҪObjectΪɷʹã纯Ĳ򷵻ֵȣҪڴ˶BoxedObjectػ
-// עȻҪֶúע
-// BoxedObject̳ObjectGetObjصһģ͵ֵ
+// 若需要将并非派生于Object的类型作为可反射对象使用（例如函数的参数或返回值等），需要在此对BoxedObject特化此类型
+// 注意你仍然需要手动或者利用宏来注册
+// BoxedObject必须继承于Object且GetObj方法返回第一个模板参数的类型的左值引用
 template <typename T, typename Test = void>
 class BoxedObject final
 	: public Object
@@ -378,7 +400,7 @@ public:
 #undef INITIALIZEBOXEDOBJECT
 #define INITIALIZEBOXEDOBJECT(type, alias) private: static Reflection::ReflectionNonMemberMethodRegister<Self_t_> s_BoxedObject_Constructor_##type##_;\
 public: BoxedObject(type value) : m_Obj { static_cast<UnderlyingType>(value) } {}\
-static natRefPointer<Object> Constructor(type value) { return make_ref<BoxedObject>(std::move(value)); }
+static natRefPointer<Object> Constructor(type value) { rdetail_::PrepareBatchSlot(typeid(BoxedObject)); return make_ref<BoxedObject>(std::move(value)); }
 
 #pragma warning (push)
 #pragma warning (disable : 4800)
@@ -390,6 +412,7 @@ class BoxedObject<T, std::void_t<std::enable_if_t<std::disjunction<std::is_arith
 public:
 	typedef BoxedObject Self_t_;
 	typedef T UnderlyingType;
+	USE_OBJECT_POOL
 	static nStrView GetName() noexcept;
 	natRefPointer<IType> GetType() const noexcept override
 	{
@@ -440,13 +463,23 @@ public:
 		return _toString(this);
 	}
 
+	void AppendString(nString& output) const override
+	{
+		_appendString(this, output);
+	}
+
 	std::type_index GetUnboxedType() override
 	{
 		return typeid(T);
 	}
 
+	/// @brief	由文本解析出值并装箱
+	/// @note	bool接受true及false，字符类型接受恰好一个字符，整数为十进制，浮点数为十进制或科学计数法
+	static natRefPointer<Object> Parse(nStrView text);
+
 private:
 	static nString _toString(const BoxedObject* pThis) noexcept;
+	static void _appendString(const BoxedObject* pThis, nString& output);
 
 	T m_Obj;
 };
@@ -460,6 +493,7 @@ class BoxedObject<nString> final
 public:
 	typedef BoxedObject Self_t_;
 	typedef nString UnderlyingType;
+	USE_OBJECT_POOL
 
 	static nStrView GetName() noexcept
 	{
@@ -503,21 +537,105 @@ public:
 		return m_Obj;
 	}
 
+	void AppendString(nString& output) const override
+	{
+		output.Append(m_Obj.GetView());
+	}
+
 	std::type_index GetUnboxedType() override
 	{
 		return typeid(nString);
 	}
 
+	static natRefPointer<Object> Parse(nStrView text)
+	{
+		return make_ref<BoxedObject>(nString{ text });
+	}
+
 private:
 	nString m_Obj;
 };
 
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	不持有数据的装箱字符串
+/// @note	仅用于在调用中传递字符串而不复制，应由BoxedReferenceScope<nStrView>创建
+///			作用域结束后对象失效，此后获取其值将抛出ReflectionException
+///			可作为nStrView、nStrView const&及nString const&形参的实参
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class BoxedReferenceScope;
+
+template <>
+class BoxedObject<nStrView> final
+	: public Object
+{
+public:
+	typedef BoxedObject Self_t_;
+	typedef nStrView UnderlyingType;
+	USE_OBJECT_POOL
+
+	static nStrView GetName() noexcept
+	{
+		return "RefStringView"_nv;
+	}
+
+	natRefPointer<IType> GetType() const noexcept override
+	{
+		return typeof(BoxedObject<nStrView>);
+	}
+
+	explicit BoxedObject(nStrView view) noexcept
+		: m_Obj{ view }, m_Expired{ false }
+	{
+	}
+
+	operator nStrView()
+	{
+		return GetObj();
+	}
+
+	nStrView& GetObj()
+	{
+		if (m_Expired)
+		{
+			nat_Throw(ReflectionException, "Reference has expired."_nv);
+		}
+
+		return m_Obj;
+	}
+
+	nString ToString() const noexcept override
+	{
+		return m_Expired ? nString{} : nString{ m_Obj };
+	}
+
+	void AppendString(nString& output) const override
+	{
+		if (!m_Expired)
+		{
+			output.Append(m_Obj);
+		}
+	}
+
+	std::type_index GetUnboxedType() override
+	{
+		return typeid(nStrView);
+	}
+
+private:
+	friend class BoxedReferenceScope<nStrView>;
+
+	nStrView m_Obj;
+	bool m_Expired;
+};
+
 template <>
 class BoxedObject<void> final
 	: public Object
 {
 public:
 	typedef BoxedObject<void> Self_t_;
+	USE_OBJECT_POOL
 	static nStrView GetName() noexcept;
 	natRefPointer<IType> GetType() const noexcept override
 	{
@@ -582,6 +700,157 @@ template <typename T>
 void Type<T>::RegisterBaseClasses(std::initializer_list<natRefPointer<IType>> baseClasses)
 {
 	m_BaseClasses.assign(baseClasses);
+	rdetail_::MetadataVersion().fetch_add(1, std::memory_order_acq_rel);
+}
+
+template <typename T>
+natRefPointer<RecordLayout> Type<T>::GetRecordLayout()
+{
+	// 本类或任一类型注册了成员字段或基类后重建，旧的布局仍被保留，已取得的引用继续有效
+	const auto version = rdetail_::MetadataVersion().load(std::memory_order_acquire);
+	const auto layout = m_PublishedRecordLayout.load(std::memory_order_acquire);
+	if (layout && m_RecordLayoutVersion.load(std::memory_order_acquire) == version)
+	{
+		return natRefPointer<RecordLayout>{ layout };
+	}
+
+	std::lock_guard<std::mutex> lock{ m_RecordLayoutMutex };
+	if (m_RecordLayouts.empty() || m_RecordLayoutVersion.load(std::memory_order_relaxed) != version)
+	{
+		m_RecordLayouts.emplace_back(make_ref<RecordLayout>(this));
+		m_RecordLayoutVersion.store(version, std::memory_order_release);
+		m_PublishedRecordLayout.store(m_RecordLayouts.back().Get(), std::memory_order_release);
+	}
+
+	return m_RecordLayouts.back();
+}
+
+// 复制及移动构造函数直接经由调用入口以原对象作为参数调用，避免装箱及类型转换
+template <typename T>
+natRefPointer<Object> Type<T>::ConstructFrom(natRefPointer<IMethod> const& constructor, natRefPointer<Object> const& object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	void* args[] = { &object->Unbox<T>() };
+	return constructor->GetThunk().Invoke<natRefPointer<Object>>(nullptr, args);
+}
+
+template <typename T>
+natRefPointer<Object> Type<T>::DefaultCopyConstruct(natRefPointer<Object> const& object, std::true_type)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	rdetail_::PrepareBatchSlot(typeid(T));
+	return make_ref<T>(object->Unbox<T>());
+}
+
+template <typename T>
+natRefPointer<Object> Type<T>::DefaultCopyConstruct(natRefPointer<Object> const&, std::false_type)
+{
+	nat_Throw(ReflectionException, "Type {0} has no registered copy constructor."_nv, GetName());
+}
+
+template <typename T>
+bool Type<T>::ConstructorHandle::Matches(ArgumentPack const& args) const
+{
+	if (args.Size() != ArgumentTypes.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < ArgumentTypes.size(); ++i)
+	{
+		if (args.GetType(i).Get() != ArgumentTypes[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <typename T>
+IMethod* Type<T>::FindConstructor(ArgumentPack const& args)
+{
+	std::lock_guard<std::mutex> lock{ m_ConstructorHandleMutex };
+	for (auto&& handle : m_ConstructorHandles)
+	{
+		if (handle->Matches(args))
+		{
+			m_PublishedConstructorHandle.store(handle.get(), std::memory_order_release);
+			return handle->Constructor;
+		}
+	}
+
+	for (auto&& item : m_Constructors)
+	{
+		if (item.second->CompatWith(args))
+		{
+			auto handle = std::make_unique<ConstructorHandle>();
+			handle->ArgumentTypes.reserve(args.Size());
+			for (size_t i = 0; i < args.Size(); ++i)
+			{
+				handle->ArgumentTypes.emplace_back(args.GetType(i).Get());
+			}
+			handle->Constructor = item.second.Get();
+
+			m_PublishedConstructorHandle.store(handle.get(), std::memory_order_release);
+			m_ConstructorHandles.emplace_back(std::move(handle));
+			return item.second.Get();
+		}
+	}
+
+	nat_Throw(ReflectionException, "None of constructors of {0} can be invoked with given args."_nv, GetName());
+}
+
+template <typename T>
+natRefPointer<ObjectBatch> Type<T>::ConstructBatch(size_t count, ArgumentPack const& args)
+{
+	auto batch = make_ref<ObjectBatch>(sizeof(T), count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		batch->Emplace(typeid(T), [&]
+		{
+			return Construct(args);
+		});
+	}
+
+	return batch;
+}
+
+template <typename T>
+natRefPointer<Object> Type<T>::InvokeVirtual(natRefPointer<Object> object, size_t slot, ArgumentPack const& args)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	// 由对象的实际类型的虚表选择重写版本，槽位仅在沿第一个基类派生的类型中保持一致
+	const auto objectType = object->GetType();
+	auto const& table = objectType->GetVirtualTable();
+	if (std::find(table.Types.begin(), table.Types.end(), this) == table.Types.end())
+	{
+		if (objectType->IsExtendFrom(natRefPointer<IType>{ this }))
+		{
+			nat_Throw(ReflectionException, "Virtual slots of {1} do not apply to type {0}, which does not derive from it through its first base classes."_nv, objectType->GetName(), GetName());
+		}
+
+		nat_Throw(ReflectionException, "Object of type {0} is not a {1}."_nv, objectType->GetName(), GetName());
+	}
+
+	if (slot >= table.Methods.size())
+	{
+		nat_Throw(ReflectionException, "Virtual slot {0} is out of range."_nv, slot);
+	}
+
+	return table.Methods[slot]->Invoke(std::move(object), args);
 }
 
 #undef INITIALIZEBOXEDOBJECT
@@ -601,6 +870,7 @@ INITIALIZEBOXEDOBJECT(uint64_t, ULong);
 INITIALIZEBOXEDOBJECT(float, Float);
 INITIALIZEBOXEDOBJECT(double, Double);
 INITIALIZEBOXEDOBJECT(nString, RefString);
+INITIALIZEBOXEDOBJECT(nStrView, RefStringView);
 INITIALIZEBOXEDOBJECT(void, Void);
 
 #undef INITIALIZEBOXEDOBJECT
@@ -620,6 +890,7 @@ INITIALIZEBOXEDOBJECT(uint64_t, ULong);
 INITIALIZEBOXEDOBJECT(float, Float);
 INITIALIZEBOXEDOBJECT(double, Double);
 INITIALIZEBOXEDOBJECT(nString, RefString);
+INITIALIZEBOXEDOBJECT(nStrView, RefStringView);
 INITIALIZEBOXEDOBJECT(void, Void);
 
 template <typename T>
@@ -688,6 +959,380 @@ bool Type<T>::IsBoxed() const noexcept
 	return is_boxed<T>::value;
 }
 
+namespace rdetail_
+{
+	template <typename T, typename = void>
+	struct IsParsable
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsParsable<T, std::void_t<decltype(T::Parse(std::declval<nStrView>()))>>
+		: std::true_type
+	{
+	};
+
+	template <typename T>
+	natRefPointer<Object> ParseObject(nStrView text, std::true_type)
+	{
+		return T::Parse(text);
+	}
+
+	template <typename T>
+	[[noreturn]] natRefPointer<Object> ParseObject(nStrView, std::false_type)
+	{
+		nat_Throw(ReflectionException, "Type {0} cannot be parsed."_nv, T::GetName());
+	}
+}
+
+template <typename T>
+bool Type<T>::IsParsable() const noexcept
+{
+	return rdetail_::IsParsable<T>::value;
+}
+
+template <typename T>
+natRefPointer<Object> Type<T>::Parse(nStrView text)
+{
+	return rdetail_::ParseObject<T>(text, rdetail_::IsParsable<T>{});
+}
+
+namespace rdetail_
+{
+	// 以REGISTER_BOXED_OBJECT及REGISTER_BOXED_VALUE注册的类型声明了ReferenceBox_t_
+	template <typename T, typename = void>
+	struct IsReferenceBoxable
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsReferenceBoxable<T, std::void_t<typename BoxedObject<T>::ReferenceBox_t_>>
+		: std::true_type
+	{
+	};
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	引用已存在的值而不持有该值的装箱对象
+/// @note	类型与BoxedObject<T>相同，因此可直接作为实参或成员方法的对象，Unbox<T>返回被引用的值
+///			应由BoxedReferenceScope创建，作用域结束后对象失效，此后获取其值将抛出ReflectionException
+///			支持以REGISTER_BOXED_OBJECT及REGISTER_BOXED_VALUE注册的类型，后者的BoxedReference同时是BoxedValue
+////////////////////////////////////////////////////////////////////////////////
+template <typename T, typename = void>
+class BoxedReference final
+	: public Object
+{
+	// 其他装箱类型的BoxedObject<T>不是BoxedReference，Unbox及方法调用会将引用误作BoxedObject<T>
+	static_assert(rdetail_::IsReferenceBoxable<T>::value, "T should be registered with REGISTER_BOXED_OBJECT or REGISTER_BOXED_VALUE.");
+
+public:
+	USE_OBJECT_POOL
+
+	explicit BoxedReference(T& value) noexcept
+		: m_Value{ std::addressof(value) }
+	{
+	}
+
+	natRefPointer<IType> GetType() const noexcept override
+	{
+		return typeof(BoxedObject<T>);
+	}
+
+	std::type_index GetUnboxedType() override
+	{
+		return typeid(T);
+	}
+
+	T& GetObj()
+	{
+		if (!m_Value)
+		{
+			nat_Throw(ReflectionException, "Reference has expired."_nv);
+		}
+
+		return *m_Value;
+	}
+
+private:
+	friend class BoxedReferenceScope<T>;
+
+	void Expire() noexcept
+	{
+		m_Value = nullptr;
+	}
+
+	T* m_Value;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	在作用域内以BoxedReference引用value
+/// @note	析构时令引用失效，即使对象在作用域外仍被持有也不会访问到已销毁的值
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class BoxedReferenceScope final
+{
+public:
+	explicit BoxedReferenceScope(T& value)
+		: m_Reference{ make_ref<BoxedReference<T>>(value) }
+	{
+	}
+
+	~BoxedReferenceScope()
+	{
+		m_Reference->Expire();
+	}
+
+	BoxedReferenceScope(BoxedReferenceScope const&) = delete;
+	BoxedReferenceScope& operator=(BoxedReferenceScope const&) = delete;
+
+	natRefPointer<Object> Get() const noexcept
+	{
+		return m_Reference;
+	}
+
+private:
+	natRefPointer<BoxedReference<T>> m_Reference;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	在作用域内以RefStringView引用字符串而不复制
+/// @note	析构时令RefStringView失效，view引用的字符串只需在作用域内保持有效
+////////////////////////////////////////////////////////////////////////////////
+template <>
+class BoxedReferenceScope<nStrView> final
+{
+public:
+	explicit BoxedReferenceScope(nStrView view)
+		: m_Reference{ make_ref<RefStringView>(view) }
+	{
+	}
+
+	~BoxedReferenceScope()
+	{
+		m_Reference->m_Expired = true;
+	}
+
+	BoxedReferenceScope(BoxedReferenceScope const&) = delete;
+	BoxedReferenceScope& operator=(BoxedReferenceScope const&) = delete;
+
+	natRefPointer<Object> Get() const noexcept
+	{
+		return m_Reference;
+	}
+
+private:
+	natRefPointer<RefStringView> m_Reference;
+};
+
+#ifndef REFLECTION_BOXED_VALUE_CAPACITY
+#	define REFLECTION_BOXED_VALUE_CAPACITY 32
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	以REGISTER_BOXED_VALUE注册的值类型的装箱对象的公共部分
+/// @note	值直接存放于对象内的缓冲区中，对象记录值的IType及type_info，因此可在不知道值的类型时访问
+///			所有此类装箱对象大小相同，均由对象池或ScratchScope的存储分配
+///			缓冲区的大小可在包含Reflection.h前定义REFLECTION_BOXED_VALUE_CAPACITY修改
+///			引用此类值的BoxedReference也是BoxedValue，其数据为被引用的值，应使用From而不是static_cast获得BoxedValue
+////////////////////////////////////////////////////////////////////////////////
+class BoxedValue
+	: public Object
+{
+public:
+	static constexpr size_t Capacity = REFLECTION_BOXED_VALUE_CAPACITY;
+
+	USE_OBJECT_POOL
+
+	/// @brief	object为BoxedValue时返回该对象，否则返回nullptr
+	/// @note	具有BoxedValue的IType的对象可能是引用该值的BoxedReference，同样可由此获得
+	static BoxedValue* From(Object* object) noexcept
+	{
+		return dynamic_cast<BoxedValue*>(object);
+	}
+
+	natRefPointer<IType> GetType() const noexcept override
+	{
+		return natRefPointer<IType>{ m_Type };
+	}
+
+	std::type_index GetUnboxedType() override
+	{
+		return *m_ValueType;
+	}
+
+	std::type_info const& GetValueType() const noexcept
+	{
+		return *m_ValueType;
+	}
+
+	size_t GetSize() const noexcept
+	{
+		return m_Size;
+	}
+
+	/// @brief	获得值的地址
+	/// @note	引用已失效时返回nullptr
+	void* GetData() noexcept
+	{
+		return m_Data;
+	}
+
+	const void* GetData() const noexcept
+	{
+		return m_Data;
+	}
+
+	/// @brief	值的类型为T时返回值的指针，否则返回nullptr
+	template <typename T>
+	T* As() noexcept
+	{
+		return *m_ValueType == typeid(T) ? static_cast<T*>(GetData()) : nullptr;
+	}
+
+protected:
+	struct ReferenceTag_t_
+	{
+	};
+
+	BoxedValue(IType* type, std::type_info const& valueType, const void* data, size_t size) noexcept
+		: m_Type{ type }, m_ValueType{ &valueType }, m_Size{ size }, m_Data{ m_Storage }
+	{
+		std::memcpy(m_Storage, data, size);
+	}
+
+	/// @brief	引用value而不复制，不使用内部的缓冲区
+	BoxedValue(ReferenceTag_t_, IType* type, std::type_info const& valueType, void* value, size_t size) noexcept
+		: m_Type{ type }, m_ValueType{ &valueType }, m_Size{ size }, m_Data{ value }
+	{
+	}
+
+	void Expire() noexcept
+	{
+		m_Data = nullptr;
+	}
+
+private:
+	// 类型注册后不会被移除，因此不持有引用
+	IType* m_Type;
+	std::type_info const* m_ValueType;
+	size_t m_Size;
+	void* m_Data;
+	alignas(std::max_align_t) nByte m_Storage[Capacity];
+};
+
+static_assert(sizeof(BoxedValue) <= ObjectPool::MaxBlockSize, "BoxedValue does not fit in the object pool, reduce REFLECTION_BOXED_VALUE_CAPACITY.");
+
+namespace rdetail_
+{
+	/// @brief	由REGISTER_BOXED_VALUE特化，提供类型名
+	template <typename T>
+	struct BoxedValueName;
+
+	template <typename T, typename = void>
+	struct IsBoxedValue
+		: std::false_type
+	{
+	};
+
+	template <typename T>
+	struct IsBoxedValue<T, std::void_t<decltype(BoxedValueName<T>::GetName())>>
+		: std::true_type
+	{
+	};
+}
+
+// 以REGISTER_BOXED_VALUE注册的类型共用此实现，不需要特化BoxedObject
+template <typename T>
+class BoxedObject<T, std::enable_if_t<rdetail_::IsBoxedValue<T>::value>> final
+	: public BoxedValue
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Boxed value must be trivially copyable.");
+	static_assert(sizeof(T) <= Capacity && alignof(T) <= alignof(std::max_align_t), "Boxed value is too large, increase REFLECTION_BOXED_VALUE_CAPACITY or use REGISTER_BOXED_OBJECT.");
+
+public:
+	typedef BoxedObject Self_t_;
+	typedef T UnderlyingType;
+	typedef BoxedReference<T> ReferenceBox_t_;
+
+	static nStrView GetName() noexcept
+	{
+		return rdetail_::BoxedValueName<T>::GetName();
+	}
+
+	BoxedObject(T const& value) noexcept
+		: BoxedValue{ typeof(BoxedObject).Get(), typeid(T), std::addressof(value), sizeof(T) }
+	{
+	}
+
+	operator T&() noexcept
+	{
+		return GetObj();
+	}
+
+	T& GetObj() noexcept
+	{
+		return *static_cast<T*>(GetData());
+	}
+
+	static natRefPointer<Object> Constructor(T const& value)
+	{
+		rdetail_::PrepareBatchSlot(typeid(BoxedObject));
+		return make_ref<BoxedObject>(value);
+	}
+
+private:
+	// 由REGISTER_BOXED_VALUE_DEF定义
+	static Reflection::ReflectionBaseClassesRegister<BoxedObject, Object> _s_ReflectionHelper_BoxedObject;
+	static Reflection::ReflectionConstructorRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_Constructor;
+};
+
+template <typename T>
+class BoxedReference<T, std::enable_if_t<rdetail_::IsBoxedValue<T>::value>> final
+	: public BoxedValue
+{
+public:
+	explicit BoxedReference(T& value) noexcept
+		: BoxedValue{ ReferenceTag_t_{}, typeof(BoxedObject<T>).Get(), typeid(T), std::addressof(value), sizeof(T) }
+	{
+	}
+
+	T& GetObj()
+	{
+		const auto data = GetData();
+		if (!data)
+		{
+			nat_Throw(ReflectionException, "Reference has expired."_nv);
+		}
+
+		return *static_cast<T*>(data);
+	}
+
+private:
+	friend class BoxedReferenceScope<T>;
+};
+
+namespace rdetail_
+{
+	template <typename T>
+	T& UnboxValue(Object* object, std::true_type)
+	{
+		if (typeid(*object) == typeid(BoxedReference<T>))
+		{
+			return static_cast<BoxedReference<T>*>(object)->GetObj();
+		}
+
+		return static_cast<BoxedObject<T>*>(object)->GetObj();
+	}
+
+	template <typename T>
+	T& UnboxValue(Object* object, std::false_type)
+	{
+		return static_cast<BoxedObject<T>*>(object)->GetObj();
+	}
+}
+
 template <typename T>
 T& Object::Unbox()
 {
@@ -709,9 +1354,9 @@ T& Object::Unbox()
 	}
 	if (typeindex == typeid(BoxedObject<T>))
 	{
-		return static_cast<BoxedObject<T>*>(this)->GetObj();
+		return rdetail_::UnboxValue<T>(this, rdetail_::IsReferenceBoxable<T>{});
 	}
-	// ޴ж
+	// 开销巨大所以留在最后判断
 	auto Ttype = typeof(boxed_type_t<T>);
 	if (type->IsExtendFrom(Ttype) || Ttype->IsExtendFrom(type))
 	{
@@ -728,20 +1373,30 @@ T& Object::Unbox()
 template <typename Class>
 natRefPointer<IType> Reflection::GetType()
 {
+	// 类型注册后不会被移除，找到后缓存以避免每次以type_index查表
+	static std::atomic<IType*> s_Type{};
+	if (const auto type = s_Type.load(std::memory_order_acquire))
+	{
+		return natRefPointer<IType>{ type };
+	}
+
 	auto iter = m_TypeTable.find(typeid(boxed_type_t<Class>));
 	if (iter != m_TypeTable.end())
 	{
+		s_Type.store(iter->second.Get(), std::memory_order_release);
 		return iter->second;
 	}
 
 	nat_Throw(ReflectionException, "Type not found."_nv);
 }
 
-// ҪͿԱʵԼƶ죬ͲҪҪػ
+// 要求这个类型可以被实例化以及移动构造，如果你的类型不符合这个要求，你需要自行特化
 #define REGISTER_BOXED_OBJECT(type) template <>\
 class BoxedObject<type> final : public Object\
 {\
 public:\
+	typedef BoxedReference<type> ReferenceBox_t_;\
+	USE_OBJECT_POOL\
 	static nStrView GetName() noexcept { return #type##_nv; }\
 	natRefPointer<IType> GetType() const noexcept override { return typeof(BoxedObject); }\
 	std::type_index GetUnboxedType() override { return typeid(type); }\
@@ -750,18 +1405,19 @@ public:\
 	type& GetObj() noexcept { return m_Obj; }\
 private:\
 	static Reflection::ReflectionBaseClassesRegister<BoxedObject, Object> _s_ReflectionHelper_BoxedObject;\
-	static Reflection::ReflectionNonMemberMethodRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_Constructor;\
-	static natRefPointer<Object> Constructor(type&& value) { return make_ref<BoxedObject<type>>(std::move(value)); }\
+	static Reflection::ReflectionConstructorRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_Constructor;\
+	static natRefPointer<Object> Constructor(type&& value) { rdetail_::PrepareBatchSlot(typeid(BoxedObject)); return make_ref<BoxedObject<type>>(std::move(value)); }\
 	type m_Obj;\
 }
 
 #define REGISTER_BOXED_OBJECT_DEF(type) Reflection::ReflectionBaseClassesRegister<BoxedObject<type>, Object> BoxedObject<type>::_s_ReflectionHelper_BoxedObject { WITH() };\
-Reflection::ReflectionNonMemberMethodRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_Constructor { AccessSpecifier::AccessSpecifier_public, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(type&&)>(&BoxedObject<type>::Constructor) }
+Reflection::ReflectionConstructorRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_Constructor { AccessSpecifier::AccessSpecifier_public, ConstructorCategory::Normal, static_cast<natRefPointer<Object>(*)(type&&)>(&BoxedObject<type>::Constructor) }
 
 #define REGISTER_BOXED_REFOBJECT(type) template <>\
 class BoxedObject<type> final : public Object\
 {\
 public:\
+	USE_OBJECT_POOL\
 	static nStrView GetName() noexcept { return #type##_nv; }\
 	natRefPointer<IType> GetType() const noexcept override { return typeof(BoxedObject); }\
 	std::type_index GetUnboxedType() override { return typeid(type); }\
@@ -772,18 +1428,39 @@ public:\
 	type& GetObj() noexcept { return *m_Obj; }\
 private:\
 	static Reflection::ReflectionBaseClassesRegister<BoxedObject, Object> _s_ReflectionHelper_BoxedObject;\
-	static Reflection::ReflectionNonMemberMethodRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_CopyConstructor;\
-	static Reflection::ReflectionNonMemberMethodRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_MoveConstructor;\
-	static natRefPointer<Object> Constructor(BoxedObject const& other) { return make_ref<BoxedObject<type>>(other); }\
-	static natRefPointer<Object> Constructor(BoxedObject&& other) { return make_ref<BoxedObject<type>>(std::move(other)); }\
+	static Reflection::ReflectionConstructorRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_CopyConstructor;\
+	static Reflection::ReflectionConstructorRegister<BoxedObject> _s_ReflectionHelper_BoxedObject_MoveConstructor;\
+	static natRefPointer<Object> Constructor(BoxedObject const& other) { rdetail_::PrepareBatchSlot(typeid(BoxedObject)); return make_ref<BoxedObject<type>>(other); }\
+	static natRefPointer<Object> Constructor(BoxedObject&& other) { rdetail_::PrepareBatchSlot(typeid(BoxedObject)); return make_ref<BoxedObject<type>>(std::move(other)); }\
 	natRefPointer<type> m_Obj;\
 }
 
 #define REGISTER_BOXED_REFOBJECT_DEF(type) Reflection::ReflectionBaseClassesRegister<BoxedObject<type>, Object> BoxedObject<type>::_s_ReflectionHelper_BoxedObject { WITH() };\
-Reflection::ReflectionNonMemberMethodRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_CopyConstructor { AccessSpecifier::AccessSpecifier_public, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(BoxedObject const&)>(&BoxedObject<type>::Constructor) };\
-Reflection::ReflectionNonMemberMethodRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_MoveConstructor { AccessSpecifier::AccessSpecifier_public, "Constructor"_nv, static_cast<natRefPointer<Object>(*)(BoxedObject&&)>(&BoxedObject<type>::Constructor) }
+Reflection::ReflectionConstructorRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_CopyConstructor { AccessSpecifier::AccessSpecifier_public, ConstructorCategory::Copy, static_cast<natRefPointer<Object>(*)(BoxedObject const&)>(&BoxedObject<type>::Constructor) };\
+Reflection::ReflectionConstructorRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_MoveConstructor { AccessSpecifier::AccessSpecifier_public, ConstructorCategory::Move, static_cast<natRefPointer<Object>(*)(BoxedObject&&)>(&BoxedObject<type>::Constructor) }
+
+// 要求这个类型可平凡复制且不超过BoxedValue::Capacity，装箱对象共用BoxedValue的实现
+#define REGISTER_BOXED_VALUE(type) namespace rdetail_\
+{\
+	template <>\
+	struct BoxedValueName<type>\
+	{\
+		static nStrView GetName() noexcept { return #type##_nv; }\
+	};\
+}
+
+#define REGISTER_BOXED_VALUE_DEF(type) template <> Reflection::ReflectionBaseClassesRegister<BoxedObject<type>, Object> BoxedObject<type>::_s_ReflectionHelper_BoxedObject { WITH() };\
+template <> Reflection::ReflectionConstructorRegister<BoxedObject<type>> BoxedObject<type>::_s_ReflectionHelper_BoxedObject_Constructor { AccessSpecifier::AccessSpecifier_public, ConstructorCategory::Normal, static_cast<natRefPointer<Object>(*)(type const&)>(&BoxedObject<type>::Constructor) }
 
 #include "Field.h"
+#include "Record.h"
+#include "Column.h"
+#include "Query.h"
+#include "Serialization.h"
+#include "ObjectView.h"
+#include "Json.h"
+#include "TaggedSerialization.h"
+#include "ChunkedSerialization.h"
 
 template <typename Class, typename T>
 natRefPointer<IType> MemberField<T(Class::*)>::GetType()
@@ -798,9 +1475,9 @@ void Reflection::RegisterNonMemberField(AccessSpecifier accessSpecifier, nStrVie
 }
 
 template <typename Class, typename Field>
-void Reflection::RegisterMemberField(AccessSpecifier accessSpecifier, nStrView name, Field field)
+void Reflection::RegisterMemberField(AccessSpecifier accessSpecifier, nStrView name, Field field, std::uint32_t id)
 {
-	GetType<Class>()->RegisterMemberField(name, make_ref<MemberField<Field>>(accessSpecifier, field));
+	GetType<Class>()->RegisterMemberField(name, make_ref<MemberField<Field>>(accessSpecifier, field, id));
 }
 
 #include "Method.h"
@@ -811,6 +1488,12 @@ void Reflection::RegisterNonMemberMethod(AccessSpecifier accessSpecifier, nStrVi
 	GetType<Class>()->RegisterNonMemberMethod(name, make_ref<NonMemberMethod<Func>>(accessSpecifier, method));
 }
 
+template <typename Class, typename Func>
+void Reflection::RegisterConstructor(AccessSpecifier accessSpecifier, ConstructorCategory category, Func constructor)
+{
+	GetType<Class>()->RegisterConstructor(make_ref<NonMemberMethod<Func>>(accessSpecifier, constructor), category);
+}
+
 template <typename Class, typename Func>
 void Reflection::RegisterMemberMethod(AccessSpecifier accessSpecifier, bool isVirtual, nStrView name, Func method)
 {
@@ -822,11 +1505,26 @@ void Reflection::RegisterMemberMethod(AccessSpecifier accessSpecifier, bool isVi
 
 inline natRefPointer<Object> Convert::ConvertTo(natRefPointer<Object> obj, natRefPointer<IType> toType)
 {
-	if (obj->GetType()->Equal(toType.Get()))
+	const auto type = obj->GetType();
+	if (type->Equal(toType.Get()))
 	{
 		return obj;
 	}
 
+	// 由字符串转换为可解析的类型时直接解析，不经过构造函数的重载决议
+	if (toType->IsParsable())
+	{
+		const auto typeIndex = type->GetTypeIndex();
+		if (typeIndex == typeid(RefString))
+		{
+			return toType->Parse(static_cast<RefString*>(obj.Get())->GetObj().GetView());
+		}
+		if (typeIndex == typeid(RefStringView))
+		{
+			return toType->Parse(static_cast<RefStringView*>(obj.Get())->GetObj());
+		}
+	}
+
 	return toType->Construct({ obj });
 }
 
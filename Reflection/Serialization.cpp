@@ -0,0 +1,574 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	void WriteBoxedScalar(BinaryWriter& writer, rdetail_::ScalarInfo const& scalar, Object* object)
+	{
+		const auto value = scalar.Value(object);
+		switch (scalar.Kind)
+		{
+		case rdetail_::ScalarKind::Bool:
+		{
+			const nByte byte = *static_cast<const bool*>(value) ? 1 : 0;
+			writer.WriteBytes(&byte, 1);
+			break;
+		}
+		case rdetail_::ScalarKind::String:
+			writer.WriteString(*static_cast<const nString*>(value));
+			break;
+		default:
+			writer.WriteBytes(value, scalar.Size);
+			break;
+		}
+	}
+
+	void ReadBoxedScalar(BinaryReader& reader, rdetail_::ScalarInfo const& scalar, Object* object)
+	{
+		const auto value = scalar.Value(object);
+		switch (scalar.Kind)
+		{
+		case rdetail_::ScalarKind::Bool:
+		{
+			nByte byte;
+			reader.ReadBytes(&byte, 1);
+			*static_cast<bool*>(value) = byte != 0;
+			break;
+		}
+		case rdetail_::ScalarKind::String:
+			*static_cast<nString*>(value) = reader.ReadString();
+			break;
+		default:
+			reader.ReadBytes(value, scalar.Size);
+			break;
+		}
+	}
+
+	size_t HashObject(Object* object) noexcept
+	{
+		// 对象地址的低位因对齐而相同，以Fibonacci散列混合到高位后取高位
+		const auto hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object)) * 11400714819323198485ull;
+		return static_cast<size_t>(hash >> 32);
+	}
+}
+
+SerializationPlan::SerializationPlan(natRefPointer<IType> type)
+	: m_Type{ std::move(type) }, m_Boxed{}
+{
+	if (!m_Type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	m_Boxed = rdetail_::FindBoxedScalar(m_Type->GetTypeIndex());
+	if (m_Boxed)
+	{
+		return;
+	}
+
+	if (m_Type->IsBoxed())
+	{
+		nat_Throw(ReflectionException, "Boxed type {0} is not serializable."_nv, m_Type->GetName());
+	}
+
+	m_DefaultConstructor = m_Type->GetConstructor({});
+
+	const auto layout = m_Type->GetRecordLayout();
+	const auto count = layout->GetFieldCount();
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto&& entry = layout->GetField(i);
+		const auto operations = entry.Operations;
+		const auto offset = entry.Field->GetOffset();
+		const auto fieldType = entry.Field->GetFieldTypeIndex();
+
+		if (entry.Field->IsPointer())
+		{
+			if (!operations->ReferencedObject)
+			{
+				nat_Throw(ReflectionException, "Member field {0} of type {1} does not point to an Object."_nv, entry.Name, m_Type->GetName());
+			}
+
+			m_Steps.push_back({ StepKind::Object, offset, operations->Size, entry.Field, operations });
+		}
+		else if (fieldType == typeid(nString))
+		{
+			m_Steps.push_back({ StepKind::String, offset, operations->Size, entry.Field, operations });
+		}
+		else if (fieldType == typeid(bool))
+		{
+			m_Steps.push_back({ StepKind::Bool, offset, operations->Size, entry.Field, operations });
+		}
+		else if (operations->TriviallyCopyable && operations->CopyAssign)
+		{
+			// 与前一个在对象中紧邻的字段合并
+			if (!m_Steps.empty())
+			{
+				auto& last = m_Steps.back();
+				if (last.Kind == StepKind::Raw && last.Offset >= 0 && offset >= 0 && last.Offset + static_cast<std::ptrdiff_t>(last.Size) == offset)
+				{
+					last.Size += operations->Size;
+					continue;
+				}
+			}
+
+			m_Steps.push_back({ StepKind::Raw, offset, operations->Size, entry.Field, operations });
+		}
+		else
+		{
+			nat_Throw(ReflectionException, "Member field {0} of type {1} is not serializable."_nv, entry.Name, m_Type->GetName());
+		}
+	}
+}
+
+natRefPointer<SerializationPlan> SerializationPlan::Get(natRefPointer<IType> const& type)
+{
+	return rdetail_::GetCachedPlan<SerializationPlan>(type);
+}
+
+natRefPointer<IType> const& SerializationPlan::GetType() const noexcept
+{
+	return m_Type;
+}
+
+bool SerializationPlan::IsBoxed() const noexcept
+{
+	return m_Boxed != nullptr;
+}
+
+size_t SerializationPlan::GetStepCount() const noexcept
+{
+	return m_Steps.size();
+}
+
+SerializationPlan::Step const& SerializationPlan::GetStep(size_t n) const
+{
+	if (n >= m_Steps.size())
+	{
+		nat_Throw(ReflectionException, "Step index {0} is out of range."_nv, n);
+	}
+
+	return m_Steps[n];
+}
+
+natRefPointer<Object> SerializationPlan::CreateInstance() const
+{
+	return rdetail_::CreateDefaultInstance(m_DefaultConstructor, m_Type);
+}
+
+BinaryWriter::BinaryWriter(natRefPointer<natStream> stream, ReferenceHandling referenceHandling)
+	: m_Stream{ std::move(stream) }, m_Buffer(BufferSize), m_Used{}, m_Flushed{}, m_ReferenceHandling{ referenceHandling }
+{
+	if (!m_Stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+}
+
+BinaryWriter::~BinaryWriter()
+{
+	try
+	{
+		Flush();
+	}
+	catch (...)
+	{
+	}
+}
+
+void BinaryWriter::Write(natRefPointer<Object> const& object)
+{
+	WriteObject(object.Get(), 0);
+}
+
+void BinaryWriter::Flush()
+{
+	if (!m_Used)
+	{
+		return;
+	}
+
+	if (m_Stream->WriteBytes(m_Buffer.data(), m_Used) != m_Used)
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+
+	m_Flushed += m_Used;
+	m_Used = 0;
+}
+
+nLen BinaryWriter::GetWrittenSize() const noexcept
+{
+	return m_Flushed + m_Used;
+}
+
+void BinaryWriter::WriteVarUInt(std::uint64_t value)
+{
+	nByte bytes[10];
+	size_t size = 0;
+	do
+	{
+		bytes[size] = static_cast<nByte>(value & 0x7F);
+		value >>= 7;
+		if (value)
+		{
+			bytes[size] |= 0x80;
+		}
+		++size;
+	} while (value);
+
+	std::memcpy(Reserve(size), bytes, size);
+}
+
+void BinaryWriter::WriteString(nStrView value)
+{
+	const auto size = value.size() * sizeof(nStrView::CharType);
+	WriteVarUInt(size);
+	WriteBytes(value.data(), size);
+}
+
+void BinaryWriter::WriteBytes(const void* data, size_t size)
+{
+	if (size <= m_Buffer.size())
+	{
+		std::memcpy(Reserve(size), data, size);
+		return;
+	}
+
+	// 大块数据直接写入流
+	Flush();
+	if (m_Stream->WriteBytes(static_cast<ncData>(data), size) != size)
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+	m_Flushed += size;
+}
+
+SerializationPlan const& BinaryWriter::WriteTypeReference(natRefPointer<IType> const& type)
+{
+	const auto iter = m_Types.find(type.Get());
+	if (iter != m_Types.end())
+	{
+		WriteVarUInt(iter->second.Id);
+		return *iter->second.Plan;
+	}
+
+	auto plan = SerializationPlan::Get(type);
+	const auto id = m_Types.size() + 1;
+	WriteVarUInt(id);
+	WriteString(type->GetName());
+	return *m_Types.emplace(type.Get(), TypeEntry{ id, std::move(plan) }).first->second.Plan;
+}
+
+size_t BinaryWriter::AddObject(Object* object)
+{
+	// 装载因子不超过1/2
+	if ((m_Objects.size() + 1) * 2 > m_ObjectTable.size())
+	{
+		GrowObjectTable();
+	}
+
+	const auto mask = m_ObjectTable.size() - 1;
+	for (auto slot = HashObject(object) & mask;; slot = (slot + 1) & mask)
+	{
+		auto& entry = m_ObjectTable[slot];
+		if (entry.Target == object)
+		{
+			return entry.Id;
+		}
+
+		if (!entry.Target)
+		{
+			m_Objects.emplace_back(object);
+			entry = { object, m_Objects.size() };
+			return 0;
+		}
+	}
+}
+
+void BinaryWriter::GrowObjectTable()
+{
+	std::vector<ObjectSlot> table(std::max<size_t>(m_ObjectTable.size() * 2, 64), ObjectSlot{});
+	const auto mask = table.size() - 1;
+	for (auto const& entry : m_ObjectTable)
+	{
+		if (entry.Target)
+		{
+			auto slot = HashObject(entry.Target) & mask;
+			while (table[slot].Target)
+			{
+				slot = (slot + 1) & mask;
+			}
+			table[slot] = entry;
+		}
+	}
+
+	m_ObjectTable = std::move(table);
+}
+
+void BinaryWriter::WriteObject(Object* object, size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		nat_Throw(ReflectionException, "Object graph is too deep or contains a cycle."_nv);
+	}
+
+	if (!object)
+	{
+		WriteVarUInt(0);
+		return;
+	}
+
+	// 对象引用为0时表示nullptr，不超过已写入对象数时引用已写入的对象，否则为新对象，之后是类型引用及其内容
+	if (m_ReferenceHandling == ReferenceHandling::Preserve)
+	{
+		if (const auto id = AddObject(object))
+		{
+			WriteVarUInt(id);
+			return;
+		}
+
+		WriteVarUInt(m_Objects.size());
+	}
+
+	WritePayload(WriteTypeReference(object->GetType()), object, depth);
+}
+
+void BinaryWriter::WritePayload(SerializationPlan const& plan, Object* object, size_t depth)
+{
+	if (plan.m_Boxed)
+	{
+		WriteBoxedScalar(*this, *plan.m_Boxed, object);
+		return;
+	}
+
+	const auto base = reinterpret_cast<const nByte*>(object);
+	for (auto const& step : plan.m_Steps)
+	{
+		const auto address = step.Offset >= 0 ? base + step.Offset : static_cast<const nByte*>(step.Field->GetAddress(object));
+		switch (step.Kind)
+		{
+		case SerializationPlan::StepKind::Raw:
+			std::memcpy(Reserve(step.Size), address, step.Size);
+			break;
+		case SerializationPlan::StepKind::Bool:
+			*Reserve(1) = *reinterpret_cast<const bool*>(address) ? 1 : 0;
+			break;
+		case SerializationPlan::StepKind::String:
+			WriteString(*reinterpret_cast<const nString*>(address));
+			break;
+		case SerializationPlan::StepKind::Object:
+			WriteObject(step.Operations->ReferencedObject(address), depth + 1);
+			break;
+		}
+	}
+}
+
+nByte* BinaryWriter::Reserve(size_t size)
+{
+	if (m_Used + size > m_Buffer.size())
+	{
+		Flush();
+		if (size > m_Buffer.size())
+		{
+			m_Buffer.resize(size);
+		}
+	}
+
+	const auto result = m_Buffer.data() + m_Used;
+	m_Used += size;
+	return result;
+}
+
+BinaryReader::BinaryReader(natRefPointer<natStream> stream, ReferenceHandling referenceHandling)
+	: m_Input{ std::move(stream), BufferSize }, m_ReferenceHandling{ referenceHandling }
+{
+}
+
+BinaryReader::~BinaryReader()
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+}
+
+natRefPointer<Object> BinaryReader::Read()
+{
+	return ReadObject(0);
+}
+
+void BinaryReader::ReadInto(natRefPointer<Object> const& object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	if (m_ReferenceHandling == ReferenceHandling::Preserve)
+	{
+		const auto id = ReadVarUInt();
+		if (!id)
+		{
+			nat_Throw(ReflectionException, "Stream contains a null object."_nv);
+		}
+
+		if (id != m_Objects.size() + 1)
+		{
+			nat_Throw(ReflectionException, "Stream contains a reference to an object which has been read."_nv);
+		}
+
+		m_Objects.emplace_back(object);
+	}
+
+	const auto plan = ReadTypeReference();
+	if (!plan)
+	{
+		nat_Throw(ReflectionException, "Stream contains a null object."_nv);
+	}
+
+	if (!plan->GetType()->Equal(object->GetType().Get()))
+	{
+		nat_Throw(ReflectionException, "Stream contains an object of type {0}, which does not match {1}."_nv, plan->GetType()->GetName(), object->GetType()->GetName());
+	}
+
+	if (plan->m_Boxed)
+	{
+		ReadBoxedScalar(*this, *plan->m_Boxed, object.Get());
+		return;
+	}
+
+	ReadPayload(*plan, object, 0);
+	DirtyTracking::MarkAll(object.Get());
+}
+
+void BinaryReader::Close()
+{
+	m_Input.Close();
+}
+
+std::uint64_t BinaryReader::ReadVarUInt()
+{
+	return m_Input.ReadVarUInt();
+}
+
+nString BinaryReader::ReadString()
+{
+	return m_Input.ReadString(m_Input.ReadVarUInt());
+}
+
+void BinaryReader::ReadBytes(void* data, size_t size)
+{
+	m_Input.ReadBytes(data, size);
+}
+
+SerializationPlan const* BinaryReader::ReadTypeReference()
+{
+	const auto id = ReadVarUInt();
+	if (!id)
+	{
+		return nullptr;
+	}
+
+	if (id == m_Types.size() + 1)
+	{
+		const auto name = ReadString();
+		m_Types.emplace_back(SerializationPlan::Get(Reflection::GetInstance().GetType(name.GetView())));
+	}
+	else if (id > m_Types.size())
+	{
+		nat_Throw(ReflectionException, "Invalid type reference {0}."_nv, id);
+	}
+
+	return m_Types[static_cast<size_t>(id - 1)].Get();
+}
+
+natRefPointer<Object> BinaryReader::ReadObject(size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		nat_Throw(ReflectionException, "Object graph is too deep."_nv);
+	}
+
+	const auto preserve = m_ReferenceHandling == ReferenceHandling::Preserve;
+	if (preserve)
+	{
+		const auto id = ReadVarUInt();
+		if (!id)
+		{
+			return {};
+		}
+
+		if (id <= m_Objects.size())
+		{
+			return m_Objects[static_cast<size_t>(id - 1)];
+		}
+
+		if (id != m_Objects.size() + 1)
+		{
+			nat_Throw(ReflectionException, "Invalid object reference {0}."_nv, id);
+		}
+	}
+
+	const auto plan = ReadTypeReference();
+	if (!plan)
+	{
+		if (preserve)
+		{
+			nat_Throw(ReflectionException, "Object has no type."_nv);
+		}
+
+		return {};
+	}
+
+	if (plan->m_Boxed)
+	{
+		auto object = plan->m_Boxed->Create();
+		ReadBoxedScalar(*this, *plan->m_Boxed, object.Get());
+		if (preserve)
+		{
+			m_Objects.emplace_back(object);
+		}
+
+		return object;
+	}
+
+	auto object = plan->CreateInstance();
+	// 在读取字段前登记，使循环引用能够指向此对象
+	if (preserve)
+	{
+		m_Objects.emplace_back(object);
+	}
+
+	ReadPayload(*plan, object, depth);
+	DirtyTracking::Clear(object.Get());
+	return object;
+}
+
+void BinaryReader::ReadPayload(SerializationPlan const& plan, natRefPointer<Object> const& object, size_t depth)
+{
+	const auto base = reinterpret_cast<nByte*>(object.Get());
+	for (auto const& step : plan.m_Steps)
+	{
+		const auto address = step.Offset >= 0 ? base + step.Offset : static_cast<nByte*>(step.Field->GetAddress(object.Get()));
+		switch (step.Kind)
+		{
+		case SerializationPlan::StepKind::Raw:
+			m_Input.ReadBytes(address, step.Size);
+			break;
+		case SerializationPlan::StepKind::Bool:
+			*reinterpret_cast<bool*>(address) = *m_Input.Take(1) != 0;
+			break;
+		case SerializationPlan::StepKind::String:
+			*reinterpret_cast<nString*>(address) = ReadString();
+			break;
+		case SerializationPlan::StepKind::Object:
+			step.Field->WriteFrom(object, ReadObject(depth + 1));
+			break;
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include "SerializationDetail.h"
+
+/// @brief	BinaryWriter及BinaryReader处理natRefPointer字段所指向对象的方式，读写双方需一致
+enum class ReferenceHandling
+{
+	/// @brief	每次引用均完整编码所指向的对象
+	Duplicate,
+	/// @brief	每个对象只编码一次，再次出现时以序号引用，读取时恢复共享及循环引用
+	Preserve,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型的二进制序列化计划
+/// @note	由类型的RecordLayout生成，字段按布局顺序编码，不记录字段名
+///			可平凡复制的字段按原生字节序直接复制，在对象中相邻的此类字段合并为一次复制
+///			nString编码为长度及UTF-8字节，IsPointer为true的字段递归编码所指向的对象，其指向的类型需派生自Object
+///			装箱的基本类型及RefString编码为其值
+///			同一类型的计划只生成一次，可被多个线程同时使用
+////////////////////////////////////////////////////////////////////////////////
+class SerializationPlan final
+	: public natRefObjImpl<SerializationPlan, Interface>
+{
+public:
+	enum class StepKind
+	{
+		Raw,
+		Bool,
+		String,
+		Object,
+	};
+
+	struct Step
+	{
+		StepKind Kind;
+		/// @brief	字段在对象中的偏移，为负时通过Field->GetAddress获得地址
+		std::ptrdiff_t Offset;
+		/// @brief	Raw步骤复制的字节数，可能包含多个字段
+		size_t Size;
+		natRefPointer<IMemberField> Field;
+		ValueOperations const* Operations;
+	};
+
+	/// @brief	若类型存在不可序列化的字段则抛出ReflectionException
+	explicit SerializationPlan(natRefPointer<IType> type);
+
+	/// @brief	获得类型的计划，首次获得时生成
+	static natRefPointer<SerializationPlan> Get(natRefPointer<IType> const& type);
+
+	natRefPointer<IType> const& GetType() const noexcept;
+	bool IsBoxed() const noexcept;
+	size_t GetStepCount() const noexcept;
+	Step const& GetStep(size_t n) const;
+
+	/// @brief	以无参构造函数创建用于反序列化的对象
+	/// @note	类型没有注册无参构造函数时抛出ReflectionException
+	natRefPointer<Object> CreateInstance() const;
+
+private:
+	friend class BinaryWriter;
+	friend class BinaryReader;
+
+	natRefPointer<IType> m_Type;
+	rdetail_::ScalarInfo const* m_Boxed;
+	std::vector<Step> m_Steps;
+	natRefPointer<IMethod> m_DefaultConstructor;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	将对象编码到流中
+/// @note	数据先写入内部缓冲区，缓冲区满、调用Flush或析构时写入流
+///			每种类型在流中首次出现时记录其名称，之后以序号引用
+///			ReferenceHandling::Duplicate时共享的对象将被重复编码，循环引用将因超过MaxDepth而抛出异常
+///			ReferenceHandling::Preserve时以对象地址识别已写入的对象，范围为写入器的整个生命周期，已写入的对象被持有直至写入器析构
+////////////////////////////////////////////////////////////////////////////////
+class BinaryWriter final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = 256;
+
+	explicit BinaryWriter(natRefPointer<natStream> stream, ReferenceHandling referenceHandling = ReferenceHandling::Duplicate);
+	~BinaryWriter();
+
+	BinaryWriter(BinaryWriter const&) = delete;
+	BinaryWriter& operator=(BinaryWriter const&) = delete;
+
+	/// @brief	写入对象，object可为nullptr
+	void Write(natRefPointer<Object> const& object);
+	void Flush();
+
+	/// @brief	已写入的字节数，包括尚在缓冲区中的部分
+	nLen GetWrittenSize() const noexcept;
+
+	void WriteVarUInt(std::uint64_t value);
+	void WriteString(nStrView value);
+	void WriteBytes(const void* data, size_t size);
+
+private:
+	struct TypeEntry
+	{
+		size_t Id;
+		natRefPointer<SerializationPlan> Plan;
+	};
+
+	/// @brief	对象表的槽，Target为nullptr时表示空槽
+	struct ObjectSlot
+	{
+		Object* Target;
+		size_t Id;
+	};
+
+	/// @brief	写入类型引用，类型首次出现时同时写入名称
+	SerializationPlan const& WriteTypeReference(natRefPointer<IType> const& type);
+	/// @brief	查找已写入的对象
+	/// @return	对象已写入时返回其序号，否则为其分配序号并返回0
+	size_t AddObject(Object* object);
+	void GrowObjectTable();
+	void WriteObject(Object* object, size_t depth);
+	void WritePayload(SerializationPlan const& plan, Object* object, size_t depth);
+	nByte* Reserve(size_t size);
+
+	natRefPointer<natStream> m_Stream;
+	std::vector<nByte> m_Buffer;
+	size_t m_Used;
+	nLen m_Flushed;
+	std::unordered_map<IType*, TypeEntry> m_Types;
+	ReferenceHandling m_ReferenceHandling;
+	/// @brief	以对象地址为键的开放寻址表，容量为2的幂
+	std::vector<ObjectSlot> m_ObjectTable;
+	/// @brief	已写入的对象，持有以免其地址被复用后与其他对象混淆
+	std::vector<natRefPointer<Object>> m_Objects;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	从流中解码由BinaryWriter写入的对象
+/// @note	会预读流中的数据，Close或析构时若流支持定位则将位置退回到最后读取的对象之后
+///			读取到不完整或不合法的数据时抛出ReflectionException
+///			ReferenceHandling::Preserve时已读取的对象被持有直至读取器析构，以便之后的引用指向同一对象
+////////////////////////////////////////////////////////////////////////////////
+class BinaryReader final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = BinaryWriter::MaxDepth;
+
+	explicit BinaryReader(natRefPointer<natStream> stream, ReferenceHandling referenceHandling = ReferenceHandling::Duplicate);
+	~BinaryReader();
+
+	BinaryReader(BinaryReader const&) = delete;
+	BinaryReader& operator=(BinaryReader const&) = delete;
+
+	/// @brief	读取对象，可能返回nullptr
+	natRefPointer<Object> Read();
+	/// @brief	将对象读入已存在的对象中
+	/// @note	流中的对象类型需与object的类型一致
+	void ReadInto(natRefPointer<Object> const& object);
+	/// @brief	退回预读的数据
+	void Close();
+
+	std::uint64_t ReadVarUInt();
+	nString ReadString();
+	void ReadBytes(void* data, size_t size);
+
+private:
+	/// @brief	读取类型引用，为空引用时返回nullptr
+	SerializationPlan const* ReadTypeReference();
+	natRefPointer<Object> ReadObject(size_t depth);
+	void ReadPayload(SerializationPlan const& plan, natRefPointer<Object> const& object, size_t depth);
+
+	rdetail_::StreamInput m_Input;
+	std::vector<natRefPointer<SerializationPlan>> m_Types;
+	ReferenceHandling m_ReferenceHandling;
+	std::vector<natRefPointer<Object>> m_Objects;
+};
@@ -0,0 +1,406 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#if !defined(__cpp_lib_to_chars) && defined(__APPLE__)
+#include <xlocale.h>
+#endif
+
+namespace
+{
+	template <typename T>
+	struct ScalarKindOf
+		: std::integral_constant<rdetail_::ScalarKind, std::is_signed<T>::value ? rdetail_::ScalarKind::Signed : rdetail_::ScalarKind::Unsigned>
+	{
+	};
+
+	template <>
+	struct ScalarKindOf<bool>
+		: std::integral_constant<rdetail_::ScalarKind, rdetail_::ScalarKind::Bool>
+	{
+	};
+
+	template <>
+	struct ScalarKindOf<float>
+		: std::integral_constant<rdetail_::ScalarKind, rdetail_::ScalarKind::Float>
+	{
+	};
+
+	template <>
+	struct ScalarKindOf<double>
+		: std::integral_constant<rdetail_::ScalarKind, rdetail_::ScalarKind::Double>
+	{
+	};
+
+	template <>
+	struct ScalarKindOf<nString>
+		: std::integral_constant<rdetail_::ScalarKind, rdetail_::ScalarKind::String>
+	{
+	};
+
+	template <typename T>
+	struct BoxedAccess
+	{
+		static void* Value(Object* object)
+		{
+			return &object->Unbox<T>();
+		}
+
+		static natRefPointer<Object> Create()
+		{
+			return Object::Box(T{});
+		}
+	};
+
+	template <typename T>
+	rdetail_::ScalarInfo MakeFieldScalar()
+	{
+		return { typeid(T), ScalarKindOf<T>::value, sizeof(T), nullptr, nullptr };
+	}
+
+	template <typename T>
+	rdetail_::ScalarInfo MakeBoxedScalar()
+	{
+		return { typeid(BoxedObject<T>), ScalarKindOf<T>::value, sizeof(T), &BoxedAccess<T>::Value, &BoxedAccess<T>::Create };
+	}
+
+	// 文本中的数字格式与区域设置无关，不能使用受当前区域设置影响的snprintf及strtod
+#ifdef __cpp_lib_to_chars
+	// 输出可精确往返的最短表示
+	template <typename T>
+	size_t FormatRoundTrip(T value, char* buffer, size_t size) noexcept
+	{
+		return static_cast<size_t>(std::to_chars(buffer, buffer + size, value).ptr - buffer);
+	}
+
+	size_t FormatFixed(double value, char* buffer, size_t size) noexcept
+	{
+		return static_cast<size_t>(std::to_chars(buffer, buffer + size, value, std::chars_format::fixed, 6).ptr - buffer);
+	}
+
+	template <typename T>
+	std::errc ParseNumber(const char* begin, const char* end, T& value) noexcept
+	{
+		const auto result = std::from_chars(begin, end, value);
+		if (result.ec != std::errc{})
+		{
+			return result.ec;
+		}
+
+		return result.ptr == end ? std::errc{} : std::errc::invalid_argument;
+	}
+#else
+	// VS2017的std::to_chars及std::from_chars尚不支持浮点数，使用指定C区域设置的版本
+#ifdef _MSC_VER
+	_locale_t GetCLocale() noexcept
+	{
+		static const auto s_Locale = _create_locale(LC_ALL, "C");
+		return s_Locale;
+	}
+
+	double StringToFloatingPoint(const char* buffer, char** parsed, double) noexcept
+	{
+		return _strtod_l(buffer, parsed, GetCLocale());
+	}
+
+	float StringToFloatingPoint(const char* buffer, char** parsed, float) noexcept
+	{
+		return _strtof_l(buffer, parsed, GetCLocale());
+	}
+#else
+	locale_t GetCLocale() noexcept
+	{
+		static const auto s_Locale = newlocale(LC_ALL_MASK, "C", locale_t{});
+		return s_Locale;
+	}
+
+	double StringToFloatingPoint(const char* buffer, char** parsed, double) noexcept
+	{
+		return strtod_l(buffer, parsed, GetCLocale());
+	}
+
+	float StringToFloatingPoint(const char* buffer, char** parsed, float) noexcept
+	{
+		return strtof_l(buffer, parsed, GetCLocale());
+	}
+#endif
+
+	size_t FormatWithCLocale(const char* format, double value, char* buffer, size_t size) noexcept
+	{
+#ifdef _MSC_VER
+		const auto length = _snprintf_s_l(buffer, size, _TRUNCATE, format, GetCLocale(), value);
+#else
+		const auto previous = uselocale(GetCLocale());
+		const auto length = std::snprintf(buffer, size, format, value);
+		uselocale(previous);
+#endif
+		return static_cast<size_t>(std::max(length, 0));
+	}
+
+	template <typename T>
+	size_t FormatRoundTrip(T value, char* buffer, size_t size) noexcept
+	{
+		return FormatWithCLocale(std::is_same<T, float>::value ? "%.9g" : "%.17g", static_cast<double>(value), buffer, size);
+	}
+
+	size_t FormatFixed(double value, char* buffer, size_t size) noexcept
+	{
+		return FormatWithCLocale("%f", value, buffer, size);
+	}
+
+	template <typename T>
+	std::errc ParseNumber(const char* begin, const char* end, T& value) noexcept
+	{
+		// strtod要求以空字符结尾，与from_chars一致不接受前导的'+'及空白，另外也不接受inf、nan及十六进制
+		char buffer[64];
+		const auto length = static_cast<size_t>(end - begin);
+		if (!length || length >= sizeof buffer || *begin == '+' || !std::all_of(begin, end, [](char c)
+		{
+			return (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '-' || c == '+';
+		}))
+		{
+			return std::errc::invalid_argument;
+		}
+		std::memcpy(buffer, begin, length);
+		buffer[length] = 0;
+
+		char* parsed;
+		errno = 0;
+		const auto result = StringToFloatingPoint(buffer, &parsed, T{});
+		if (parsed != buffer + length)
+		{
+			return std::errc::invalid_argument;
+		}
+		if (errno == ERANGE)
+		{
+			return std::errc::result_out_of_range;
+		}
+
+		value = result;
+		return {};
+	}
+#endif
+
+
+	template <size_t N>
+	rdetail_::ScalarInfo const* FindScalar(rdetail_::ScalarInfo const (&scalars)[N], std::type_index type) noexcept
+	{
+		for (auto const& scalar : scalars)
+		{
+			if (scalar.Type == type)
+			{
+				return &scalar;
+			}
+		}
+
+		return nullptr;
+	}
+}
+
+rdetail_::ScalarInfo const* rdetail_::FindFieldScalar(std::type_index type) noexcept
+{
+	static const ScalarInfo s_Scalars[]
+	{
+		MakeFieldScalar<bool>(),
+		MakeFieldScalar<char>(),
+		MakeFieldScalar<signed char>(),
+		MakeFieldScalar<unsigned char>(),
+		MakeFieldScalar<wchar_t>(),
+		MakeFieldScalar<char16_t>(),
+		MakeFieldScalar<char32_t>(),
+		MakeFieldScalar<short>(),
+		MakeFieldScalar<unsigned short>(),
+		MakeFieldScalar<int>(),
+		MakeFieldScalar<unsigned>(),
+		MakeFieldScalar<long>(),
+		MakeFieldScalar<unsigned long>(),
+		MakeFieldScalar<long long>(),
+		MakeFieldScalar<unsigned long long>(),
+		MakeFieldScalar<float>(),
+		MakeFieldScalar<double>(),
+		MakeFieldScalar<nString>(),
+	};
+
+	return FindScalar(s_Scalars, type);
+}
+
+rdetail_::ScalarInfo const* rdetail_::FindBoxedScalar(std::type_index type) noexcept
+{
+	static const ScalarInfo s_Scalars[]
+	{
+		MakeBoxedScalar<bool>(),
+		MakeBoxedScalar<char>(),
+		MakeBoxedScalar<wchar_t>(),
+		MakeBoxedScalar<std::int8_t>(),
+		MakeBoxedScalar<std::uint8_t>(),
+		MakeBoxedScalar<std::int16_t>(),
+		MakeBoxedScalar<std::uint16_t>(),
+		MakeBoxedScalar<std::int32_t>(),
+		MakeBoxedScalar<std::uint32_t>(),
+		MakeBoxedScalar<std::int64_t>(),
+		MakeBoxedScalar<std::uint64_t>(),
+		MakeBoxedScalar<float>(),
+		MakeBoxedScalar<double>(),
+		MakeBoxedScalar<nString>(),
+	};
+
+	return FindScalar(s_Scalars, type);
+}
+
+size_t rdetail_::FormatFloatingPoint(float value, char* buffer, size_t size) noexcept
+{
+	return FormatRoundTrip(value, buffer, size);
+}
+
+size_t rdetail_::FormatFloatingPoint(double value, char* buffer, size_t size) noexcept
+{
+	return FormatRoundTrip(value, buffer, size);
+}
+
+size_t rdetail_::FormatFixedPoint(double value, char* buffer, size_t size) noexcept
+{
+	return FormatFixed(value, buffer, size);
+}
+
+std::errc rdetail_::ParseFloatingPoint(const char* begin, const char* end, float& value) noexcept
+{
+	return ParseNumber(begin, end, value);
+}
+
+std::errc rdetail_::ParseFloatingPoint(const char* begin, const char* end, double& value) noexcept
+{
+	return ParseNumber(begin, end, value);
+}
+
+natRefPointer<Object> rdetail_::CreateDefaultInstance(natRefPointer<IMethod> const& constructor, natRefPointer<IType> const& type)
+{
+	if (!constructor)
+	{
+		nat_Throw(ReflectionException, "Type {0} has no registered default constructor."_nv, type->GetName());
+	}
+
+	return constructor->Invoke({});
+}
+
+rdetail_::StreamInput::StreamInput(natRefPointer<natStream> stream, size_t bufferSize)
+	: m_Stream{ std::move(stream) }, m_Buffer(bufferSize), m_Begin{}, m_End{}, m_Base{}
+{
+	if (!m_Stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+}
+
+const nByte* rdetail_::StreamInput::Take(size_t size)
+{
+	if (m_End - m_Begin < size)
+	{
+		// 将剩余数据移至缓冲区开头后补充
+		std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, m_End - m_Begin);
+		m_Base += m_Begin;
+		m_End -= m_Begin;
+		m_Begin = 0;
+
+		if (m_Buffer.size() < size)
+		{
+			m_Buffer.resize(size);
+		}
+
+		while (m_End < size)
+		{
+			const auto read = static_cast<size_t>(m_Stream->ReadBytes(m_Buffer.data() + m_End, m_Buffer.size() - m_End));
+			if (!read)
+			{
+				nat_Throw(ReflectionException, "Unexpected end of stream."_nv);
+			}
+			m_End += read;
+		}
+	}
+
+	const auto result = m_Buffer.data() + m_Begin;
+	m_Begin += size;
+	return result;
+}
+
+void rdetail_::StreamInput::ReadBytes(void* data, size_t size)
+{
+	auto dest = static_cast<nByte*>(data);
+	while (size)
+	{
+		const auto chunk = std::min(size, m_Buffer.size());
+		std::memcpy(dest, Take(chunk), chunk);
+		dest += chunk;
+		size -= chunk;
+	}
+}
+
+void rdetail_::StreamInput::SkipBytes(std::uint64_t size)
+{
+	while (size)
+	{
+		const auto chunk = static_cast<size_t>(std::min<std::uint64_t>(size, m_Buffer.size()));
+		Take(chunk);
+		size -= chunk;
+	}
+}
+
+std::uint64_t rdetail_::StreamInput::ReadVarUInt()
+{
+	std::uint64_t result = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7)
+	{
+		const auto byte = *Take(1);
+		result |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+		{
+			return result;
+		}
+	}
+
+	nat_Throw(ReflectionException, "Malformed variable-length integer."_nv);
+}
+
+nString rdetail_::StreamInput::ReadString(std::uint64_t size)
+{
+	if (size % sizeof(nStrView::CharType))
+	{
+		nat_Throw(ReflectionException, "Malformed string."_nv);
+	}
+
+	if (size <= m_Buffer.size())
+	{
+		const auto data = reinterpret_cast<const nStrView::CharType*>(Take(static_cast<size_t>(size)));
+		return nString{ nStrView{ data, static_cast<size_t>(size / sizeof(nStrView::CharType)) } };
+	}
+
+	// 长字符串分段读取，避免依据未经验证的长度一次性分配内存
+	nString result;
+	for (auto remaining = size; remaining;)
+	{
+		const auto chunk = static_cast<size_t>(std::min<std::uint64_t>(remaining, m_Buffer.size()));
+		const auto data = reinterpret_cast<const nStrView::CharType*>(Take(chunk));
+		result.Append(nStrView{ data, chunk / sizeof(nStrView::CharType) });
+		remaining -= chunk;
+	}
+
+	return result;
+}
+
+std::uint64_t rdetail_::StreamInput::GetPosition() const noexcept
+{
+	return m_Base + m_Begin;
+}
+
+void rdetail_::StreamInput::Close()
+{
+	if (m_End > m_Begin)
+	{
+		m_Stream->SetPosition(NatSeek::Cur, -static_cast<nLong>(m_End - m_Begin));
+	}
+	m_Base += m_Begin;
+	m_Begin = m_End = 0;
+}
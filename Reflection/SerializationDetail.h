@@ -0,0 +1,175 @@
+#pragma once
+#include "Interface.h"
+#include <natStream.h>
+#include <cstdint>
+#include <mutex>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	各序列化器共用的内部实现
+/// @note	仅供Serialization、ObjectView、Json、TaggedSerialization及装箱类型的文本转换使用
+////////////////////////////////////////////////////////////////////////////////
+namespace rdetail_
+{
+	/// @brief	可直接编码的值的种类
+	/// @note	JsonPlan::ValueKind及TaggedPlan::ValueKind以相同的顺序包含这些枚举值
+	enum class ScalarKind
+	{
+		Bool,
+		Signed,
+		Unsigned,
+		Float,
+		Double,
+		String,
+	};
+
+	/// @brief	可直接编码的字段类型或装箱类型
+	struct ScalarInfo
+	{
+		std::type_index Type;
+		ScalarKind Kind;
+		size_t Size;
+		/// @brief	获得装箱对象中值的地址，仅用于装箱类型
+		void*(*Value)(Object* object);
+		/// @brief	创建装箱对象，仅用于装箱类型
+		natRefPointer<Object>(*Create)();
+	};
+
+	/// @brief	以字段类型查找，不支持时返回nullptr
+	ScalarInfo const* FindFieldScalar(std::type_index type) noexcept;
+	/// @brief	以装箱类型查找，不支持时返回nullptr
+	ScalarInfo const* FindBoxedScalar(std::type_index type) noexcept;
+
+	template <typename ValueKind>
+	ValueKind ToValueKind(ScalarKind kind) noexcept
+	{
+		static_assert(static_cast<int>(ValueKind::Bool) == static_cast<int>(ScalarKind::Bool) &&
+			static_cast<int>(ValueKind::Signed) == static_cast<int>(ScalarKind::Signed) &&
+			static_cast<int>(ValueKind::Unsigned) == static_cast<int>(ScalarKind::Unsigned) &&
+			static_cast<int>(ValueKind::Float) == static_cast<int>(ScalarKind::Float) &&
+			static_cast<int>(ValueKind::Double) == static_cast<int>(ScalarKind::Double) &&
+			static_cast<int>(ValueKind::String) == static_cast<int>(ScalarKind::String), "ValueKind should begin with the enumerators of ScalarKind.");
+
+		return static_cast<ValueKind>(kind);
+	}
+
+	inline std::int64_t LoadSigned(const void* value, size_t size) noexcept
+	{
+		switch (size)
+		{
+		case 1:
+			return *static_cast<const std::int8_t*>(value);
+		case 2:
+			return *static_cast<const std::int16_t*>(value);
+		case 4:
+			return *static_cast<const std::int32_t*>(value);
+		default:
+			return *static_cast<const std::int64_t*>(value);
+		}
+	}
+
+	inline std::uint64_t LoadUnsigned(const void* value, size_t size) noexcept
+	{
+		switch (size)
+		{
+		case 1:
+			return *static_cast<const std::uint8_t*>(value);
+		case 2:
+			return *static_cast<const std::uint16_t*>(value);
+		case 4:
+			return *static_cast<const std::uint32_t*>(value);
+		default:
+			return *static_cast<const std::uint64_t*>(value);
+		}
+	}
+
+	inline void StoreInteger(void* value, size_t size, std::uint64_t bits) noexcept
+	{
+		switch (size)
+		{
+		case 1:
+			*static_cast<std::uint8_t*>(value) = static_cast<std::uint8_t>(bits);
+			break;
+		case 2:
+			*static_cast<std::uint16_t*>(value) = static_cast<std::uint16_t>(bits);
+			break;
+		case 4:
+			*static_cast<std::uint32_t*>(value) = static_cast<std::uint32_t>(bits);
+			break;
+		default:
+			*static_cast<std::uint64_t*>(value) = bits;
+			break;
+		}
+	}
+
+	/// @brief	以与区域设置无关的格式写入可精确往返的最短表示
+	/// @return	写入的字符数
+	size_t FormatFloatingPoint(float value, char* buffer, size_t size) noexcept;
+	size_t FormatFloatingPoint(double value, char* buffer, size_t size) noexcept;
+	/// @brief	以与区域设置无关的格式写入保留6位小数的表示，与std::to_string相同
+	/// @return	写入的字符数，size不足时结果被截断
+	size_t FormatFixedPoint(double value, char* buffer, size_t size) noexcept;
+	/// @brief	以与区域设置无关的格式解析[begin, end)中的全部字符
+	/// @note	格式同std::from_chars，不接受前导的'+'及空白
+	std::errc ParseFloatingPoint(const char* begin, const char* end, float& value) noexcept;
+	std::errc ParseFloatingPoint(const char* begin, const char* end, double& value) noexcept;
+
+	/// @brief	以无参构造函数创建用于解码的对象
+	/// @note	constructor为nullptr时抛出ReflectionException
+	natRefPointer<Object> CreateDefaultInstance(natRefPointer<IMethod> const& constructor, natRefPointer<IType> const& type);
+
+	/// @brief	获得类型的计划，首次获得时以Plan(type)生成，之后一直保留
+	template <typename Plan>
+	natRefPointer<Plan> GetCachedPlan(natRefPointer<IType> const& type)
+	{
+		static std::mutex s_Mutex;
+		static std::unordered_map<IType*, natRefPointer<Plan>> s_Plans;
+
+		if (!type)
+		{
+			nat_Throw(NullPointerException, "Type is nullptr."_nv);
+		}
+
+		std::lock_guard<std::mutex> lock{ s_Mutex };
+		auto& plan = s_Plans[type.Get()];
+		if (!plan)
+		{
+			plan = make_ref<Plan>(type);
+		}
+
+		return plan;
+	}
+
+	////////////////////////////////////////////////////////////////////////////////
+	/// @brief	预读流中数据的输入缓冲区
+	/// @note	读取到流的末尾时抛出ReflectionException
+	////////////////////////////////////////////////////////////////////////////////
+	class StreamInput final
+	{
+	public:
+		StreamInput(natRefPointer<natStream> stream, size_t bufferSize);
+
+		/// @brief	获得接下来的size个字节，返回的指针在下次读取前有效
+		const nByte* Take(size_t size);
+		void ReadBytes(void* data, size_t size);
+		void SkipBytes(std::uint64_t size);
+		std::uint64_t ReadVarUInt();
+		/// @brief	读取size个字节的字符串
+		nString ReadString(std::uint64_t size);
+
+		/// @brief	已读取的字节数
+		std::uint64_t GetPosition() const noexcept;
+		/// @brief	退回预读的数据
+		void Close();
+
+	private:
+		natRefPointer<natStream> m_Stream;
+		std::vector<nByte> m_Buffer;
+		size_t m_Begin;
+		size_t m_End;
+		/// @brief	m_Buffer开头在流中的位置
+		std::uint64_t m_Base;
+	};
+}
@@ -0,0 +1,613 @@
+#include "Reflection.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	TaggedPlan::WireType GetWireType(TaggedPlan::ValueKind kind) noexcept
+	{
+		switch (kind)
+		{
+		case TaggedPlan::ValueKind::Bool:
+		case TaggedPlan::ValueKind::Signed:
+		case TaggedPlan::ValueKind::Unsigned:
+			return TaggedPlan::WireType::Varint;
+		case TaggedPlan::ValueKind::Float:
+			return TaggedPlan::WireType::Fixed32;
+		case TaggedPlan::ValueKind::Double:
+			return TaggedPlan::WireType::Fixed64;
+		default:
+			return TaggedPlan::WireType::LengthDelimited;
+		}
+	}
+
+	// 类型引用，0表示nullptr
+	constexpr std::uint64_t DeclaredTypeReference = 1;
+	constexpr std::uint64_t NamedTypeReference = 2;
+
+	// 嵌套对象的长度前缀固定占用的字节数，写入对象后回填
+	constexpr size_t LengthPrefixSize = 5;
+}
+
+TaggedPlan::TaggedPlan(natRefPointer<IType> type)
+	: m_Type{ std::move(type) }, m_Boxed{}
+{
+	if (!m_Type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	m_Boxed = rdetail_::FindBoxedScalar(m_Type->GetTypeIndex());
+	if (m_Boxed)
+	{
+		const auto kind = rdetail_::ToValueKind<ValueKind>(m_Boxed->Kind);
+		m_Members.push_back({ 1, kind, GetWireType(kind), m_Boxed->Size, {}, nullptr, {} });
+	}
+	else
+	{
+		if (m_Type->IsBoxed())
+		{
+			nat_Throw(ReflectionException, "Boxed type {0} cannot be serialized."_nv, m_Type->GetName());
+		}
+
+		m_DefaultConstructor = m_Type->GetConstructor({});
+
+		const auto layout = m_Type->GetRecordLayout();
+		const auto count = layout->GetFieldCount();
+		for (size_t i = 0; i < count; ++i)
+		{
+			auto&& entry = layout->GetField(i);
+			const auto id = entry.Field->GetFieldId();
+			// 未指定id的字段不参与序列化
+			if (!id)
+			{
+				continue;
+			}
+
+			if (id > MaxFieldId)
+			{
+				nat_Throw(ReflectionException, "Id {0} of member field {1} of type {2} is out of range."_nv, id, entry.Name, m_Type->GetName());
+			}
+
+			Member member{ id, ValueKind::Object, WireType::LengthDelimited, 0, entry.Field, entry.Operations, {} };
+			if (entry.Pointer)
+			{
+				// 指向的类型可能未注册，此时仅能读写记录了类型名的对象
+				try
+				{
+					member.ReferencedType = Reflection::GetInstance().GetType(entry.Operations->ReferencedType());
+				}
+				catch (ReflectionException&)
+				{
+				}
+			}
+			else if (const auto scalar = rdetail_::FindFieldScalar(entry.Field->GetFieldTypeIndex()))
+			{
+				member.Kind = rdetail_::ToValueKind<ValueKind>(scalar->Kind);
+				member.Wire = GetWireType(member.Kind);
+				member.Size = scalar->Size;
+			}
+			else if (entry.Operations->TriviallyCopyable)
+			{
+				member.Kind = ValueKind::Bytes;
+				member.Size = entry.Operations->Size;
+			}
+			else
+			{
+				nat_Throw(ReflectionException, "Member field {0} of type {1} cannot be serialized."_nv, entry.Name, m_Type->GetName());
+			}
+
+			m_Members.emplace_back(std::move(member));
+		}
+	}
+
+	std::uint32_t maxId = 0;
+	for (auto const& member : m_Members)
+	{
+		maxId = std::max(maxId, member.Id);
+	}
+
+	m_MembersById.assign(static_cast<size_t>(maxId) + 1, nullptr);
+	for (auto const& member : m_Members)
+	{
+		auto& slot = m_MembersById[member.Id];
+		if (slot)
+		{
+			nat_Throw(ReflectionException, "Duplicate member field id {0} in type {1}."_nv, member.Id, m_Type->GetName());
+		}
+		slot = &member;
+	}
+}
+
+natRefPointer<TaggedPlan> TaggedPlan::Get(natRefPointer<IType> const& type)
+{
+	return rdetail_::GetCachedPlan<TaggedPlan>(type);
+}
+
+natRefPointer<IType> const& TaggedPlan::GetType() const noexcept
+{
+	return m_Type;
+}
+
+bool TaggedPlan::IsBoxed() const noexcept
+{
+	return m_Boxed != nullptr;
+}
+
+size_t TaggedPlan::GetMemberCount() const noexcept
+{
+	return m_Members.size();
+}
+
+TaggedPlan::Member const& TaggedPlan::GetMember(size_t n) const
+{
+	if (n >= m_Members.size())
+	{
+		nat_Throw(ReflectionException, "Member index {0} is out of range."_nv, n);
+	}
+
+	return m_Members[n];
+}
+
+TaggedPlan::Member const* TaggedPlan::FindMember(std::uint64_t id) const noexcept
+{
+	return id < m_MembersById.size() ? m_MembersById[static_cast<size_t>(id)] : nullptr;
+}
+
+void* TaggedPlan::GetAddress(Member const& member, Object* object) const
+{
+	if (m_Boxed)
+	{
+		return m_Boxed->Value(object);
+	}
+
+	const auto offset = member.Field->GetOffset();
+	return offset >= 0 ? reinterpret_cast<nByte*>(object) + offset : member.Field->GetAddress(object);
+}
+
+natRefPointer<Object> TaggedPlan::CreateInstance() const
+{
+	if (m_Boxed)
+	{
+		return m_Boxed->Create();
+	}
+
+	return rdetail_::CreateDefaultInstance(m_DefaultConstructor, m_Type);
+}
+
+TaggedWriter::TaggedWriter(natRefPointer<natStream> stream)
+	: m_Stream{ std::move(stream) }, m_Flushed{}
+{
+	if (!m_Stream)
+	{
+		nat_Throw(NullPointerException, "Stream is nullptr."_nv);
+	}
+
+	m_Buffer.reserve(BufferSize);
+}
+
+TaggedWriter::~TaggedWriter()
+{
+	try
+	{
+		Flush();
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaggedWriter::Write(natRefPointer<Object> const& object)
+{
+	WriteValue(object.Get(), nullptr, 0);
+	if (m_Buffer.size() >= BufferSize)
+	{
+		Flush();
+	}
+}
+
+void TaggedWriter::Flush()
+{
+	if (m_Buffer.empty())
+	{
+		return;
+	}
+
+	if (m_Stream->WriteBytes(m_Buffer.data(), m_Buffer.size()) != m_Buffer.size())
+	{
+		nat_Throw(ReflectionException, "Failed to write to stream."_nv);
+	}
+
+	m_Flushed += m_Buffer.size();
+	m_Buffer.clear();
+}
+
+nLen TaggedWriter::GetWrittenSize() const noexcept
+{
+	return m_Flushed + m_Buffer.size();
+}
+
+TaggedPlan const& TaggedWriter::GetPlan(natRefPointer<IType> const& type)
+{
+	auto& plan = m_Plans[type.Get()];
+	if (!plan)
+	{
+		plan = TaggedPlan::Get(type);
+	}
+
+	return *plan;
+}
+
+void TaggedWriter::WriteValue(Object* object, IType* declaredType, size_t depth)
+{
+	if (depth > MaxDepth)
+	{
+		nat_Throw(ReflectionException, "Object graph is too deep or contains a cycle."_nv);
+	}
+
+	if (!object)
+	{
+		WriteVarUInt(0);
+		return;
+	}
+
+	const auto type = object->GetType();
+	if (type.Get() == declaredType)
+	{
+		WriteVarUInt(DeclaredTypeReference);
+	}
+	else
+	{
+		const auto name = type->GetName();
+		WriteVarUInt(NamedTypeReference);
+		WriteVarUInt(name.size() * sizeof(nStrView::CharType));
+		WriteBytes(name.data(), name.size() * sizeof(nStrView::CharType));
+	}
+
+	auto const& plan = GetPlan(type);
+	for (size_t i = 0; i < plan.GetMemberCount(); ++i)
+	{
+		WriteMember(plan, plan.GetMember(i), object, depth);
+	}
+	WriteVarUInt(0);
+}
+
+void TaggedWriter::WriteMember(TaggedPlan const& plan, TaggedPlan::Member const& member, Object* object, size_t depth)
+{
+	const auto value = plan.GetAddress(member, object);
+	WriteVarUInt(static_cast<std::uint64_t>(member.Id) << 3 | static_cast<unsigned>(member.Wire));
+
+	switch (member.Kind)
+	{
+	case TaggedPlan::ValueKind::Bool:
+		WriteVarUInt(*static_cast<const bool*>(value) ? 1 : 0);
+		break;
+	case TaggedPlan::ValueKind::Signed:
+	{
+		// ZigZag编码，使绝对值较小的负数也编码为较短的变长整数
+		const auto n = rdetail_::LoadSigned(value, member.Size);
+		WriteVarUInt(static_cast<std::uint64_t>(n) << 1 ^ static_cast<std::uint64_t>(n >> 63));
+		break;
+	}
+	case TaggedPlan::ValueKind::Unsigned:
+		WriteVarUInt(rdetail_::LoadUnsigned(value, member.Size));
+		break;
+	case TaggedPlan::ValueKind::Float:
+	case TaggedPlan::ValueKind::Double:
+		WriteBytes(value, member.Size);
+		break;
+	case TaggedPlan::ValueKind::String:
+	{
+		auto const& str = *static_cast<const nString*>(value);
+		WriteVarUInt(str.size() * sizeof(nStrView::CharType));
+		WriteBytes(str.data(), str.size() * sizeof(nStrView::CharType));
+		break;
+	}
+	case TaggedPlan::ValueKind::Bytes:
+		WriteVarUInt(member.Size);
+		WriteBytes(value, member.Size);
+		break;
+	case TaggedPlan::ValueKind::Object:
+	{
+		// 长度在写入对象前未知，先预留固定字节数，之后以非最短形式的变长整数回填
+		const auto prefix = m_Buffer.size();
+		m_Buffer.resize(prefix + LengthPrefixSize);
+		WriteValue(member.Operations->ReferencedObject(value), member.ReferencedType.Get(), depth + 1);
+
+		auto length = static_cast<std::uint64_t>(m_Buffer.size() - prefix - LengthPrefixSize);
+		if (length >> (LengthPrefixSize * 7))
+		{
+			nat_Throw(ReflectionException, "Nested object is too large."_nv);
+		}
+
+		for (size_t i = 0; i < LengthPrefixSize; ++i)
+		{
+			m_Buffer[prefix + i] = static_cast<nByte>((length & 0x7F) | (i + 1 < LengthPrefixSize ? 0x80 : 0));
+			length >>= 7;
+		}
+		break;
+	}
+	}
+}
+
+void TaggedWriter::WriteVarUInt(std::uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		m_Buffer.push_back(static_cast<nByte>(value | 0x80));
+		value >>= 7;
+	}
+	m_Buffer.push_back(static_cast<nByte>(value));
+}
+
+void TaggedWriter::WriteBytes(const void* data, size_t size)
+{
+	const auto bytes = static_cast<const nByte*>(data);
+	m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+}
+
+TaggedReader::TaggedReader(natRefPointer<natStream> stream)
+	: m_Input{ std::move(stream), BufferSize }, m_Limit{ std::numeric_limits<std::uint64_t>::max() }
+{
+}
+
+TaggedReader::~TaggedReader()
+{
+	try
+	{
+		Close();
+	}
+	catch (...)
+	{
+	}
+}
+
+natRefPointer<Object> TaggedReader::Read()
+{
+	m_Limit = std::numeric_limits<std::uint64_t>::max();
+	return ReadValue(ReadTypeReference({}), 0);
+}
+
+natRefPointer<Object> TaggedReader::Read(natRefPointer<IType> const& type)
+{
+	if (!type)
+	{
+		nat_Throw(NullPointerException, "Type is nullptr."_nv);
+	}
+
+	m_Limit = std::numeric_limits<std::uint64_t>::max();
+	if (!SkipTypeReference())
+	{
+		return {};
+	}
+
+	return ReadValue(&GetPlan(type), 0);
+}
+
+void TaggedReader::ReadInto(natRefPointer<Object> const& object)
+{
+	if (!object)
+	{
+		nat_Throw(NullPointerException, "Object is nullptr."_nv);
+	}
+
+	m_Limit = std::numeric_limits<std::uint64_t>::max();
+	if (!SkipTypeReference())
+	{
+		nat_Throw(ReflectionException, "Stream contains a null object."_nv);
+	}
+
+	ReadMembers(GetPlan(object->GetType()), object, true, 0);
+}
+
+void TaggedReader::Close()
+{
+	m_Input.Close();
+}
+
+TaggedPlan const& TaggedReader::GetPlan(natRefPointer<IType> const& type)
+{
+	auto& plan = m_Plans[type.Get()];
+	if (!plan)
+	{
+		plan = TaggedPlan::Get(type);
+	}
+
+	return *plan;
+}
+
+TaggedPlan const* TaggedReader::ReadTypeReference(natRefPointer<IType> const& declaredType)
+{
+	switch (m_Input.ReadVarUInt())
+	{
+	case 0:
+		return nullptr;
+	case DeclaredTypeReference:
+		if (!declaredType)
+		{
+			nat_Throw(ReflectionException, "Referenced type of member is not registered."_nv);
+		}
+		return &GetPlan(declaredType);
+	case NamedTypeReference:
+	{
+		const auto name = m_Input.ReadString(ReadLength());
+		auto& plan = m_PlansByName[name];
+		if (!plan)
+		{
+			plan = &GetPlan(Reflection::GetInstance().GetType(name.GetView()));
+		}
+		return plan;
+	}
+	default:
+		nat_Throw(ReflectionException, "Invalid type reference."_nv);
+	}
+}
+
+bool TaggedReader::SkipTypeReference()
+{
+	switch (m_Input.ReadVarUInt())
+	{
+	case 0:
+		return false;
+	case NamedTypeReference:
+		m_Input.SkipBytes(ReadLength());
+		return true;
+	default:
+		nat_Throw(ReflectionException, "Invalid type reference."_nv);
+	}
+}
+
+natRefPointer<Object> TaggedReader::ReadValue(TaggedPlan const* plan, size_t depth)
+{
+	if (!plan)
+	{
+		return {};
+	}
+
+	if (depth > MaxDepth)
+	{
+		nat_Throw(ReflectionException, "Nesting is too deep."_nv);
+	}
+
+	auto object = plan->CreateInstance();
+	ReadMembers(*plan, object, false, depth);
+	DirtyTracking::Clear(object.Get());
+	return object;
+}
+
+void TaggedReader::ReadMembers(TaggedPlan const& plan, natRefPointer<Object> const& object, bool markDirty, size_t depth)
+{
+	while (const auto tag = m_Input.ReadVarUInt())
+	{
+		const auto wire = static_cast<TaggedPlan::WireType>(tag & 7);
+		const auto member = plan.FindMember(tag >> 3);
+		if (!member)
+		{
+			Skip(wire);
+			continue;
+		}
+
+		// Object成员由WriteFrom标记为已修改
+		if (ReadMember(plan, *member, wire, object, depth) && markDirty && member->Field && member->Kind != TaggedPlan::ValueKind::Object)
+		{
+			DirtyTracking::MarkField(object.Get(), member->Field.Get());
+		}
+	}
+}
+
+bool TaggedReader::ReadMember(TaggedPlan const& plan, TaggedPlan::Member const& member, TaggedPlan::WireType wire, natRefPointer<Object> const& object, size_t depth)
+{
+	if (wire != member.Wire)
+	{
+		Skip(wire);
+		return false;
+	}
+
+	const auto value = plan.GetAddress(member, object.Get());
+	const auto bits = member.Size * 8;
+	switch (member.Kind)
+	{
+	case TaggedPlan::ValueKind::Bool:
+	{
+		const auto n = m_Input.ReadVarUInt();
+		if (n > 1)
+		{
+			nat_Throw(ReflectionException, "Invalid boolean value {0}."_nv, n);
+		}
+		*static_cast<bool*>(value) = n != 0;
+		break;
+	}
+	case TaggedPlan::ValueKind::Signed:
+	{
+		const auto raw = m_Input.ReadVarUInt();
+		const auto n = static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1);
+		if (bits < 64 && (n < -(std::int64_t(1) << (bits - 1)) || n >= std::int64_t(1) << (bits - 1)))
+		{
+			nat_Throw(ReflectionException, "Integer {0} is out of range of member field with id {1}."_nv, n, member.Id);
+		}
+		rdetail_::StoreInteger(value, member.Size, static_cast<std::uint64_t>(n));
+		break;
+	}
+	case TaggedPlan::ValueKind::Unsigned:
+	{
+		const auto n = m_Input.ReadVarUInt();
+		if (bits < 64 && n >> bits)
+		{
+			nat_Throw(ReflectionException, "Integer {0} is out of range of member field with id {1}."_nv, n, member.Id);
+		}
+		rdetail_::StoreInteger(value, member.Size, n);
+		break;
+	}
+	case TaggedPlan::ValueKind::Float:
+	case TaggedPlan::ValueKind::Double:
+		m_Input.ReadBytes(value, member.Size);
+		break;
+	case TaggedPlan::ValueKind::String:
+		*static_cast<nString*>(value) = m_Input.ReadString(ReadLength());
+		break;
+	case TaggedPlan::ValueKind::Bytes:
+	{
+		const auto length = ReadLength();
+		if (length != member.Size)
+		{
+			m_Input.SkipBytes(length);
+			return false;
+		}
+		m_Input.ReadBytes(value, member.Size);
+		break;
+	}
+	case TaggedPlan::ValueKind::Object:
+	{
+		const auto length = ReadLength();
+		const auto end = m_Input.GetPosition() + length;
+		const auto limit = m_Limit;
+		m_Limit = end;
+		auto target = ReadValue(ReadTypeReference(member.ReferencedType), depth + 1);
+		if (m_Input.GetPosition() > end)
+		{
+			nat_Throw(ReflectionException, "Nested object exceeds its length."_nv);
+		}
+		// 跳过由更新版本的类型追加的数据
+		m_Input.SkipBytes(end - m_Input.GetPosition());
+		m_Limit = limit;
+		member.Field->WriteFrom(object, std::move(target));
+		break;
+	}
+	}
+
+	return true;
+}
+
+void TaggedReader::Skip(TaggedPlan::WireType wire)
+{
+	switch (wire)
+	{
+	case TaggedPlan::WireType::Varint:
+		m_Input.ReadVarUInt();
+		break;
+	case TaggedPlan::WireType::Fixed64:
+		m_Input.SkipBytes(8);
+		break;
+	case TaggedPlan::WireType::LengthDelimited:
+		m_Input.SkipBytes(ReadLength());
+		break;
+	case TaggedPlan::WireType::Fixed32:
+		m_Input.SkipBytes(4);
+		break;
+	default:
+		nat_Throw(ReflectionException, "Invalid wire type {0}."_nv, static_cast<unsigned>(wire));
+	}
+}
+
+std::uint64_t TaggedReader::ReadLength()
+{
+	const auto length = m_Input.ReadVarUInt();
+	const auto position = m_Input.GetPosition();
+	if (position > m_Limit || length > m_Limit - position)
+	{
+		nat_Throw(ReflectionException, "Length {0} exceeds the enclosing object."_nv, length);
+	}
+
+	return length;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include "SerializationDetail.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	类型的带标签序列化计划
+/// @note	仅指定了id的字段被序列化，各字段编码为标签(id << 3 | 线路类型)及其值
+///			bool及整数为变长整数，有符号整数经过ZigZag编码，float及double为定长的4字节及8字节
+///			nString、其他可平凡复制的字段及natRefPointer字段指向的对象以长度前缀编码
+///			读取时以id为下标直接查表获得成员，未知id或线路类型与当前定义不符的字段依其线路类型跳过
+////////////////////////////////////////////////////////////////////////////////
+class TaggedPlan final
+	: public natRefObjImpl<TaggedPlan, Interface>
+{
+public:
+	enum class WireType : unsigned
+	{
+		Varint = 0,
+		Fixed64 = 1,
+		LengthDelimited = 2,
+		Fixed32 = 5,
+	};
+
+	enum class ValueKind
+	{
+		Bool,
+		Signed,
+		Unsigned,
+		Float,
+		Double,
+		String,
+		Bytes,
+		Object,
+	};
+
+	struct Member
+	{
+		std::uint32_t Id;
+		ValueKind Kind;
+		WireType Wire;
+		/// @brief	整数、浮点数及Bytes的字节数
+		size_t Size;
+		/// @brief	装箱类型的计划中为nullptr
+		natRefPointer<IMemberField> Field;
+		ValueOperations const* Operations;
+		/// @brief	Object成员声明的指向类型，类型未注册时为nullptr
+		natRefPointer<IType> ReferencedType;
+	};
+
+	static constexpr std::uint32_t MaxFieldId = 65535;
+
+	/// @brief	若字段id重复、超出范围或字段无法编码则抛出ReflectionException
+	/// @note	装箱的基本类型及RefString视为仅有一个id为1的成员
+	explicit TaggedPlan(natRefPointer<IType> type);
+
+	/// @brief	获得类型的计划，首次获得时生成
+	static natRefPointer<TaggedPlan> Get(natRefPointer<IType> const& type);
+
+	natRefPointer<IType> const& GetType() const noexcept;
+	bool IsBoxed() const noexcept;
+	size_t GetMemberCount() const noexcept;
+	Member const& GetMember(size_t n) const;
+	/// @brief	以id获得成员，不存在时返回nullptr
+	Member const* FindMember(std::uint64_t id) const noexcept;
+
+	/// @brief	获得成员在对象中的地址
+	void* GetAddress(Member const& member, Object* object) const;
+	/// @brief	以无参构造函数创建用于解码的对象
+	/// @note	类型没有注册无参构造函数时抛出ReflectionException
+	natRefPointer<Object> CreateInstance() const;
+
+private:
+	natRefPointer<IType> m_Type;
+	rdetail_::ScalarInfo const* m_Boxed;
+	std::vector<Member> m_Members;
+	std::vector<Member const*> m_MembersById;
+	natRefPointer<IMethod> m_DefaultConstructor;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	以带标签的格式将对象写入流
+/// @note	每个根对象记录其类型名，natRefPointer字段指向的对象仅在实际类型与声明的类型不同时记录类型名
+///			每个值以结束标签0结尾，嵌套的对象另有长度前缀，因此读取方可整体跳过
+///			不处理共享及循环引用，循环引用将因超过MaxDepth而抛出异常
+////////////////////////////////////////////////////////////////////////////////
+class TaggedWriter final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = 256;
+
+	explicit TaggedWriter(natRefPointer<natStream> stream);
+	~TaggedWriter();
+
+	TaggedWriter(TaggedWriter const&) = delete;
+	TaggedWriter& operator=(TaggedWriter const&) = delete;
+
+	/// @brief	写入对象，object可为nullptr
+	void Write(natRefPointer<Object> const& object);
+	void Flush();
+
+	/// @brief	已写入的字节数，包括尚在缓冲区中的部分
+	nLen GetWrittenSize() const noexcept;
+
+private:
+	TaggedPlan const& GetPlan(natRefPointer<IType> const& type);
+	void WriteValue(Object* object, IType* declaredType, size_t depth);
+	void WriteMember(TaggedPlan const& plan, TaggedPlan::Member const& member, Object* object, size_t depth);
+	void WriteVarUInt(std::uint64_t value);
+	void WriteBytes(const void* data, size_t size);
+
+	natRefPointer<natStream> m_Stream;
+	std::vector<nByte> m_Buffer;
+	nLen m_Flushed;
+	std::unordered_map<IType*, natRefPointer<TaggedPlan>> m_Plans;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// @brief	从流中解码由TaggedWriter写入的对象
+/// @note	会预读流中的数据，Close或析构时若流支持定位则将位置退回到最后读取的对象之后
+///			读取到不完整或不合法的数据、或整数超出字段的范围时抛出ReflectionException
+////////////////////////////////////////////////////////////////////////////////
+class TaggedReader final
+{
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxDepth = TaggedWriter::MaxDepth;
+
+	explicit TaggedReader(natRefPointer<natStream> stream);
+	~TaggedReader();
+
+	TaggedReader(TaggedReader const&) = delete;
+	TaggedReader& operator=(TaggedReader const&) = delete;
+
+	/// @brief	读取对象，可能返回nullptr
+	natRefPointer<Object> Read();
+	/// @brief	以type解码下一个对象，忽略流中记录的类型名
+	/// @note	用于类型更名或以其他版本的类型读取
+	natRefPointer<Object> Read(natRefPointer<IType> const& type);
+	/// @brief	将下一个对象读入已存在的对象，忽略流中记录的类型名
+	/// @note	流中出现的字段被标记为已修改
+	void ReadInto(natRefPointer<Object> const& object);
+	/// @brief	退回预读的数据
+	void Close();
+
+private:
+	TaggedPlan const& GetPlan(natRefPointer<IType> const& type);
+	/// @brief	读取类型引用，为空引用时返回nullptr
+	TaggedPlan const* ReadTypeReference(natRefPointer<IType> const& declaredType);
+	/// @brief	跳过根对象的类型引用，为空引用时返回false
+	bool SkipTypeReference();
+	natRefPointer<Object> ReadValue(TaggedPlan const* plan, size_t depth);
+	void ReadMembers(TaggedPlan const& plan, natRefPointer<Object> const& object, bool markDirty, size_t depth);
+	/// @brief	读取成员的值
+	/// @return	是否写入了字段，线路类型或长度与当前定义不符时跳过该值并返回false
+	bool ReadMember(TaggedPlan const& plan, TaggedPlan::Member const& member, TaggedPlan::WireType wire, natRefPointer<Object> const& object, size_t depth);
+	void Skip(TaggedPlan::WireType wire);
+	/// @brief	读取长度前缀并检查其不超出所在的嵌套对象
+	std::uint64_t ReadLength();
+
+	rdetail_::StreamInput m_Input;
+	/// @brief	当前嵌套对象的结束位置
+	std::uint64_t m_Limit;
+	std::unordered_map<IType*, natRefPointer<TaggedPlan>> m_Plans;
+	std::unordered_map<nString, TaggedPlan const*> m_PlansByName;
+};
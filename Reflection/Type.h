@@ -1,6 +1,9 @@
 #pragma once
 #include "Interface.h"
 #include "Attribute.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <natMisc.h>
 
@@ -9,6 +12,16 @@
 #define CONSTRUCTOR_NAME Constructor
 #define CONSTRUCTOR_NAME_STR STR(Constructor)
 
+namespace rdetail_
+{
+	// 注册成员字段、成员方法或基类后递增，各类型缓存的布局及虚表在版本变化后重建，从而一并反映基类的变化
+	inline std::atomic<size_t>& MetadataVersion() noexcept
+	{
+		static std::atomic<size_t> s_Version{ 1 };
+		return s_Version;
+	}
+}
+
 template <typename T>
 class Type
 	: public natRefObjImpl<Type<T>, IType>
@@ -38,14 +51,39 @@ public:
 
 	void RegisterBaseClasses(std::initializer_list<natRefPointer<IType>> baseClasses) override;
 
+	void RegisterConstructor(natRefPointer<IMethod> constructor, ConstructorCategory category) override
+	{
+		switch (category)
+		{
+		case ConstructorCategory::Copy:
+			m_CopyConstructor = constructor;
+			break;
+		case ConstructorCategory::Move:
+			m_MoveConstructor = constructor;
+			break;
+		default:
+			break;
+		}
+
+		m_Constructors.emplace_back(CONSTRUCTOR_NAME_STR, std::move(constructor));
+	}
+
 	void RegisterNonMemberMethod(nStrView name, natRefPointer<IMethod> method) override
 	{
+		// 构造函数仅存放于构造函数表中
+		if (name == CONSTRUCTOR_NAME_STR)
+		{
+			m_Constructors.emplace_back(name, std::move(method));
+			return;
+		}
+
 		m_NonMemberMethodMap.emplace(name, method);
 	}
 
 	void RegisterMemberMethod(nStrView name, natRefPointer<IMemberMethod> method) override
 	{
 		m_MemberMethodMap.emplace(name, method);
+		rdetail_::MetadataVersion().fetch_add(1, std::memory_order_acq_rel);
 	}
 
 	void RegisterNonMemberField(nStrView name, natRefPointer<IField> field) override
@@ -55,7 +93,11 @@ public:
 
 	void RegisterMemberField(nStrView name, natRefPointer<IMemberField> field) override
 	{
-		m_MemberFieldMap.emplace(name, field);
+		if (m_MemberFieldMap.emplace(name, field).second)
+		{
+			m_MemberFieldList.emplace_back(name, std::move(field));
+			rdetail_::MetadataVersion().fetch_add(1, std::memory_order_acq_rel);
+		}
 	}
 
 	nStrView GetName() const noexcept override
@@ -64,12 +106,81 @@ public:
 	}
 
 	bool IsBoxed() const noexcept override;
+	bool IsParsable() const noexcept override;
+	natRefPointer<Object> Parse(nStrView text) override;
 
 	natRefPointer<Object> Construct(ArgumentPack const& args) override
 	{
-		return InvokeNonMember(CONSTRUCTOR_NAME_STR, args);
+		// 参数类型与上次选择的构造函数的参数类型完全相同时不再逐一尝试
+		const auto handle = m_PublishedConstructorHandle.load(std::memory_order_acquire);
+		if (handle && handle->Matches(args))
+		{
+			return handle->Constructor->Invoke(args);
+		}
+
+		// 未注册任何构造函数时由基类尝试构造
+		if (m_Constructors.empty())
+		{
+			for (auto&& item : m_BaseClasses)
+			{
+				try
+				{
+					return item->Construct(args);
+				}
+				catch (...)
+				{
+				}
+			}
+			nat_Throw(ReflectionException, "No such nonmember method named {0}."_nv, CONSTRUCTOR_NAME_STR);
+		}
+
+		return FindConstructor(args)->Invoke(args);
 	}
 
+	natRefPointer<IMethod> GetConstructor(std::initializer_list<natRefPointer<IType>> const& argTypes) override
+	{
+		for (auto&& item : m_Constructors)
+		{
+			if (item.second->GetArgumentCount() == size(argTypes))
+			{
+				for (size_t i = 0; i < size(argTypes); ++i)
+				{
+					if (!item.second->GetArgumentType(i)->Equal(std::next(begin(argTypes), i)->Get()))
+					{
+						goto NotMatch;
+					}
+				}
+				return item.second;
+			}
+		NotMatch:
+			continue;
+		}
+
+		return {};
+	}
+
+	natRefPointer<Object> CopyConstruct(natRefPointer<Object> const& object) override
+	{
+		if (!m_CopyConstructor)
+		{
+			return DefaultCopyConstruct(object, std::integral_constant<bool, std::is_base_of<Object, T>::value && std::is_copy_constructible<T>::value>{});
+		}
+
+		return ConstructFrom(m_CopyConstructor, object);
+	}
+
+	natRefPointer<Object> MoveConstruct(natRefPointer<Object> const& object) override
+	{
+		if (!m_MoveConstructor)
+		{
+			nat_Throw(ReflectionException, "Type {0} has no registered move constructor."_nv, GetName());
+		}
+
+		return ConstructFrom(m_MoveConstructor, object);
+	}
+
+	natRefPointer<ObjectBatch> ConstructBatch(size_t count, ArgumentPack const& args) override;
+
 	size_t GetBaseClassesCount() const noexcept override
 	{
 		return m_BaseClasses.size();
@@ -87,6 +198,11 @@ public:
 
 	natRefPointer<Object> InvokeNonMember(nStrView name, ArgumentPack const& args) override
 	{
+		if (name == CONSTRUCTOR_NAME_STR)
+		{
+			return Construct(args);
+		}
+
 		auto range = m_NonMemberMethodMap.equal_range(name);
 		if (range.first == range.second)
 		{
@@ -146,6 +262,11 @@ public:
 
 	natRefPointer<IMethod> GetNonMemberMethod(nStrView name, std::initializer_list<natRefPointer<IType>> const& argTypes) override
 	{
+		if (name == CONSTRUCTOR_NAME_STR && !m_Constructors.empty())
+		{
+			return GetConstructor(argTypes);
+		}
+
 		const auto range = m_NonMemberMethodMap.equal_range(name);
 		if (range.first == range.second)
 		{
@@ -214,6 +335,124 @@ public:
 		return {};
 	}
 
+	// 基类的槽位在前且保持原有顺序，本类的虚方法覆盖签名相同的槽位，否则追加新槽位
+	// 首次调用可能同时发生于多个线程，因此在锁内构建，发布后不再修改且保留至类型销毁，可无锁读取
+	VirtualTable const& GetVirtualTable() override
+	{
+		const auto version = rdetail_::MetadataVersion().load(std::memory_order_acquire);
+		const auto published = m_PublishedVirtualTable.load(std::memory_order_acquire);
+		if (published && m_VirtualTableVersion.load(std::memory_order_acquire) == version)
+		{
+			return *published;
+		}
+
+		std::lock_guard<std::mutex> lock{ m_VirtualTableMutex };
+		if (!m_VirtualTables.empty() && m_VirtualTableVersion.load(std::memory_order_relaxed) == version)
+		{
+			return *m_VirtualTables.back();
+		}
+
+		auto table = std::make_unique<VirtualTable>();
+		table->Types.emplace_back(this);
+
+		const auto findSlot = [&table](nStrView name, IMemberMethod* method)
+		{
+			for (size_t slot = 0; slot < table->Methods.size(); ++slot)
+			{
+				if (table->Names[slot] == name && IsSameSignature(table->Methods[slot], method))
+				{
+					return slot;
+				}
+			}
+			return table->Methods.size();
+		};
+
+		for (auto&& base : m_BaseClasses)
+		{
+			auto const& baseTable = base->GetVirtualTable();
+			// 仅第一个基类的槽位布局被保留
+			if (&base == &m_BaseClasses.front())
+			{
+				table->Types.insert(table->Types.end(), baseTable.Types.begin(), baseTable.Types.end());
+			}
+
+			for (size_t i = 0; i < baseTable.Methods.size(); ++i)
+			{
+				const auto name = baseTable.Names[i].GetView();
+				if (findSlot(name, baseTable.Methods[i]) == table->Methods.size())
+				{
+					table->Names.emplace_back(name);
+					table->Methods.emplace_back(baseTable.Methods[i]);
+				}
+			}
+		}
+
+		for (auto&& item : m_MemberMethodMap)
+		{
+			if (!item.second->IsVirtual())
+			{
+				continue;
+			}
+
+			const auto slot = findSlot(item.first.GetView(), item.second.Get());
+			if (slot == table->Methods.size())
+			{
+				table->Names.emplace_back(item.first);
+				table->Methods.emplace_back(item.second.Get());
+			}
+			else
+			{
+				table->Methods[slot] = item.second.Get();
+			}
+		}
+
+		m_VirtualTables.emplace_back(std::move(table));
+		m_VirtualTableVersion.store(version, std::memory_order_release);
+		m_PublishedVirtualTable.store(m_VirtualTables.back().get(), std::memory_order_release);
+		return *m_VirtualTables.back();
+	}
+
+	size_t GetVirtualSlot(nStrView name, std::initializer_list<natRefPointer<IType>> const& argTypes) override
+	{
+		auto const& table = GetVirtualTable();
+		for (size_t slot = 0; slot < table.Methods.size(); ++slot)
+		{
+			const auto method = table.Methods[slot];
+			if (table.Names[slot] == name && method->GetArgumentCount() == size(argTypes))
+			{
+				for (size_t i = 0; i < size(argTypes); ++i)
+				{
+					if (!method->GetArgumentType(i)->Equal(std::next(begin(argTypes), i)->Get()))
+					{
+						goto NotMatch;
+					}
+				}
+				return slot;
+			}
+		NotMatch:
+			continue;
+		}
+
+		nat_Throw(ReflectionException, "No such virtual member method named {0}."_nv, name);
+	}
+
+	size_t GetVirtualMethodCount() override
+	{
+		return GetVirtualTable().Methods.size();
+	}
+
+	nStrView GetVirtualMethodName(size_t slot) override
+	{
+		return GetVirtualTable().Names.at(slot).GetView();
+	}
+
+	natRefPointer<IMemberMethod> GetVirtualMethod(size_t slot) override
+	{
+		return natRefPointer<IMemberMethod>{ GetVirtualTable().Methods.at(slot) };
+	}
+
+	natRefPointer<Object> InvokeVirtual(natRefPointer<Object> object, size_t slot, ArgumentPack const& args) override;
+
 	bool IsNonMemberFieldPointer(nStrView name) override
 	{
 		auto iter = m_NonMemberFieldMap.find(name);
@@ -302,8 +541,42 @@ public:
 		return iter->second;
 	}
 
+	size_t GetMemberFieldCount() const noexcept override
+	{
+		return m_MemberFieldList.size();
+	}
+
+	nStrView GetMemberFieldName(size_t n) const override
+	{
+		if (n >= m_MemberFieldList.size())
+		{
+			nat_Throw(ReflectionException, "Member field index {0} is out of range."_nv, n);
+		}
+
+		return m_MemberFieldList[n].first.GetView();
+	}
+
+	natRefPointer<IMemberField> GetMemberFieldByIndex(size_t n) const override
+	{
+		if (n >= m_MemberFieldList.size())
+		{
+			nat_Throw(ReflectionException, "Member field index {0} is out of range."_nv, n);
+		}
+
+		return m_MemberFieldList[n].second;
+	}
+
+	natRefPointer<RecordLayout> GetRecordLayout() override;
+
 	bool EnumNonMember(bool recurse, Delegate<bool(nStrView, bool, natRefPointer<IType>)> enumFunc) const override
 	{
+		for (auto&& item : m_Constructors)
+		{
+			if (enumFunc(item.first.GetView(), true, {}))
+			{
+				return true;
+			}
+		}
 		for (auto&& item : m_NonMemberMethodMap)
 		{
 			if (enumFunc(item.first.GetView(), true, {}))
@@ -331,7 +604,7 @@ public:
 
 	Linq<const std::pair<const nString, natRefPointer<IMethod>>> GetNonMemberMethods() const noexcept override
 	{
-		Linq<const std::pair<const nString, natRefPointer<IMethod>>> ret = from(m_NonMemberMethodMap);
+		Linq<const std::pair<const nString, natRefPointer<IMethod>>> ret = from(m_Constructors).concat(from(m_NonMemberMethodMap));
 		for (auto&& item : m_BaseClasses)
 		{
 			ret = ret.concat(item->GetNonMemberMethods());
@@ -451,10 +724,65 @@ public:
 	}
 
 private:
+	////////////////////////////////////////////////////////////////////////////////
+	/// @brief	由参数类型选出的构造函数
+	/// @note	构造函数的选择仅取决于各参数的类型，因此参数类型完全相同时可直接复用
+	////////////////////////////////////////////////////////////////////////////////
+	struct ConstructorHandle
+	{
+		std::vector<IType*> ArgumentTypes;
+		IMethod* Constructor;
+
+		bool Matches(ArgumentPack const& args) const;
+	};
+
+	// 查找或生成与args的参数类型对应的构造函数并发布，找不到时抛出异常
+	IMethod* FindConstructor(ArgumentPack const& args);
+	natRefPointer<Object> ConstructFrom(natRefPointer<IMethod> const& constructor, natRefPointer<Object> const& object);
+	// 未注册复制构造函数时直接使用T的复制构造函数
+	natRefPointer<Object> DefaultCopyConstruct(natRefPointer<Object> const& object, std::true_type);
+	natRefPointer<Object> DefaultCopyConstruct(natRefPointer<Object> const& object, std::false_type);
+
+	static bool IsSameSignature(IMemberMethod* a, IMemberMethod* b)
+	{
+		if (a->GetArgumentCount() != b->GetArgumentCount())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < a->GetArgumentCount(); ++i)
+		{
+			if (!a->GetArgumentType(i)->Equal(b->GetArgumentType(i).Get()))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	std::vector<natRefPointer<IAttribute>> m_Attributes;
 	std::vector<natRefPointer<IType>> m_BaseClasses;
 	std::unordered_multimap<nString, natRefPointer<IMethod>> m_NonMemberMethodMap;
 	std::unordered_multimap<nString, natRefPointer<IMemberMethod>> m_MemberMethodMap;
 	std::unordered_map<nString, natRefPointer<IField>> m_NonMemberFieldMap;
 	std::unordered_map<nString, natRefPointer<IMemberField>> m_MemberFieldMap;
+	std::vector<std::pair<nString, natRefPointer<IMemberField>>> m_MemberFieldList;
+	// m_RecordLayouts持有所有生成过的布局直至类型销毁，因此m_PublishedRecordLayout可无锁读取并增加引用计数
+	std::mutex m_RecordLayoutMutex;
+	std::vector<natRefPointer<RecordLayout>> m_RecordLayouts;
+	std::atomic<RecordLayout*> m_PublishedRecordLayout{ nullptr };
+	std::atomic<size_t> m_RecordLayoutVersion{ 0 };
+	// 构造函数以CONSTRUCTOR_NAME_STR为名存放，以便与其他非成员方法一同枚举
+	std::vector<std::pair<const nString, natRefPointer<IMethod>>> m_Constructors;
+	// m_ConstructorHandles持有所有生成过的句柄直至类型销毁，因此m_PublishedConstructorHandle可无锁读取
+	std::mutex m_ConstructorHandleMutex;
+	std::vector<std::unique_ptr<ConstructorHandle>> m_ConstructorHandles;
+	std::atomic<ConstructorHandle const*> m_PublishedConstructorHandle{ nullptr };
+	natRefPointer<IMethod> m_CopyConstructor;
+	natRefPointer<IMethod> m_MoveConstructor;
+	std::mutex m_VirtualTableMutex;
+	std::vector<std::unique_ptr<VirtualTable>> m_VirtualTables;
+	std::atomic<VirtualTable const*> m_PublishedVirtualTable{ nullptr };
+	std::atomic<size_t> m_VirtualTableVersion{ 0 };
 };
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <iostream>
 #include <chrono>
+#include <thread>
 #include <Reflection.h>
 #include <natStream.h>
 
@@ -41,6 +43,7 @@ DECLARE_REFLECTABLE_CLASS(Foo)
 	DECLARE_CONST_MEMBER_METHOD(public, Foo, , GetTest, 1, int, int const&);
 	DECLARE_VIRTUAL_MEMBER_METHOD(public, Foo, , Test, , int);
 	DECLARE_MEMBER_METHOD(public, Foo, , Test1, , void);
+	DECLARE_MEMBER_METHOD(public, Foo, , MoveTest, , int&&);
 
 	DECLARE_MEMBER_FIELD(private, Foo, int, m_Test);
 };
@@ -75,6 +78,11 @@ DEFINE_MEMBER_METHOD(public, Foo, , Test1, , void)()
 	std::cout << m_Test << std::endl;
 }
 
+DEFINE_MEMBER_METHOD(public, Foo, , MoveTest, , int&&)()
+{
+	return std::move(m_Test);
+}
+
 DEFINE_MEMBER_FIELD(private, Foo, int, m_Test);
 
 REGISTER_BOXED_REFOBJECT(natStream);
@@ -108,13 +116,287 @@ DEFINE_MEMBER_METHOD(public, Bar, , BoxedTest, , natRefPointer<Object>, natStrea
 	return Box();
 }
 
+DECLARE_REFLECTABLE_CLASS(Counter)
+{
+	GENERATE_METADATA(Counter, WITH())
+
+	DECLARE_CONSTRUCTOR(public, Counter, , Default, );
+	DECLARE_CONSTRUCTOR(public, Counter, explicit, , int);
+	DECLARE_CONST_MEMBER_METHOD(public, Counter, , Get, , int);
+
+	DECLARE_MEMBER_FIELD(public, Counter, int, m_Value);
+};
+
+GENERATE_METADATA_DEFINITION(Counter, WITH());
+
+DEFINE_CONSTRUCTOR(public, Counter, , Default, )()
+	: m_Value{}
+{
+}
+
+DEFINE_CONSTRUCTOR(public, Counter, explicit, , int)(int value)
+	: m_Value{ value }
+{
+}
+
+DEFINE_CONST_MEMBER_METHOD(public, Counter, , Get, , int)() const
+{
+	return m_Value;
+}
+
+DEFINE_MEMBER_FIELD(public, Counter, int, m_Value);
+
+DECLARE_REFLECTABLE_CLASS(BiasedCounter)
+{
+	GENERATE_METADATA(BiasedCounter, WITH())
+	USE_BIASED_REFCOUNT
+
+	DECLARE_CONSTRUCTOR(public, BiasedCounter, explicit, , int);
+	DECLARE_CONST_MEMBER_METHOD(public, BiasedCounter, , Get, , int);
+
+	DECLARE_MEMBER_FIELD(public, BiasedCounter, int, m_Value);
+};
+
+GENERATE_METADATA_DEFINITION(BiasedCounter, WITH());
+
+DEFINE_CONSTRUCTOR(public, BiasedCounter, explicit, , int)(int value)
+	: m_Value{ value }
+{
+}
+
+DEFINE_CONST_MEMBER_METHOD(public, BiasedCounter, , Get, , int)() const
+{
+	return m_Value;
+}
+
+DEFINE_MEMBER_FIELD(public, BiasedCounter, int, m_Value);
+
+DECLARE_REFLECTABLE_CLASS(TrackedPoint)
+{
+	GENERATE_METADATA(TrackedPoint, WITH())
+	USE_DIRTY_TRACKING
+
+	DECLARE_CONSTRUCTOR(public, TrackedPoint, , , int, int);
+
+	void SetX(int x)
+	{
+		m_X = x;
+		MARK_FIELD_DIRTY(TrackedPoint, m_X);
+	}
+
+	DECLARE_MEMBER_FIELD(public, TrackedPoint, int, m_X);
+	DECLARE_MEMBER_FIELD(public, TrackedPoint, int, m_Y);
+};
+
+GENERATE_METADATA_DEFINITION(TrackedPoint, WITH());
+
+DEFINE_CONSTRUCTOR(public, TrackedPoint, , , int, int)(int x, int y)
+	: m_X{ x }, m_Y{ y }
+{
+}
+
+DEFINE_MEMBER_FIELD(public, TrackedPoint, int, m_X);
+DEFINE_MEMBER_FIELD(public, TrackedPoint, int, m_Y);
+
+DECLARE_REFLECTABLE_CLASS(Sample)
+{
+	GENERATE_METADATA(Sample, WITH())
+
+	DECLARE_CONSTRUCTOR(public, Sample, , Default, );
+	DECLARE_CONSTRUCTOR(public, Sample, , , int, double);
+	DECLARE_DEFAULT_COPYCONSTRUCTOR(public, Sample);
+
+	DECLARE_MEMBER_FIELD(public, Sample, int, m_Id);
+	DECLARE_MEMBER_FIELD(public, Sample, double, m_Weight);
+	DECLARE_MEMBER_FIELD(public, Sample, nString, m_Name);
+	DECLARE_MEMBER_POINTER_FIELD(public, Sample, Counter, m_Counter);
+};
+
+GENERATE_METADATA_DEFINITION(Sample, WITH());
+
+DEFINE_CONSTRUCTOR(public, Sample, , Default, )()
+	: m_Id{}, m_Weight{}
+{
+}
+
+DEFINE_CONSTRUCTOR(public, Sample, , , int, double)(int id, double weight)
+	: m_Id{ id }, m_Weight{ weight }, m_Name{ "Sample"_nv }, m_Counter{ make_ref<Counter>(id) }
+{
+}
+
+DEFINE_DEFAULT_COPYCONSTRUCTOR(public, Sample);
+
+DEFINE_MEMBER_FIELD(public, Sample, int, m_Id);
+DEFINE_MEMBER_FIELD(public, Sample, double, m_Weight);
+DEFINE_MEMBER_FIELD(public, Sample, nString, m_Name);
+DEFINE_MEMBER_POINTER_FIELD(public, Sample, Counter, m_Counter);
+
+DECLARE_REFLECTABLE_CLASS(Node)
+{
+	GENERATE_METADATA(Node, WITH())
+
+	DECLARE_CONSTRUCTOR(public, Node, explicit, , int);
+
+	DECLARE_MEMBER_FIELD(public, Node, int, m_Value);
+	DECLARE_MEMBER_POINTER_FIELD(public, Node, Node, m_Next);
+};
+
+GENERATE_METADATA_DEFINITION(Node, WITH());
+
+DEFINE_CONSTRUCTOR(public, Node, explicit, , int)(int value)
+	: m_Value{ value }
+{
+}
+
+DEFINE_MEMBER_FIELD(public, Node, int, m_Value);
+DEFINE_MEMBER_POINTER_FIELD(public, Node, Node, m_Next);
+
+// 同一设置的两个版本，以字段id而非名称或顺序对应
+DECLARE_REFLECTABLE_CLASS(SettingsV1)
+{
+	GENERATE_METADATA(SettingsV1, WITH())
+
+	DECLARE_CONSTRUCTOR(public, SettingsV1, , Default, );
+
+	DECLARE_MEMBER_FIELD(public, SettingsV1, nString, m_Name);
+	DECLARE_MEMBER_FIELD(public, SettingsV1, int, m_Width);
+	DECLARE_MEMBER_FIELD(public, SettingsV1, int, m_Height);
+	// 未指定id，不被序列化
+	DECLARE_MEMBER_FIELD(public, SettingsV1, nString, m_Comment);
+};
+
+GENERATE_METADATA_DEFINITION(SettingsV1, WITH());
+
+DEFINE_CONSTRUCTOR(public, SettingsV1, , Default, )()
+	: m_Width{ 640 }, m_Height{ 480 }
+{
+}
+
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV1, nString, m_Name, 1);
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV1, int, m_Width, 2);
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV1, int, m_Height, 3);
+DEFINE_MEMBER_FIELD(public, SettingsV1, nString, m_Comment);
+
+DECLARE_REFLECTABLE_CLASS(SettingsV2)
+{
+	GENERATE_METADATA(SettingsV2, WITH())
+
+	DECLARE_CONSTRUCTOR(public, SettingsV2, , Default, );
+
+	DECLARE_MEMBER_FIELD(public, SettingsV2, std::int64_t, m_Height);
+	DECLARE_MEMBER_FIELD(public, SettingsV2, double, m_Scale);
+	DECLARE_MEMBER_FIELD(public, SettingsV2, nString, m_Name);
+	DECLARE_MEMBER_POINTER_FIELD(public, SettingsV2, Counter, m_Counter);
+	DECLARE_MEMBER_FIELD(public, SettingsV2, int, m_Width);
+};
+
+GENERATE_METADATA_DEFINITION(SettingsV2, WITH());
+
+DEFINE_CONSTRUCTOR(public, SettingsV2, , Default, )()
+	: m_Height{ 480 }, m_Scale{ 1.0 }, m_Width{ 640 }
+{
+}
+
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV2, std::int64_t, m_Height, 3);
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV2, double, m_Scale, 4);
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV2, nString, m_Name, 1);
+DEFINE_MEMBER_POINTER_FIELD_WITH_ID(public, SettingsV2, Counter, m_Counter, 5);
+DEFINE_MEMBER_FIELD_WITH_ID(public, SettingsV2, int, m_Width, 2);
+
+DECLARE_REFLECTABLE_CLASS(TextStats)
+{
+	GENERATE_METADATA(TextStats, WITH())
+
+	DECLARE_NONMEMBER_METHOD(public, TextStats, FirstLineLength, , size_t, nStrView);
+	DECLARE_NONMEMBER_METHOD(public, TextStats, Length, , size_t, nString const&);
+};
+
+GENERATE_METADATA_DEFINITION(TextStats, WITH());
+
+DEFINE_NONMEMBER_METHOD(public, TextStats, FirstLineLength, , size_t, nStrView)(nStrView text)
+{
+	return static_cast<size_t>(std::find(text.begin(), text.end(), '\n') - text.begin());
+}
+
+DEFINE_NONMEMBER_METHOD(public, TextStats, Length, , size_t, nString const&)(nString const& text)
+{
+	return text.size();
+}
+
+// 与Memberwise比较的手写实现
+bool HandWrittenEquals(Sample const& a, Sample const& b)
+{
+	return a.m_Id == b.m_Id && a.m_Weight == b.m_Weight && a.m_Name == b.m_Name &&
+		(a.m_Counter == b.m_Counter || (a.m_Counter && b.m_Counter && a.m_Counter->m_Value == b.m_Counter->m_Value));
+}
+
+size_t HandWrittenHash(Sample const& sample)
+{
+	auto seed = std::hash<int>{}(sample.m_Id);
+	seed ^= std::hash<double>{}(sample.m_Weight) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	seed ^= std::hash<nString>{}(sample.m_Name) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+	return sample.m_Counter ? seed ^ (std::hash<int>{}(sample.m_Counter->m_Value) + 0x9e3779b9 + (seed << 6) + (seed >> 2)) : seed;
+}
+
+natRefPointer<Sample> HandWrittenClone(Sample const& sample)
+{
+	auto result = make_ref<Sample>(sample);
+	if (sample.m_Counter)
+	{
+		result->m_Counter = make_ref<Counter>(*sample.m_Counter);
+	}
+	return result;
+}
+
+template <typename Func>
+long long Benchmark(size_t times, Func&& func)
+{
+	const auto begin = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < times; ++i)
+	{
+		func();
+	}
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+#ifdef REFLECTION_TEST_BENCHMARKS
+// 构造对象的各种途径的耗时，定义REFLECTION_TEST_BENCHMARKS时运行
+void ConstructionBenchmark(natRefPointer<IType> const& type)
+{
+	auto FooConstructor = type->GetConstructor({ typeof(int) })->GetThunk();
+	int constructorArg = 1;
+	void* constructorArgs[] = { &constructorArg };
+	std::wcout << "InvokeNonMember(Constructor) : " << Benchmark(1000000, [&] { type->InvokeNonMember("Constructor"_nv, { 1 }); }) << " ms" << std::endl;
+	std::wcout << "Construct : " << Benchmark(1000000, [&] { type->Construct({ 1 }); }) << " ms" << std::endl;
+	std::wcout << "Constructor thunk : " << Benchmark(1000000, [&] { FooConstructor.Invoke<natRefPointer<Object>>(nullptr, constructorArgs); }) << " ms" << std::endl;
+	std::wcout << "Construct x100000 : " << Benchmark(10, [&] { std::vector<natRefPointer<Object>> objects; for (size_t i = 0; i < 100000; ++i) objects.emplace_back(type->Construct({ 1 })); }) << " ms" << std::endl;
+	std::wcout << "ConstructBatch(100000) : " << Benchmark(10, [&] { type->ConstructBatch(100000, { 1 }); }) << " ms" << std::endl;
+}
+#endif
+
 struct haha
 {
 	int a;
+
+	int Add(int value)
+	{
+		return a += value;
+	}
 };
 
-REGISTER_BOXED_OBJECT(haha);
-REGISTER_BOXED_OBJECT_DEF(haha);
+REGISTER_BOXED_VALUE(haha);
+REGISTER_BOXED_VALUE_DEF(haha);
+
+namespace Geometry
+{
+	struct Point
+	{
+		int X, Y;
+	};
+}
+
+REGISTER_BOXED_VALUE(Geometry::Point);
+REGISTER_BOXED_VALUE_DEF(Geometry::Point);
 
 int main()
 {
@@ -138,9 +420,30 @@ int main()
 		decltype(auto) UnboxedFoo = pFoo->Unbox<Foo>();
 		std::wcout << UnboxedFoo.GetTest() << std::endl;
 
+		int thunkArg = 1, thunkResult;
+		void* thunkArgs[] = { &thunkArg };
+		type->GetMemberMethod("GetTest"_nv, { typeof(int) })->GetThunk()(&UnboxedFoo, thunkArgs, &thunkResult);
+		std::wcout << thunkResult << std::endl;
+
+		// 返回右值引用的方法的thunk写入被引用对象的地址
+		int* movedTest;
+		type->GetMemberMethod("MoveTest"_nv, {})->GetThunk()(&UnboxedFoo, nullptr, &movedTest);
+		std::wcout << (movedTest == &UnboxedFoo.GetTest()) << std::endl;
+
 		auto type2 = typeofname("Bar"_nv);
 		auto pBar = type2->Construct({ 1 });
-		std::wcout << type2->InvokeMember(pBar, "Test"_nv, {})->ToString() << std::endl << std::endl;
+		std::wcout << type2->InvokeMember(pBar, "Test"_nv, {})->ToString() << std::endl;
+		std::wcout << type->InvokeVirtual(pBar, type->GetVirtualSlot("Test"_nv, {}), {})->ToString() << std::endl;
+		try
+		{
+			// 与Foo无关的对象不能以Foo的槽位调用
+			type->InvokeVirtual(Object::Box(1), type->GetVirtualSlot("Test"_nv, {}), {});
+		}
+		catch (ReflectionException& e)
+		{
+			std::wcout << e.GetDesc() << std::endl;
+		}
+		std::wcout << std::endl;
 
 		natFileStream a{ "main.cpp"_nv, false, false };
 		type2->InvokeMember(pBar, "BoxedTest"_nv, { natRefPointer<natStream>{ &a } });
@@ -185,6 +488,627 @@ int main()
 
 		std::wcout << typeof(RefString)->Construct({ "Test!"_nv })->ToString() << std::endl;
 
+		std::wcout << type->CopyConstruct(pFoo)->Unbox<Foo>().GetTest() << std::endl;
+
+		// 构造函数仅存放于构造函数表中，仍可按名称调用及查找
+		std::wcout << type->InvokeNonMember("Constructor"_nv, { 2 })->Unbox<Foo>().GetTest() << " " << type->Construct({ 3 })->Unbox<Foo>().GetTest() << " "
+			<< (type->GetNonMemberMethod("Constructor"_nv, { typeof(int) }).Get() == type->GetConstructor({ typeof(int) }).Get()) << std::endl;
+
+		{
+			auto batch = type->ConstructBatch(4, { 5 });
+			auto kept = batch->Get(3);
+			batch->Clear();
+			std::wcout << batch->Size() << " " << kept->Unbox<Foo>().GetTest() << std::endl;
+		}
+#ifdef REFLECTION_TEST_BENCHMARKS
+		ConstructionBenchmark(type);
+#endif
+
+		std::wcout << "Box : " << Benchmark(1000000, [] { Object::Box(1); }) << " ms" << std::endl;
+		{
+			// 由其他线程装箱的对象在其线程退出后释放
+			natRefPointer<Object> boxed;
+			std::thread{ [&] { boxed = Object::Box(1.0); } }.join();
+			std::wcout << boxed->ToString() << std::endl;
+		}
+		std::wcout << "InvokeMember : " << Benchmark(1000000, [&] { type->InvokeMember(pFoo, "GetTest"_nv, { 1 }); }) << " ms" << std::endl;
+		{
+			// 作用域内的临时对象随作用域整块回收，逃逸的返回值保持其所在的块存活
+			// escaped在arena之后析构，其所在的块比区域存活更久
+			natRefPointer<Object> escaped;
+			ScratchArena arena;
+			{
+				ScratchScope scope{ arena };
+				for (int i = 0; i < 100; ++i)
+				{
+					type->InvokeMember(pFoo, "GetTest"_nv, { i });
+				}
+			}
+			{
+				ScratchScope scope{ arena };
+				escaped = type->InvokeMember(pFoo, "GetTest"_nv, { 1 });
+			}
+			std::wcout << escaped->ToString() << " " << arena.GetChunkCount() << " " << arena.GetEscapedChunkCount() << std::endl;
+		}
+		for (auto&& counterType : { typeof(Counter), typeof(BiasedCounter) })
+		{
+			auto counter = counterType->Construct({ 1 });
+			std::wcout << counterType->GetName() << " InvokeMember : " << Benchmark(1000000, [&] { counterType->InvokeMember(counter, "Get"_nv, {}); }) << " ms" << std::endl;
+			std::wcout << counterType->GetName() << " ReadMemberField : " << Benchmark(1000000, [&] { counterType->ReadMemberField(counter, "m_Value"_nv); }) << " ms" << std::endl;
+		}
+		{
+			auto counter = typeof(Counter)->Construct({ 3 });
+			FieldRef<int> value{ typeof(Counter)->GetMemberField("m_Value"_nv) };
+			value(counter) += 1;
+			std::wcout << counter->Unbox<Counter>().Get() << std::endl;
+			int sum = 0;
+			std::wcout << "FieldRef : " << Benchmark(1000000, [&] { sum += value(counter); }) << " ms" << std::endl;
+			std::wcout << sum << std::endl;
+		}
+		{
+			// 虚继承于Object的类型无法使用固定偏移
+			struct VirtualDerived
+				: virtual Object
+			{
+				int m_Value;
+			};
+			const auto field = make_ref<MemberField<int(VirtualDerived::*)>>(AccessSpecifier::AccessSpecifier_public, &VirtualDerived::m_Value);
+			std::wcout << field->GetOffset() << " " << typeof(Counter)->GetMemberField("m_Value"_nv)->GetOffset() << std::endl;
+		}
+		{
+			Record record{ type2->GetRecordLayout(), pBar.Get() };
+			type2->InvokeMember(pBar, "Test"_nv, {});
+			Record modified{ type2->GetRecordLayout(), pBar.Get() };
+			std::wcout << type2->GetRecordLayout()->GetField(record.Diff(modified).at(0)).Name << std::endl;
+			record.Apply(pBar.Get());
+			std::wcout << static_cast<natRefPointer<Bar>>(pBar)->GetTest() << std::endl;
+			try
+			{
+				record.Apply(typeof(Counter)->Construct({ 1 }).Get());
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			std::vector<natRefPointer<Object>> counters;
+			for (int i = 0; i < 1000000; ++i)
+			{
+				counters.emplace_back(typeof(Counter)->Construct({ i }));
+			}
+			const auto field = typeof(Counter)->GetMemberField("m_Value"_nv);
+			std::vector<int> column(counters.size());
+			long long boxedSum = 0, columnSum = 0;
+			std::wcout << "ReadFrom loop : " << Benchmark(1, [&] { for (auto&& item : counters) boxedSum += field->ReadFrom(item)->Unbox<int>(); }) << " ms" << std::endl;
+			std::wcout << "Gather : " << Benchmark(1, [&] { field->Gather(counters.data(), counters.size(), column.data()); for (auto value : column) columnSum += value; }) << " ms" << std::endl;
+			std::wcout << boxedSum << " " << columnSum << std::endl;
+			for (auto& value : column)
+			{
+				value = -value;
+			}
+			field->Scatter(counters.data(), counters.size(), column.data());
+			std::wcout << counters[1]->Unbox<Counter>().Get() << std::endl;
+
+			// 比较标量实现与宿主CPU支持的最高级别
+			const FieldColumn values{ typeof(Counter), "m_Value"_nv, counters };
+			for (const auto level : { SimdLevel::Scalar, ColumnKernels::GetSupportedSimdLevel() })
+			{
+				ColumnKernels::SetSimdLevel(level);
+				long long sum = 0;
+				size_t count = 0, selected = 0;
+				const auto time = Benchmark(100, [&]
+				{
+					sum = values.Sum<long long>();
+					count = values.Count(CompareOp::Greater, -500000);
+					selected = values.Filter(CompareOp::LessEqual, -999990).size();
+				});
+				std::wcout << "SimdLevel " << static_cast<int>(level) << " : " << time << " ms, sum " << sum << ", min " << values.Min<int>() << ", max " << values.Max<int>()
+					<< ", count " << count << ", selected " << selected << std::endl;
+			}
+
+			// 逐个对象读取装箱字段与编译后的查询比较
+			size_t boxedCount = 0;
+			std::wcout << "ReadMemberField filter : " << Benchmark(1, [&]
+			{
+				for (auto&& item : counters)
+				{
+					const auto value = typeof(Counter)->ReadMemberField(item, "m_Value"_nv)->Unbox<int>();
+					boxedCount += value > -300000 && value % 2 == 0;
+				}
+			}) << " ms" << std::endl;
+			const auto query = Query{ typeof(Counter) }
+				.Where("m_Value"_nv, CompareOp::Greater, -300000)
+				.Where<int>("m_Value"_nv, [](int value) { return value % 2 == 0; })
+				.Select("m_Value"_nv);
+			for (const auto parallel : { false, true })
+			{
+				std::unique_ptr<QueryResult> result;
+				const auto time = Benchmark(1, [&] { result = std::make_unique<QueryResult>(query.Execute(counters, parallel)); });
+				std::wcout << "Query" << (parallel ? " (parallel)" : "") << " : " << time << " ms, " << result->GetSize() << " of " << boxedCount
+					<< ", min " << result->GetColumn("m_Value"_nv).Min<int>() << std::endl;
+			}
+			try
+			{
+				query.Execute(std::vector<natRefPointer<Object>>{ counters.front(), Object::Box(1) });
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			const auto sample = typeof(Sample)->Construct({ 1, 2.0 });
+			const auto& typed = static_cast<natRefPointer<Sample>>(sample);
+			const auto clone = Memberwise::Clone(sample);
+			std::wcout << std::boolalpha << Memberwise::Equals(sample.Get(), clone.Get()) << " " << (Memberwise::Hash(sample.Get()) == Memberwise::Hash(clone.Get()))
+				<< " " << (static_cast<natRefPointer<Sample>>(clone)->m_Counter != typed->m_Counter) << std::endl;
+			static_cast<natRefPointer<Sample>>(clone)->m_Counter->m_Value = 5;
+			std::wcout << Memberwise::Equals(sample.Get(), clone.Get()) << std::endl;
+
+			size_t equalCount = 0, hashSum = 0;
+			std::wcout << "Memberwise Equals/Hash/Clone : " << Benchmark(100000, [&]
+			{
+				equalCount += Memberwise::Equals(sample.Get(), clone.Get());
+				hashSum += Memberwise::Hash(sample.Get());
+				Memberwise::Clone(sample);
+			}) << " ms" << std::endl;
+			std::wcout << "Hand-written Equals/Hash/Clone : " << Benchmark(100000, [&]
+			{
+				equalCount += HandWrittenEquals(*typed, *static_cast<natRefPointer<Sample>>(clone));
+				hashSum += HandWrittenHash(*typed);
+				HandWrittenClone(*typed);
+			}) << " ms" << std::endl;
+			std::wcout << equalCount << std::endl;
+		}
+		{
+			// 自环A→A与环B1→B2→B1相等，哈希值也应相同
+			const auto a = make_ref<Node>(1);
+			a->m_Next = a;
+			const auto b1 = make_ref<Node>(1), b2 = make_ref<Node>(1);
+			b1->m_Next = b2;
+			b2->m_Next = b1;
+			std::wcout << Memberwise::Equals(a.Get(), b1.Get()) << " " << (Memberwise::Hash(a.Get()) == Memberwise::Hash(b1.Get())) << std::endl;
+			a->m_Next = nullptr;
+			b1->m_Next = nullptr;
+		}
+		{
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			{
+				BinaryWriter writer{ stream };
+				writer.Write(typeof(Sample)->Construct({ 3, 4.5 }));
+				writer.Write(Object::Box(42));
+				writer.Write(Object::Box(nString{ "RefString"_nv }));
+				writer.Write({});
+			}
+			stream->SetPosition(NatSeek::Beg, 0);
+			BinaryReader reader{ stream };
+			const auto sample = reader.Read();
+			std::wcout << std::boolalpha << Memberwise::Equals(sample.Get(), typeof(Sample)->Construct({ 3, 4.5 }).Get()) << " "
+				<< reader.Read()->Unbox<int>() << " " << reader.Read()->Unbox<nString>() << " " << !reader.Read() << std::endl;
+		}
+		{
+			// 共享同一Counter的对象，保留引用时Counter只编码一次，读取后仍然共享
+			const auto shared = make_ref<Counter>(9);
+			std::vector<natRefPointer<Sample>> samples;
+			for (int i = 0; i < 100; ++i)
+			{
+				samples.emplace_back(make_ref<Sample>(i, i * 0.5));
+				samples.back()->m_Counter = shared;
+			}
+
+			const auto write = [&](ReferenceHandling referenceHandling)
+			{
+				const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+				BinaryWriter writer{ stream, referenceHandling };
+				for (auto&& item : samples)
+				{
+					writer.Write(item);
+				}
+				writer.Flush();
+				stream->SetPosition(NatSeek::Beg, 0);
+				return stream;
+			};
+
+			const auto stream = write(ReferenceHandling::Preserve);
+			BinaryReader reader{ stream, ReferenceHandling::Preserve };
+			const natRefPointer<Sample> first = reader.Read(), second = reader.Read();
+			std::wcout << write(ReferenceHandling::Duplicate)->GetSize() << " -> " << stream->GetSize() << " " << std::boolalpha
+				<< (first->m_Counter == second->m_Counter && first->m_Counter->m_Value == 9) << std::endl;
+		}
+		{
+			constexpr size_t sampleCount = 100000;
+			std::vector<natRefPointer<Object>> samples;
+			samples.reserve(sampleCount);
+			for (size_t i = 0; i < sampleCount; ++i)
+			{
+				samples.emplace_back(typeof(Sample)->Construct({ static_cast<int>(i), i * 0.5 }));
+			}
+
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			const auto writeTime = Benchmark(1, [&]
+			{
+				BinaryWriter writer{ stream };
+				for (auto&& item : samples)
+				{
+					writer.Write(item);
+				}
+			});
+			const auto size = stream->GetSize();
+			stream->SetPosition(NatSeek::Beg, 0);
+			size_t equalCount = 0;
+			const auto readTime = Benchmark(1, [&]
+			{
+				BinaryReader reader{ stream };
+				for (auto&& item : samples)
+				{
+					equalCount += static_cast<natRefPointer<Sample>>(reader.Read())->m_Id == static_cast<natRefPointer<Sample>>(item)->m_Id;
+				}
+			});
+			const auto megabytes = static_cast<double>(size) / (1024 * 1024);
+			std::wcout << "BinaryWriter : " << writeTime << " ms, " << megabytes * 1000 / std::max<long long>(writeTime, 1) << " MB/s" << std::endl;
+			std::wcout << "BinaryReader : " << readTime << " ms, " << megabytes * 1000 / std::max<long long>(readTime, 1) << " MB/s, " << equalCount << " of " << sampleCount << std::endl;
+		}
+		{
+			constexpr size_t sampleCount = 400000;
+			std::vector<natRefPointer<Object>> samples;
+			samples.reserve(sampleCount);
+			for (size_t i = 0; i < sampleCount; ++i)
+			{
+				samples.emplace_back(typeof(Sample)->Construct({ static_cast<int>(i), i * 0.5 }));
+			}
+
+			// 分块仅取决于块大小，串行与并行的输出应完全一致
+			const auto serialStream = make_ref<natMemoryStream>(nullptr, 0, true, true, true), parallelStream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			const auto serialWriteTime = Benchmark(1, [&] { ChunkedSerialization::Write(serialStream, samples, ChunkedSerialization::DefaultChunkSize, ReferenceHandling::Duplicate, false); });
+			const auto parallelWriteTime = Benchmark(1, [&] { ChunkedSerialization::Write(parallelStream, samples); });
+			const auto identical = serialStream->GetSize() == parallelStream->GetSize() &&
+				std::equal(serialStream->GetInternalBuffer(), serialStream->GetInternalBuffer() + serialStream->GetSize(), parallelStream->GetInternalBuffer());
+
+			std::vector<natRefPointer<Object>> serialResult, parallelResult;
+			serialStream->SetPosition(NatSeek::Beg, 0);
+			parallelStream->SetPosition(NatSeek::Beg, 0);
+			const auto serialReadTime = Benchmark(1, [&] { serialResult = ChunkedSerialization::Read(serialStream, false); });
+			const auto parallelReadTime = Benchmark(1, [&] { parallelResult = ChunkedSerialization::Read(parallelStream); });
+			size_t equalCount = 0;
+			for (size_t i = 0; i < sampleCount && i < parallelResult.size(); ++i)
+			{
+				equalCount += Memberwise::Equals(parallelResult[i].Get(), samples[i].Get());
+			}
+			std::wcout << "Chunked write : " << serialWriteTime << " ms serial, " << parallelWriteTime << " ms parallel, " << std::boolalpha << identical << std::endl;
+			std::wcout << "Chunked read : " << serialReadTime << " ms serial, " << parallelReadTime << " ms parallel, " << equalCount << " of " << sampleCount << std::endl;
+		}
+		{
+			constexpr size_t sampleCount = 100000;
+			ViewWriter writer;
+			for (size_t i = 0; i < sampleCount; ++i)
+			{
+				writer.Add(typeof(Sample)->Construct({ static_cast<int>(i), i * 0.5 }));
+			}
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			writer.Finish(stream);
+
+			// 直接读取流的内部缓冲区，不创建任何对象
+			const auto buffer = make_ref<ViewBuffer>(stream);
+			const auto first = buffer->GetRoot(1);
+			const auto idIndex = first.GetFieldIndex("m_Id"_nv), counterIndex = first.GetFieldIndex("m_Counter"_nv);
+			std::wcout << first.Read<int>(idIndex) << " " << first.Read<double>("m_Weight"_nv) << " " << first.ReadString("m_Name"_nv) << " "
+				<< first.ReadObject(counterIndex).Read<int>("m_Value"_nv) << " " << std::boolalpha
+				<< Memberwise::Equals(first.Construct().Get(), typeof(Sample)->Construct({ 1, 0.5 }).Get()) << std::endl;
+
+			long long sum = 0;
+			std::wcout << "ObjectView scan : " << Benchmark(1, [&]
+			{
+				for (size_t i = 0; i < buffer->GetRootCount(); ++i)
+				{
+					const auto view = buffer->GetRoot(i);
+					sum += view.Read<int>(idIndex) + view.ReadObject(counterIndex).Read<int>(0);
+				}
+			}) << " ms, " << sum << std::endl;
+
+			// 修改第一个类型的布局签名，模拟由字段不同的版本写入的缓冲区
+			std::vector<nByte> altered(stream->GetInternalBuffer(), stream->GetInternalBuffer() + stream->GetSize());
+			std::uint32_t typeTable, nameLength;
+			std::memcpy(&typeTable, altered.data() + 2 * sizeof(std::uint32_t), sizeof typeTable);
+			std::memcpy(&nameLength, altered.data() + typeTable + sizeof(std::uint32_t), sizeof nameLength);
+			altered[typeTable + 3 * sizeof(std::uint32_t) + nameLength] ^= 1;
+			try
+			{
+				make_ref<ViewBuffer>(altered.data(), altered.size());
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			{
+				JsonWriter writer{ stream };
+				auto sample = typeof(Sample)->Construct({ 7, 0.1 });
+				static_cast<natRefPointer<Sample>>(sample)->m_Name = "\"Quoted\"\n"_nv;
+				writer.Write(sample);
+				writer.Write(Object::Box(42));
+			}
+			std::wcout << nStrView{ reinterpret_cast<const char*>(stream->GetInternalBuffer()), static_cast<size_t>(stream->GetSize()) } << std::endl;
+			stream->SetPosition(NatSeek::Beg, 0);
+			JsonReader reader{ stream };
+			const auto sample = reader.Read(typeof(Sample));
+			std::wcout << std::boolalpha << (static_cast<natRefPointer<Sample>>(sample)->m_Name == "\"Quoted\"\n"_nv) << " "
+				<< reader.Read(typeof(int))->Unbox<int>() << " " << reader.IsEnd() << std::endl;
+
+			// 未知的键被跳过，仅出现的字段被标记为已修改
+			auto point = typeof(TrackedPoint)->Construct({ 1, 2 });
+			JsonReader{ R"({ "m_Y": -3, "extra": [1, {"a": "\u00e9"}, null] })"_nv }.ReadInto(point);
+			std::wcout << static_cast<natRefPointer<TrackedPoint>>(point)->m_Y << " " << DirtyTracking::GetDirtyFields(point.Get()).size() << std::endl;
+
+			// 超出double范围的数字不会被存储为inf
+			try
+			{
+				JsonReader{ R"({ "m_Weight": 1e999 })"_nv }.ReadInto(sample);
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << " " << static_cast<natRefPointer<Sample>>(sample)->m_Weight << std::endl;
+			}
+		}
+		{
+			// 超出读取窗口的字符串及跨越窗口边界的转义和数字
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			nString name;
+			for (size_t i = 0; i < JsonReader::BufferSize / 4; ++i)
+			{
+				name.Append("ab\\\t"_nv);
+			}
+			{
+				JsonWriter writer{ stream };
+				for (int i = 0; i < 3; ++i)
+				{
+					auto sample = typeof(Sample)->Construct({ i, i + 0.125 });
+					static_cast<natRefPointer<Sample>>(sample)->m_Name = name;
+					writer.Write(sample);
+				}
+			}
+			stream->SetPosition(NatSeek::Beg, 0);
+			JsonReader reader{ stream };
+			size_t equalCount = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				const natRefPointer<Sample> sample = reader.Read(typeof(Sample));
+				equalCount += sample->m_Id == i && sample->m_Weight == i + 0.125 && sample->m_Name == name;
+			}
+			std::wcout << equalCount << " " << std::boolalpha << reader.IsEnd() << " " << (reader.GetPosition() == stream->GetSize()) << std::endl;
+		}
+		{
+			constexpr size_t sampleCount = 100000;
+			std::vector<natRefPointer<Object>> samples;
+			samples.reserve(sampleCount);
+			for (size_t i = 0; i < sampleCount; ++i)
+			{
+				samples.emplace_back(typeof(Sample)->Construct({ static_cast<int>(i), i * 0.25 }));
+			}
+
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			const auto writeTime = Benchmark(1, [&]
+			{
+				JsonWriter writer{ stream };
+				for (auto&& item : samples)
+				{
+					writer.Write(item);
+				}
+			});
+			const auto megabytes = static_cast<double>(stream->GetSize()) / (1024 * 1024);
+			stream->SetPosition(NatSeek::Beg, 0);
+			size_t equalCount = 0;
+			const auto readTime = Benchmark(1, [&]
+			{
+				JsonReader reader{ stream };
+				const auto type = typeof(Sample);
+				for (auto&& item : samples)
+				{
+					equalCount += Memberwise::Equals(reader.Read(type).Get(), item.Get());
+				}
+			});
+			std::wcout << "JsonWriter : " << writeTime << " ms, " << megabytes * 1000 / std::max<long long>(writeTime, 1) << " MB/s" << std::endl;
+			std::wcout << "JsonReader : " << readTime << " ms, " << megabytes * 1000 / std::max<long long>(readTime, 1) << " MB/s, " << equalCount << " of " << sampleCount << std::endl;
+		}
+		{
+			const auto stream = make_ref<natMemoryStream>(nullptr, 0, true, true, true);
+			{
+				TaggedWriter writer{ stream };
+				auto v2 = make_ref<SettingsV2>();
+				v2->m_Name = "New"_nv;
+				v2->m_Height = 1080;
+				v2->m_Scale = 1.5;
+				v2->m_Counter = make_ref<Counter>(3);
+				writer.Write(v2);
+
+				auto v1 = make_ref<SettingsV1>();
+				v1->m_Name = "Old"_nv;
+				v1->m_Width = 800;
+				v1->m_Comment = "Not persisted"_nv;
+				writer.Write(v1);
+			}
+			stream->SetPosition(NatSeek::Beg, 0);
+			TaggedReader reader{ stream };
+			// 新版本的数据以旧版本读取时跳过未知的字段，旧版本的数据以新版本读取时缺少的字段保持默认值
+			const natRefPointer<SettingsV1> v1 = reader.Read(typeof(SettingsV1));
+			std::wcout << v1->m_Name << " " << v1->m_Width << "x" << v1->m_Height << std::endl;
+			const natRefPointer<SettingsV2> v2 = reader.Read(typeof(SettingsV2));
+			std::wcout << v2->m_Name << " " << v2->m_Width << "x" << v2->m_Height << " " << v2->m_Scale << " " << std::boolalpha << !v2->m_Counter << std::endl;
+			std::wcout << "Tagged size : " << stream->GetSize() << std::endl;
+		}
+		{
+			const auto pointType = typeof(TrackedPoint);
+			auto point = pointType->Construct({ 1, 2 });
+			pointType->WriteMemberField(point, "m_Y"_nv, Object::Box(5));
+			std::wcout << DirtyTracking::GetDirtyFields(point.Get()).size() << std::endl;
+			DirtyTracking::Clear(point.Get());
+			static_cast<natRefPointer<TrackedPoint>>(point)->SetX(3);
+			// 仅发送已修改的字段
+			for (const auto index : DirtyTracking::TakeDirtyFields(point.Get()))
+			{
+				auto const& entry = pointType->GetRecordLayout()->GetField(index);
+				std::wcout << entry.Name << " = " << entry.Field->ReadFrom(point)->ToString() << std::endl;
+			}
+			std::wcout << DirtyTracking::GetDirtyFields(point.Get()).size() << std::endl;
+		}
+		{
+			std::vector<natRefPointer<Object>> values;
+			for (int i = 0; i < 100000; ++i)
+			{
+				values.emplace_back(Object::Box(i * 7919 - 500000));
+				values.emplace_back(Object::Box(i * 0.125));
+			}
+
+			size_t toStringSize = 0;
+			const auto toStringTime = Benchmark(10, [&]
+			{
+				for (auto&& value : values)
+				{
+					toStringSize += value->ToString().size();
+				}
+			});
+
+			// 所有值追加到同一缓冲区，缓冲区增长后不再分配
+			nString buffer;
+			const auto appendTime = Benchmark(10, [&]
+			{
+				for (auto&& value : values)
+				{
+					value->AppendString(buffer);
+					buffer.Append(" "_nv);
+				}
+			});
+			std::wcout << "ToString : " << toStringTime << " ms, AppendString : " << appendTime << " ms, "
+				<< std::boolalpha << (buffer.size() == toStringSize + values.size() * 10) << std::endl;
+
+			// 字符直接编码追加，结果与ToString相同
+			for (auto&& value : { Object::Box('a'), Object::Box(L'\u00e9'), Object::Box(L'\u4e2d') })
+			{
+				nString appended;
+				value->AppendString(appended);
+				std::wcout << (appended == value->ToString()) << " ";
+			}
+			std::wcout << std::endl;
+		}
+		{
+			std::wcout << typeof(int)->Parse("-42"_nv)->ToString() << " " << typeof(double)->Parse("1.5e3"_nv)->ToString() << " " << typeof(bool)->Parse("true"_nv)->ToString() << std::endl;
+			// 字符串转换为基本类型时直接解析
+			std::wcout << Convert::ConvertTo<std::uint8_t>(Object::Box(nString{ "255"_nv }))->ToString() << std::endl;
+			{
+				const nString number{ "2.5"_nv };
+				BoxedReferenceScope<nStrView> view{ number.GetView() };
+				std::wcout << Convert::ConvertTo<double>(view.Get())->ToString() << std::endl;
+			}
+			try
+			{
+				typeof(std::int8_t)->Parse("128"_nv);
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			nString text;
+			for (int i = 0; i < 100000; ++i)
+			{
+				text.Append("line\n"_nv);
+			}
+
+			const auto statsType = typeof(TextStats);
+			size_t length = 0;
+			// Box复制整个字符串，RefStringView仅引用调用方的字符串
+			const auto boxTime = Benchmark(10000, [&] { length += statsType->InvokeNonMember("FirstLineLength"_nv, { Object::Box(text.GetView()) })->Unbox<size_t>(); });
+			const auto viewTime = Benchmark(10000, [&] { BoxedReferenceScope<nStrView> view{ text.GetView() }; length += statsType->InvokeNonMember("FirstLineLength"_nv, { view.Get() })->Unbox<size_t>(); });
+			std::wcout << "FirstLineLength (Box) : " << boxTime << " ms, (RefStringView) : " << viewTime << " ms, " << length << std::endl;
+
+			natRefPointer<Object> escaped;
+			{
+				nString temporary{ "view"_nv };
+				BoxedReferenceScope<nStrView> view{ temporary.GetView() };
+				std::wcout << statsType->InvokeNonMember("Length"_nv, { view.Get() })->ToString() << std::endl;
+				escaped = view.Get();
+			}
+			try
+			{
+				statsType->InvokeNonMember("Length"_nv, { escaped });
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			Reflection::GetInstance().RegisterMemberMethod<haha>(AccessSpecifier::AccessSpecifier_public, false, "Add"_nv, &haha::Add);
+			const auto hahaType = typeof(haha);
+			const auto add = hahaType->GetMemberMethod("Add"_nv, { typeof(int) });
+
+			// 就地调用数组元素的方法，无需移入装箱对象再移回
+			haha values[4]{};
+			natRefPointer<Object> escaped;
+			for (int i = 0; i < 4; ++i)
+			{
+				BoxedReferenceScope<haha> scope{ values[i] };
+				add->Invoke(scope.Get(), { i + 1 });
+				hahaType->InvokeMember(scope.Get(), "Add"_nv, { 10 });
+				escaped = scope.Get();
+			}
+			std::wcout << values[0].a << " " << values[1].a << " " << values[2].a << " " << values[3].a << std::endl;
+
+			try
+			{
+				escaped->Unbox<haha>();
+			}
+			catch (ReflectionException& e)
+			{
+				std::wcout << e.GetDesc() << std::endl;
+			}
+		}
+		{
+			// haha以BoxedValue装箱，值存放于对象内且对象记录其IType
+			auto boxed = Object::Box(haha{ 5 });
+			typeof(haha)->InvokeMember(boxed, "Add"_nv, { 2 });
+			const auto copy = typeof(haha)->CopyConstruct(boxed);
+			std::wcout << boxed->GetType()->GetName() << " " << boxed->Unbox<haha>().a << " " << copy->Unbox<haha>().a << " "
+				<< std::boolalpha << (BoxedValue::From(boxed.Get())->As<haha>() != nullptr) << std::endl;
+			{
+				// 引用已存在的值的BoxedReference同样是BoxedValue，其数据即被引用的值
+				haha value{ 3 };
+				BoxedReferenceScope<haha> scope{ value };
+				const auto reference = scope.Get();
+				std::wcout << (BoxedValue::From(reference.Get())->As<haha>() == &value) << " " << (BoxedValue::From(Object::Box(1).Get()) == nullptr) << std::endl;
+			}
+
+			// 限定名的类型同样可以注册
+			const auto point = typeof(Geometry::Point)->Construct({ Geometry::Point{ 1, 2 } });
+			std::wcout << point->GetType()->GetName() << " " << point->Unbox<Geometry::Point>().Y << std::endl;
+
+#ifdef REFLECTION_TEST_BENCHMARKS
+			int sum = 0;
+			std::wcout << "Box(haha) : " << Benchmark(1000000, [&] { sum += Object::Box(haha{ sum & 7 })->Unbox<haha>().a; }) << " ms" << std::endl;
+#endif
+		}
+		{
+			// 在其他线程释放偏向引用，由所有者线程合并
+			auto counter = typeof(BiasedCounter)->Construct({ 2 });
+			std::thread{ [moved = std::move(counter)]() mutable { moved = {}; } }.join();
+			BiasedRefCount::Collect();
+
+			// 线程退出后创建的对象没有所有者
+			struct ConstructOnExit
+			{
+				~ConstructOnExit()
+				{
+					typeof(BiasedCounter)->Construct({ 3 });
+				}
+			};
+			std::thread{ [] { thread_local ConstructOnExit onExit; static_cast<void>(onExit); typeof(BiasedCounter)->Construct({ 1 }); } }.join();
+		}
+		const auto statistics = ObjectPool::GetThreadPool()->GetStatistics(ObjectPool::GetSizeClass(sizeof(BoxedObject<int>)));
+		std::wcout << "Pool block " << statistics.BlockSize << " : allocated " << statistics.AllocationCount << ", live " << statistics.LiveCount << ", slabs " << statistics.SlabCount << std::endl;
+
 		// Benchmark
 		/*auto Test = type2->GetMemberMethod("Test"_nv, {});
 		ArgumentPack args{};